@@ -0,0 +1,391 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+// Offline denoiser benchmark. Loads beauty (and optionally albedo and normal)
+// EXRs saved from a render, runs them through every denoiser mode and buffer
+// combination at a range of resolutions and thread counts, and reports
+// timings, peak memory and error against a high sample count reference.
+
+#include <mcrt_denoise/denoiser/Denoiser.h>
+#include <scene_rdl2/render/util/Args.h>
+
+#include <OpenImageIO/imagebuf.h>
+#include <OpenImageIO/imagebufalgo.h>
+
+#include <tbb/global_control.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const char *sUsage = R"(
+Usage: moonray_denoise_bench -beauty <exr> -reference <exr> [options]
+
+  -beauty <exr>        noisy beauty image
+  -albedo <exr>        denoiser albedo input, enables the beauty+albedo runs
+  -normal <exr>        denoiser normal input, enables the beauty+albedo+normals runs
+  -reference <exr>     high sample count image to measure error against
+  -scales <list>       comma separated resolution scales (default 1)
+  -threads <list>      comma separated thread counts, 0 for all cores (default 0)
+  -runs <n>            timed denoise calls per configuration (default 3)
+  -csv <file>          also write the results to a csv file
+)";
+
+struct DenoiserModeInfo
+{
+    moonray::denoiser::DenoiserMode mMode;
+    const char *mName;
+};
+
+const DenoiserModeInfo sDenoiserModes[] = {
+    { moonray::denoiser::OPTIX,                   "optix"    },
+    { moonray::denoiser::OPEN_IMAGE_DENOISE,      "oidn"     },
+    { moonray::denoiser::OPEN_IMAGE_DENOISE_CPU,  "oidn_cpu" },
+    { moonray::denoiser::OPEN_IMAGE_DENOISE_CUDA, "oidn_cuda"},
+};
+
+// Mirrors the buffer combinations the GUI offers.
+enum BufferMode
+{
+    BUFFERS_BEAUTY,
+    BUFFERS_BEAUTY_ALBEDO,
+    BUFFERS_BEAUTY_ALBEDO_NORMALS,
+    NUM_BUFFER_MODES
+};
+
+const char *sBufferModeNames[NUM_BUFFER_MODES] = {
+    "beauty",
+    "beauty+albedo",
+    "beauty+albedo+normals",
+};
+
+// RGBA float pixels, as the denoiser expects them.
+struct Image
+{
+    int mWidth = 0;
+    int mHeight = 0;
+    std::vector<float> mPixels;
+};
+
+struct Inputs
+{
+    Image mBeauty;
+    Image mAlbedo;
+    Image mNormal;
+    Image mReference;
+};
+
+struct Error
+{
+    double mRmse;
+    double mRelMse;
+};
+
+struct Result
+{
+    std::string mDenoiser;
+    std::string mBuffers;
+    int mWidth;
+    int mHeight;
+    int mThreads;
+    double mCreateMs;
+    double mDenoiseMs;
+    long mPeakRssKb;
+    Error mError;
+};
+
+bool
+loadImage(const std::string &path, OIIO::ImageBuf *dst)
+{
+    OIIO::ImageBuf buf(path);
+    if (!buf.read(0, 0, true, OIIO::TypeDesc::FLOAT)) {
+        std::cerr << "Error reading " << path << ": " << buf.geterror() << std::endl;
+        return false;
+    }
+
+    // Denoiser inputs are always four channels, fill in alpha if needed.
+    const int nchannels = buf.nchannels();
+    if (nchannels < 3) {
+        std::cerr << "Error reading " << path << ": expected at least 3 channels, found "
+                  << nchannels << std::endl;
+        return false;
+    }
+    const int channelOrder[] = { 0, 1, 2, nchannels > 3 ? 3 : -1 };
+    const float channelValues[] = { 0.f, 0.f, 0.f, 1.f };
+    *dst = OIIO::ImageBufAlgo::channels(buf, 4, channelOrder, channelValues);
+    if (dst->has_error()) {
+        std::cerr << "Error reading " << path << ": " << dst->geterror() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+Image
+resizeImage(const OIIO::ImageBuf &src, int w, int h)
+{
+    Image image;
+    image.mWidth = w;
+    image.mHeight = h;
+    image.mPixels.resize(size_t(w) * size_t(h) * 4);
+
+    const OIIO::ROI roi(0, w, 0, h, 0, 1, 0, 4);
+    if (src.spec().width == w && src.spec().height == h) {
+        src.get_pixels(roi, OIIO::TypeDesc::FLOAT, image.mPixels.data());
+    } else {
+        OIIO::ImageBuf resized = OIIO::ImageBufAlgo::resize(src, "", 0.f, roi);
+        resized.get_pixels(roi, OIIO::TypeDesc::FLOAT, image.mPixels.data());
+    }
+    return image;
+}
+
+// Errors are measured over the color channels only. relMSE normalizes by the
+// reference so dark and bright regions count equally.
+Error
+computeError(const std::vector<float> &image, const Image &reference)
+{
+    double sumSq = 0.0;
+    double sumRel = 0.0;
+    const size_t numPixels = size_t(reference.mWidth) * size_t(reference.mHeight);
+    for (size_t i = 0; i < numPixels; ++i) {
+        for (int c = 0; c < 3; ++c) {
+            const double ref = reference.mPixels[i * 4 + c];
+            const double diff = double(image[i * 4 + c]) - ref;
+            sumSq += diff * diff;
+            sumRel += diff * diff / (ref * ref + 0.01);
+        }
+    }
+    const double n = double(numPixels * 3);
+    return Error{ std::sqrt(sumSq / n), sumRel / n };
+}
+
+// Resets the peak resident set size so that the next getPeakRssKb() call
+// reports the peak since now. Only supported on Linux.
+void
+resetPeakRss()
+{
+    std::ofstream clearRefs("/proc/self/clear_refs");
+    if (clearRefs) {
+        clearRefs << "5";
+    }
+}
+
+long
+getPeakRssKb()
+{
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, 6, "VmHWM:") == 0) {
+            return std::stol(line.substr(6));
+        }
+    }
+    return -1;
+}
+
+double
+elapsedMs(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+std::vector<std::string>
+splitList(const std::string &str)
+{
+    std::vector<std::string> items;
+    std::stringstream ss(str);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+bool
+runConfig(const DenoiserModeInfo &modeInfo, BufferMode bufferMode, const Inputs &inputs,
+          int threads, int runs, Result *result)
+{
+    const int w = inputs.mBeauty.mWidth;
+    const int h = inputs.mBeauty.mHeight;
+    const bool useAlbedo = bufferMode != BUFFERS_BEAUTY;
+    const bool useNormals = bufferMode == BUFFERS_BEAUTY_ALBEDO_NORMALS;
+
+    std::vector<float> output(inputs.mBeauty.mPixels.size());
+
+    resetPeakRss();
+
+    auto start = std::chrono::steady_clock::now();
+    std::string errorMsg;
+    moonray::denoiser::Denoiser denoiser(modeInfo.mMode, w, h, useAlbedo, useNormals, &errorMsg);
+    const double createMs = elapsedMs(start);
+    if (!errorMsg.empty()) {
+        std::cerr << "Skipping " << modeInfo.mName << ": " << errorMsg << std::endl;
+        return false;
+    }
+
+    // The first call pays for any lazy initialization, so it is not timed.
+    const float *albedo = useAlbedo ? inputs.mAlbedo.mPixels.data() : nullptr;
+    const float *normal = useNormals ? inputs.mNormal.mPixels.data() : nullptr;
+    denoiser.denoise(inputs.mBeauty.mPixels.data(), albedo, normal, output.data(), &errorMsg);
+    if (!errorMsg.empty()) {
+        std::cerr << "Skipping " << modeInfo.mName << ": " << errorMsg << std::endl;
+        return false;
+    }
+
+    std::vector<double> times;
+    for (int i = 0; i < runs; ++i) {
+        start = std::chrono::steady_clock::now();
+        denoiser.denoise(inputs.mBeauty.mPixels.data(), albedo, normal, output.data(), &errorMsg);
+        times.push_back(elapsedMs(start));
+    }
+    std::sort(times.begin(), times.end());
+
+    result->mDenoiser = modeInfo.mName;
+    result->mBuffers = sBufferModeNames[bufferMode];
+    result->mWidth = w;
+    result->mHeight = h;
+    result->mThreads = threads;
+    result->mCreateMs = createMs;
+    result->mDenoiseMs = times.empty() ? 0.0 : times[times.size() / 2];
+    result->mPeakRssKb = getPeakRssKb();
+    result->mError = computeError(output, inputs.mReference);
+    return true;
+}
+
+void
+printResult(std::ostream &os, const Result &result)
+{
+    os << std::left << std::setw(10) << result.mDenoiser
+       << std::setw(23) << result.mBuffers
+       << std::right << std::setw(6) << result.mWidth << 'x' << std::left << std::setw(6) << result.mHeight
+       << std::right << std::setw(8) << result.mThreads
+       << std::fixed << std::setprecision(1)
+       << std::setw(11) << result.mCreateMs
+       << std::setw(11) << result.mDenoiseMs
+       << std::setw(12) << result.mPeakRssKb / 1024.0
+       << std::scientific << std::setprecision(4)
+       << std::setw(13) << result.mError.mRmse
+       << std::setw(13) << result.mError.mRelMse
+       << std::defaultfloat << std::endl;
+}
+
+} // anonymous namespace
+
+int
+main(int argc, char *argv[])
+{
+    using scene_rdl2::util::Args;
+    Args args(argc, argv);
+    Args::StringArray values;
+
+    std::string beautyPath, albedoPath, normalPath, referencePath, csvPath;
+    std::string scales = "1";
+    std::string threadCounts = "0";
+    int runs = 3;
+
+    if (args.getFlagValues("-beauty", 1, values) >= 0) beautyPath = values[0];
+    if (args.getFlagValues("-albedo", 1, values) >= 0) albedoPath = values[0];
+    if (args.getFlagValues("-normal", 1, values) >= 0) normalPath = values[0];
+    if (args.getFlagValues("-reference", 1, values) >= 0) referencePath = values[0];
+    if (args.getFlagValues("-scales", 1, values) >= 0) scales = values[0];
+    if (args.getFlagValues("-threads", 1, values) >= 0) threadCounts = values[0];
+    if (args.getFlagValues("-runs", 1, values) >= 0) runs = std::max(std::stoi(values[0]), 1);
+    if (args.getFlagValues("-csv", 1, values) >= 0) csvPath = values[0];
+
+    if (beautyPath.empty() || referencePath.empty()) {
+        std::cerr << sUsage << std::endl;
+        return 1;
+    }
+
+    OIIO::ImageBuf beauty, albedo, normal, reference;
+    if (!loadImage(beautyPath, &beauty) || !loadImage(referencePath, &reference)) {
+        return 1;
+    }
+    if (!albedoPath.empty() && !loadImage(albedoPath, &albedo)) {
+        return 1;
+    }
+    if (!normalPath.empty() && !loadImage(normalPath, &normal)) {
+        return 1;
+    }
+    if (!normalPath.empty() && albedoPath.empty()) {
+        std::cerr << "Normals are only used together with albedo, ignoring -normal" << std::endl;
+        normalPath.clear();
+    }
+
+    const int numBufferModes = normalPath.empty() ? (albedoPath.empty() ? 1 : 2) : 3;
+    const int defaultThreads = int(std::max(std::thread::hardware_concurrency(), 1u));
+
+    std::unique_ptr<std::ofstream> csv;
+    if (!csvPath.empty()) {
+        csv.reset(new std::ofstream(csvPath));
+        *csv << "denoiser,buffers,width,height,threads,create_ms,denoise_ms,peak_rss_mb,rmse,relmse\n";
+    }
+
+    std::cout << std::left << std::setw(10) << "denoiser" << std::setw(23) << "buffers"
+              << std::right << std::setw(13) << "resolution" << std::setw(8) << "threads"
+              << std::setw(11) << "create ms" << std::setw(11) << "denoise ms"
+              << std::setw(12) << "peak MB" << std::setw(13) << "rmse" << std::setw(13) << "relmse"
+              << std::endl;
+
+    for (const std::string &scaleStr : splitList(scales)) {
+        const float scale = std::stof(scaleStr);
+        const int w = std::max(int(std::lround(beauty.spec().width * scale)), 1);
+        const int h = std::max(int(std::lround(beauty.spec().height * scale)), 1);
+
+        Inputs inputs;
+        inputs.mBeauty = resizeImage(beauty, w, h);
+        inputs.mReference = resizeImage(reference, w, h);
+        if (!albedoPath.empty()) {
+            inputs.mAlbedo = resizeImage(albedo, w, h);
+        }
+        if (!normalPath.empty()) {
+            inputs.mNormal = resizeImage(normal, w, h);
+        }
+
+        // The noisy input gives a baseline for the error columns.
+        const Error inputError = computeError(inputs.mBeauty.mPixels, inputs.mReference);
+        std::cout << "input error at " << w << 'x' << h << ": rmse " << inputError.mRmse
+                  << ", relmse " << inputError.mRelMse << std::endl;
+
+        for (const std::string &threadStr : splitList(threadCounts)) {
+            const int threads = std::stoi(threadStr) > 0 ? std::stoi(threadStr) : defaultThreads;
+
+            // The CPU denoisers run their work on tbb, so limiting tbb's
+            // parallelism limits them too.
+            tbb::global_control threadLimit(tbb::global_control::max_allowed_parallelism, size_t(threads));
+
+            for (const DenoiserModeInfo &modeInfo : sDenoiserModes) {
+                for (int bufferMode = 0; bufferMode < numBufferModes; ++bufferMode) {
+                    Result result;
+                    if (!runConfig(modeInfo, BufferMode(bufferMode), inputs, threads, runs, &result)) {
+                        // A mode that can't be created on this machine won't
+                        // work with other buffers either.
+                        break;
+                    }
+                    printResult(std::cout, result);
+                    if (csv) {
+                        *csv << result.mDenoiser << ',' << result.mBuffers << ','
+                             << result.mWidth << ',' << result.mHeight << ',' << result.mThreads << ','
+                             << result.mCreateMs << ',' << result.mDenoiseMs << ','
+                             << result.mPeakRssKb / 1024.0 << ','
+                             << result.mError.mRmse << ',' << result.mError.mRelMse << '\n';
+                    }
+                }
+            }
+        }
+    }
+
+    return 0;
+}
+
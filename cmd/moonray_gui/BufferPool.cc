@@ -0,0 +1,114 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+/// @file BufferPool.cc
+
+#include "BufferPool.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+namespace moonray_gui {
+
+using scene_rdl2::fb_util::VariablePixelBuffer;
+
+size_t
+getBufferSize(const VariablePixelBuffer &buffer)
+{
+    size_t pixelSize;
+    switch (buffer.getFormat()) {
+    case VariablePixelBuffer::RGB888:   pixelSize = 3; break;
+    case VariablePixelBuffer::RGBA8888: pixelSize = 4; break;
+    case VariablePixelBuffer::FLOAT:    pixelSize = 4; break;
+    case VariablePixelBuffer::FLOAT2:   pixelSize = 8; break;
+    case VariablePixelBuffer::FLOAT3:   pixelSize = 12; break;
+    case VariablePixelBuffer::FLOAT4:   pixelSize = 16; break;
+    default:                            pixelSize = 0; break;
+    }
+    return size_t(buffer.getWidth()) * buffer.getHeight() * pixelSize;
+}
+
+BufferPool::BufferPool() :
+    mIdleTime(0.0),
+    mLiveTotal(0),
+    mPeakTotal(0)
+{
+    std::fill(mLastUsed, mLastUsed + NUM_BUFFER_PURPOSES, 0.0);
+    std::fill(mLive, mLive + NUM_BUFFER_PURPOSES, 0);
+    std::fill(mPeak, mPeak + NUM_BUFFER_PURPOSES, 0);
+}
+
+void
+BufferPool::add(BufferPurpose purpose, std::function<size_t()> getSize, std::function<void()> release)
+{
+    mEntries.push_back(Entry{purpose, std::move(getSize), std::move(release)});
+}
+
+size_t
+BufferPool::update(double time)
+{
+    size_t released = 0;
+    if (mIdleTime > 0.0) {
+        for (const Entry &entry : mEntries) {
+            if (!entry.mRelease || time - mLastUsed[entry.mPurpose] <= mIdleTime) continue;
+            const size_t size = entry.mGetSize();
+            if (size) {
+                entry.mRelease();
+                released += size - std::min(size, entry.mGetSize());
+            }
+        }
+    }
+    measure();
+    return released;
+}
+
+void
+BufferPool::measure()
+{
+    std::fill(mLive, mLive + NUM_BUFFER_PURPOSES, 0);
+    for (const Entry &entry : mEntries) {
+        mLive[entry.mPurpose] += entry.mGetSize();
+    }
+
+    mLiveTotal = 0;
+    for (int i = 0; i < NUM_BUFFER_PURPOSES; ++i) {
+        mPeak[i] = std::max(mPeak[i], mLive[i]);
+        mLiveTotal += mLive[i];
+    }
+    mPeakTotal = std::max(mPeakTotal, mLiveTotal);
+}
+
+std::string
+BufferPool::getReport() const
+{
+    std::ostringstream report;
+    report << std::left << std::setw(20) << "GUI memory" << std::right
+           << std::setw(8) << "live" << std::setw(8) << "peak" << " MB";
+    for (int i = 0; i < NUM_BUFFER_PURPOSES; ++i) {
+        report << '\n' << std::left << std::setw(20) << getPurposeName(BufferPurpose(i)) << std::right
+               << std::setw(8) << (mLive[i] >> 20) << std::setw(8) << (mPeak[i] >> 20);
+    }
+    report << '\n' << std::left << std::setw(20) << "total" << std::right
+           << std::setw(8) << (mLiveTotal >> 20) << std::setw(8) << (mPeakTotal >> 20);
+    return report.str();
+}
+
+const char *
+BufferPool::getPurposeName(BufferPurpose purpose)
+{
+    switch (purpose) {
+    case BUFFER_FRAME:               return "frame";
+    case BUFFER_DENOISE:             return "denoise";
+    case BUFFER_REPROJECTION:        return "reprojection";
+    case BUFFER_PICK:                return "pick buffer";
+    case BUFFER_CONTACT_SHEET:       return "contact sheet";
+    case BUFFER_RENDER_OUTPUT_CACHE: return "render outputs";
+    case BUFFER_SNAPSHOT_HISTORY:    return "snapshot history";
+    case BUFFER_OUTPUT_WRITER:       return "output writer";
+    default:                         return "unknown";
+    }
+}
+
+} // namespace moonray_gui
+
@@ -0,0 +1,120 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+/// @file BufferPool.h
+
+#pragma once
+
+#include <scene_rdl2/common/fb_util/PixelBuffer.h>
+#include <scene_rdl2/common/fb_util/VariablePixelBuffer.h>
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace moonray_gui {
+
+/// What GUI side memory is used for, as reported by BufferPool.
+enum BufferPurpose
+{
+    BUFFER_FRAME,               // snapshots of the frame and its conversion for display
+    BUFFER_DENOISE,
+    BUFFER_REPROJECTION,
+    BUFFER_PICK,
+    BUFFER_CONTACT_SHEET,
+    BUFFER_RENDER_OUTPUT_CACHE,
+    BUFFER_SNAPSHOT_HISTORY,
+    BUFFER_OUTPUT_WRITER,       // completed frames waiting to be, or having been, written out
+
+    NUM_BUFFER_PURPOSES
+};
+
+/// Size in bytes of the pixels of buffer.
+template <typename PixelType> size_t
+getBufferSize(const scene_rdl2::fb_util::PixelBuffer<PixelType> &buffer)
+{
+    return size_t(buffer.getWidth()) * buffer.getHeight() * sizeof(PixelType);
+}
+
+size_t getBufferSize(const scene_rdl2::fb_util::VariablePixelBuffer &buffer);
+
+/**
+ * Keeps track of the GUI's scratch buffers by purpose. The buffers are left
+ * empty until whatever fills them first sizes them, and every buffer of a
+ * purpose is freed again once the purpose hasn't been used for a while, so
+ * features which are switched off don't hold on to frame sized buffers.
+ * Memory held elsewhere can be counted too. Live and peak memory is tracked
+ * for each purpose. Only used from the render thread.
+ */
+class BufferPool
+{
+public:
+    BufferPool();
+
+    /// Seconds a purpose may go unused before its buffers are freed, or 0
+    /// to keep them.
+    void setIdleTime(double seconds) { mIdleTime = seconds; }
+
+    /// Adds a buffer to free when purpose is idle. The buffer's owner keeps
+    /// using it directly.
+    template <typename Buffer> void
+    add(BufferPurpose purpose, Buffer *buffer)
+    {
+        add(purpose,
+            [buffer] { return getBufferSize(*buffer); },
+            [buffer] { *buffer = Buffer(); });
+    }
+
+    /// Adds a buffer which is counted but never freed, for buffers whose
+    /// contents are needed again after being idle.
+    template <typename Buffer> void
+    addPinned(BufferPurpose purpose, const Buffer *buffer)
+    {
+        add(purpose, [buffer] { return getBufferSize(*buffer); }, nullptr);
+    }
+
+    /// Adds memory owned elsewhere, counted through getSize and freed, if
+    /// release isn't null, through release.
+    void add(BufferPurpose purpose, std::function<size_t()> getSize, std::function<void()> release);
+
+    /// Marks purpose as being in use at time.
+    void touch(BufferPurpose purpose, double time) { mLastUsed[purpose] = time; }
+
+    /// Frees the buffers of purposes which have gone unused for the idle
+    /// time and measures what is left. Returns the number of bytes freed.
+    size_t update(double time);
+
+    /// Updates the live and peak sizes. Cheap enough to call whenever
+    /// buffers may have been resized, so peaks between updates are seen.
+    void measure();
+
+    size_t getLiveSize(BufferPurpose purpose) const { return mLive[purpose]; }
+    size_t getPeakSize(BufferPurpose purpose) const { return mPeak[purpose]; }
+    size_t getLiveTotal() const { return mLiveTotal; }
+    size_t getPeakTotal() const { return mPeakTotal; }
+
+    /// Live and peak memory for each purpose, one per line.
+    std::string getReport() const;
+
+    static const char *getPurposeName(BufferPurpose purpose);
+
+private:
+    struct Entry
+    {
+        BufferPurpose mPurpose;
+        std::function<size_t()> mGetSize;
+        std::function<void()> mRelease;
+    };
+
+    std::vector<Entry> mEntries;
+    double mIdleTime;
+    double mLastUsed[NUM_BUFFER_PURPOSES];
+    size_t mLive[NUM_BUFFER_PURPOSES];
+    size_t mPeak[NUM_BUFFER_PURPOSES];
+    size_t mLiveTotal;
+    size_t mPeakTotal;
+};
+
+} // namespace moonray_gui
+
@@ -0,0 +1,94 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+/// @file CameraPublisher.cc
+
+#include "CameraPublisher.h"
+
+#include <scene_rdl2/common/math/MathUtil.h>
+
+#include <algorithm>
+
+namespace moonray_gui {
+
+using namespace scene_rdl2::math;
+
+// Furthest ahead of the latest transform we extrapolate, so a stalled Qt
+// thread doesn't send the camera flying off along its last motion.
+#define CAMERA_EXTRAPOLATION_HORIZON    0.02
+
+namespace {
+
+inline Vec4f
+extrapolate(const Vec4f &prev, const Vec4f &cur, float s)
+{
+    return cur + (cur - prev) * s;
+}
+
+inline Vec4f
+asDirection(const Vec3f &v)
+{
+    return Vec4f(v.x, v.y, v.z, 0.f);
+}
+
+}
+
+void
+CameraPublisher::publish(const Mat4f &xform, double time)
+{
+    std::shared_ptr<const State> prev = std::atomic_load(&mState);
+    if (!prev) {
+        reset(xform, time);
+        return;
+    }
+
+    auto state = std::make_shared<State>();
+    state->mXform = xform;
+    state->mPrevXform = prev->mXform;
+    state->mTime = time;
+    state->mInterval = isEqual(xform, prev->mXform) ? 0.0 : time - prev->mTime;
+    std::atomic_store(&mState, std::shared_ptr<const State>(std::move(state)));
+}
+
+void
+CameraPublisher::reset(const Mat4f &xform, double time)
+{
+    auto state = std::make_shared<State>();
+    state->mXform = xform;
+    state->mPrevXform = xform;
+    state->mTime = time;
+    state->mInterval = 0.0;
+    std::atomic_store(&mState, std::shared_ptr<const State>(std::move(state)));
+}
+
+Mat4f
+CameraPublisher::get(double time) const
+{
+    const std::shared_ptr<const State> state = std::atomic_load(&mState);
+    if (!state) {
+        return Mat4f(one);
+    }
+
+    const double age = std::min(time - state->mTime, CAMERA_EXTRAPOLATION_HORIZON);
+    if (state->mInterval <= 0.0 || age <= 0.0) {
+        return state->mXform;
+    }
+
+    // Carry on at the same rate, then square the axes back up since blending
+    // rotations linearly shears them slightly.
+    const float s = float(age / state->mInterval);
+    const Mat4f &cur = state->mXform;
+    const Mat4f &prev = state->mPrevXform;
+    const Vec3f z = normalize(asVec3(extrapolate(prev.vz, cur.vz, s)));
+    const Vec3f x = normalize(cross(asVec3(extrapolate(prev.vy, cur.vy, s)), z));
+    const Vec3f y = cross(z, x);
+    Mat4f xform = cur;
+    xform.vx = asDirection(x);
+    xform.vy = asDirection(y);
+    xform.vz = asDirection(z);
+    xform.vw = extrapolate(prev.vw, cur.vw, s);
+    return xform;
+}
+
+} // namespace moonray_gui
+
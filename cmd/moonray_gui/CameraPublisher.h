@@ -0,0 +1,50 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+/// @file CameraPublisher.h
+
+#pragma once
+
+#include <scene_rdl2/common/math/Mat4.h>
+
+#include <memory>
+
+namespace moonray_gui {
+
+/**
+ * Hands the navigation camera transform from the Qt thread, which integrates
+ * it, to the render thread. Each transform is published as an immutable state
+ * swapped in atomically, so neither side ever waits on the other. Readers
+ * extrapolate the latest transform along the motion since the one before it
+ * to cover the time since it was published.
+ */
+class CameraPublisher
+{
+public:
+    /// Publishes xform as the transform at time, moving on from the last one.
+    void publish(const scene_rdl2::math::Mat4f &xform, double time);
+
+    /// Publishes xform as the transform at time, with no motion to
+    /// extrapolate, e.g. after the camera has been reset.
+    void reset(const scene_rdl2::math::Mat4f &xform, double time);
+
+    /// Returns the transform extrapolated to time, or identity if nothing
+    /// has been published. A camera at rest always returns exactly the
+    /// transform it was published with.
+    scene_rdl2::math::Mat4f get(double time) const;
+
+private:
+    struct State
+    {
+        scene_rdl2::math::Mat4f mXform;
+        scene_rdl2::math::Mat4f mPrevXform;
+        double mTime;
+        double mInterval; // seconds since mPrevXform, 0 if at rest
+    };
+
+    // Only accessed through std::atomic_load and std::atomic_store.
+    std::shared_ptr<const State> mState;
+};
+
+} // namespace moonray_gui
+
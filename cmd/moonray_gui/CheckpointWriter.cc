@@ -0,0 +1,164 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+/// @file CheckpointWriter.cc
+
+#include "CheckpointWriter.h"
+#include "ExrWriteScope.h"
+
+#include <moonray/rendering/rndr/rndr.h>
+#include <scene_rdl2/render/logging/logging.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <pthread.h>
+#include <sched.h>
+
+namespace moonray_gui {
+
+namespace {
+
+// Inserts tag before the extension of path, e.g. "beauty.exr" -> "beauty.<tag>.exr".
+std::string
+insertBeforeExtension(const std::string &path, const std::string &tag)
+{
+    const size_t slash = path.rfind('/');
+    const size_t dot = path.rfind('.');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+        return path + "." + tag;
+    }
+    return path.substr(0, dot) + "." + tag + path.substr(dot);
+}
+
+}
+
+CheckpointWriter::CheckpointWriter() :
+    mMetadata(nullptr),
+    mPending(false),
+    mBusy(false),
+    mStop(false)
+{
+    mWorker = std::thread(&CheckpointWriter::workerLoop, this);
+
+    // Batch scheduling keeps us from preempting the render threads, but
+    // unlike idle priority still gets a fair share of a core while they keep
+    // every core busy, so checkpoints land during the long renders they are
+    // for.
+    sched_param param;
+    param.sched_priority = 0;
+    if (pthread_setschedparam(mWorker.native_handle(), SCHED_BATCH, &param) != 0) {
+        scene_rdl2::logging::Logger::warn("Unable to lower the priority of the checkpoint writer thread");
+    }
+}
+
+CheckpointWriter::~CheckpointWriter()
+{
+    waitForIdle();
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStop = true;
+    }
+    mCondition.notify_one();
+    mWorker.join();
+}
+
+scene_rdl2::fb_util::RenderBuffer *
+CheckpointWriter::acquire()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mPending || mBusy) {
+        scene_rdl2::logging::Logger::warn("Skipping checkpoint, the previous one is still being written");
+        return nullptr;
+    }
+    return &mBuffer;
+}
+
+void
+CheckpointWriter::submit(const std::string &outputPath,
+                         const scene_rdl2::rdl2::SceneObject *metadata,
+                         const scene_rdl2::math::HalfOpenViewport &aperture,
+                         const scene_rdl2::math::HalfOpenViewport &region)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mOutputPath = outputPath;
+        mMetadata = metadata;
+        mAperture = aperture;
+        mRegion = region;
+        mPending = true;
+    }
+    mCondition.notify_one();
+}
+
+void
+CheckpointWriter::waitForIdle()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    mIdleCondition.wait(lock, [this] { return !mPending && !mBusy; });
+}
+
+void
+CheckpointWriter::write()
+{
+    const std::string path = insertBeforeExtension(mOutputPath, "checkpoint");
+    const std::string tmpPath = insertBeforeExtension(mOutputPath, "checkpoint.tmp");
+    const std::string prevPath = insertBeforeExtension(mOutputPath, "checkpoint.1");
+
+    try {
+        // OpenEXR compresses on its own thread pool, which this thread's
+        // priority doesn't reach, so keep it to a single thread. Other writes
+        // wait for this one, so it has to run at a fair priority.
+        ExrWriteScope exr(1);
+        moonray::rndr::writePixelBuffer(mBuffer, tmpPath, mMetadata, mAperture, mRegion);
+    } catch (const std::exception &e) {
+        scene_rdl2::logging::Logger::error("Failed to write out ", tmpPath, ": ", e.what());
+        std::remove(tmpPath.c_str());
+        return;
+    } catch (...) {
+        scene_rdl2::logging::Logger::error("Failed to write out ", tmpPath);
+        std::remove(tmpPath.c_str());
+        return;
+    }
+
+    // Renames within a directory are atomic, so whatever happens there is
+    // always a complete checkpoint on disk.
+    if (std::rename(path.c_str(), prevPath.c_str()) != 0 && errno != ENOENT) {
+        scene_rdl2::logging::Logger::warn("Failed to rotate ", path, ": ", std::strerror(errno));
+    }
+    if (std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+        scene_rdl2::logging::Logger::error("Failed to rename ", tmpPath, " to ", path, ": ", std::strerror(errno));
+        return;
+    }
+    std::cout << "Wrote checkpoint " << path << std::endl;
+}
+
+void
+CheckpointWriter::workerLoop()
+{
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCondition.wait(lock, [this] { return mStop || mPending; });
+            if (mStop) {
+                return;
+            }
+            mPending = false;
+            mBusy = true;
+        }
+
+        // Nothing else touches the checkpoint state while we're busy.
+        write();
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mBusy = false;
+        }
+        mIdleCondition.notify_all();
+    }
+}
+
+} // namespace moonray_gui
+
@@ -0,0 +1,70 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+/// @file CheckpointWriter.h
+
+#pragma once
+
+#include <scene_rdl2/common/fb_util/FbTypes.h>
+#include <scene_rdl2/common/math/Viewport.h>
+#include <scene_rdl2/scene/rdl2/SceneObject.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace moonray_gui {
+
+/**
+ * Periodically writes the frame being rendered so that a long interactive
+ * render isn't lost if the session dies. Writing happens on a batch priority
+ * thread using a single core, so it never preempts the render threads, and
+ * each checkpoint replaces the last with a rename so there is always a
+ * complete file on disk.
+ */
+class CheckpointWriter
+{
+public:
+    CheckpointWriter();
+    ~CheckpointWriter();
+
+    /// Returns the buffer to snapshot the next checkpoint into, or null (with
+    /// a warning) if the previous checkpoint is still being written, in which
+    /// case this one should be skipped.
+    scene_rdl2::fb_util::RenderBuffer *acquire();
+
+    /// Writes the acquired buffer to outputPath with ".checkpoint" added
+    /// before the extension. The previous checkpoint is kept alongside with
+    /// ".checkpoint.1".
+    void submit(const std::string &outputPath,
+                const scene_rdl2::rdl2::SceneObject *metadata,
+                const scene_rdl2::math::HalfOpenViewport &aperture,
+                const scene_rdl2::math::HalfOpenViewport &region);
+
+    /// Blocks until the pending checkpoint is written. The metadata points
+    /// into the scene, so this must be called before the scene is modified
+    /// or destroyed.
+    void waitForIdle();
+
+private:
+    void write();
+    void workerLoop();
+
+    scene_rdl2::fb_util::RenderBuffer mBuffer;
+    std::string mOutputPath;
+    const scene_rdl2::rdl2::SceneObject *mMetadata;
+    scene_rdl2::math::HalfOpenViewport mAperture;
+    scene_rdl2::math::HalfOpenViewport mRegion;
+    bool mPending;
+    bool mBusy;
+
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    std::condition_variable mIdleCondition;
+    bool mStop;
+    std::thread mWorker;
+};
+
+} // namespace moonray_gui
+
@@ -0,0 +1,38 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include "FrameUpdateEvent.h"
+
+#include <QEvent>
+
+#include <cstdint>
+#include <vector>
+
+namespace moonray_gui {
+
+/// Thumbnails of the beauty and every render output, shown in place of the
+/// frame while the contact sheet is up.
+class ContactSheetEvent : public QEvent
+{
+public:
+    ContactSheetEvent(std::vector<DisplayPane> thumbnails, uint64_t frameNumber):
+        QEvent(ContactSheetEvent::type()),
+        mThumbnails(std::move(thumbnails)),
+        mFrameNumber(frameNumber)
+    {
+    }
+
+    const std::vector<DisplayPane> &getThumbnails() const { return mThumbnails; }
+    uint64_t getFrameNumber() const { return mFrameNumber; }
+    static QEvent::Type type() { return sEventType; }
+
+private:
+    std::vector<DisplayPane> mThumbnails;
+    uint64_t mFrameNumber;
+    static QEvent::Type sEventType;
+};
+
+} // namespace moonray_gui
+
@@ -0,0 +1,288 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+/// @file ConvergenceBenchmark.cc
+
+#include "ConvergenceBenchmark.h"
+
+#include <scene_rdl2/common/platform/Platform.h>
+#include <scene_rdl2/render/logging/logging.h>
+
+#include <OpenImageIO/imagebuf.h>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+namespace moonray_gui {
+
+using scene_rdl2::fb_util::RenderBuffer;
+using scene_rdl2::fb_util::RenderColor;
+
+namespace {
+
+// Error thresholds to report the time to, from coarse to fine. They are used
+// for all three errors.
+const double sThresholds[] = { 0.1, 0.05, 0.02, 0.01, 0.005, 0.002, 0.001, 0.0005, 0.0002, 0.0001 };
+
+const char *sErrorNames[] = { "rmse", "relmse", "flip" };
+
+template <typename Func> void
+forEachRow(unsigned h, const Func &func)
+{
+    tbb::parallel_for(tbb::blocked_range<unsigned>(0, h), [&](const tbb::blocked_range<unsigned> &range) {
+        for (unsigned y = range.begin(); y != range.end(); ++y) {
+            func(y);
+        }
+    });
+}
+
+// Opponent color space of the tone mapped color, roughly luminance and the
+// red-green and blue-yellow axes.
+inline void
+toOpponent(float r, float g, float b, float *dst)
+{
+    r = std::max(r, 0.f) / (1.f + std::max(r, 0.f));
+    g = std::max(g, 0.f) / (1.f + std::max(g, 0.f));
+    b = std::max(b, 0.f) / (1.f + std::max(b, 0.f));
+    dst[0] = 0.2126f * r + 0.7152f * g + 0.0722f * b;
+    dst[1] = r - g;
+    dst[2] = 0.5f * (r + g) - b;
+}
+
+std::string
+describeRun(const ConvergenceRun &run)
+{
+    return std::string(run.mFastProgressive ? "progressive_fast" : "progressive") +
+           (run.mDenoise ? "+denoise" : "");
+}
+
+}
+
+ConvergenceBenchmark::ConvergenceBenchmark(const std::string &outputPrefix, double runDuration) :
+    mOutputPrefix(outputPrefix),
+    mRunDuration(runDuration),
+    mWidth(0),
+    mHeight(0),
+    mRuns({ { false, false }, { false, true }, { true, false }, { true, true } }),
+    mNextRun(0),
+    mCurrentRun(0),
+    mWaitingForFrame(false),
+    mRunning(false),
+    mFrameComplete(false),
+    mFailed(false),
+    mRunStartTime(0.0),
+    mMeasureTime(0.0)
+{
+}
+
+bool
+ConvergenceBenchmark::loadReference(const std::string &path)
+{
+    OIIO::ImageBuf buf(path);
+    if (!buf.read(0, 0, true, OIIO::TypeDesc::FLOAT)) {
+        scene_rdl2::logging::Logger::error("Error reading ", path, ": ", buf.geterror());
+        return false;
+    }
+    const OIIO::ImageSpec &spec = buf.spec();
+    if (spec.nchannels < 3) {
+        scene_rdl2::logging::Logger::error("Error reading ", path, ": expected at least 3 channels, found ",
+                                           spec.nchannels);
+        return false;
+    }
+
+    mWidth = unsigned(spec.width);
+    mHeight = unsigned(spec.height);
+    mReference.resize(size_t(mWidth) * mHeight * 3);
+
+    // Images are stored top row first, render buffers bottom row first.
+    for (unsigned y = 0; y < mHeight; ++y) {
+        const OIIO::ROI row(spec.x, spec.x + spec.width, spec.y + int(y), spec.y + int(y) + 1, 0, 1, 0, 3);
+        buf.get_pixels(row, OIIO::TypeDesc::FLOAT, &mReference[size_t(mHeight - 1 - y) * mWidth * 3]);
+    }
+
+    mReferenceOpponent.resize(mReference.size());
+    for (size_t i = 0; i < mReference.size(); i += 3) {
+        toOpponent(mReference[i], mReference[i + 1], mReference[i + 2], &mReferenceOpponent[i]);
+    }
+    std::cout << "Convergence reference " << path << " is " << mWidth << "x" << mHeight << std::endl;
+    return true;
+}
+
+bool
+ConvergenceBenchmark::nextRun(ConvergenceRun *run)
+{
+    mRunning = false;
+    mWaitingForFrame = false;
+    if (mFailed) {
+        return false;
+    }
+
+    if (mNextRun >= mRuns.size()) {
+        return false;
+    }
+    mCurrentRun = mNextRun++;
+
+    *run = mRuns[mCurrentRun];
+    mWaitingForFrame = true;
+    mFrameComplete = false;
+    std::cout << "Convergence run " << describeRun(*run) << std::endl;
+    return true;
+}
+
+void
+ConvergenceBenchmark::frameStarted(double time)
+{
+    if (mWaitingForFrame) {
+        mWaitingForFrame = false;
+        mRunning = true;
+        mRunStartTime = time;
+        mMeasureTime = 0.0;
+    }
+}
+
+bool
+ConvergenceBenchmark::isRunFinished(double time) const
+{
+    return mFailed || mFrameComplete || (mRunning && time - mRunStartTime - mMeasureTime >= mRunDuration);
+}
+
+void
+ConvergenceBenchmark::addSample(double time, const RenderBuffer &frame, bool frameComplete)
+{
+    if (!mRunning || mFrameComplete) {
+        return;
+    }
+    if (frame.getWidth() != mWidth || frame.getHeight() != mHeight) {
+        scene_rdl2::logging::Logger::error("Frame is ", frame.getWidth(), "x", frame.getHeight(),
+                                           " but the convergence reference is ", mWidth, "x", mHeight);
+        mFailed = true;
+        return;
+    }
+
+    const double measureStart = scene_rdl2::util::getSeconds();
+    const unsigned w = mWidth;
+    const unsigned h = mHeight;
+    mDifference.resize(size_t(w) * h * 3);
+
+    // Per row sums, so rows can be worked on in parallel.
+    std::vector<double> rowSq(h, 0.0);
+    std::vector<double> rowRel(h, 0.0);
+    std::vector<double> rowFlip(h, 0.0);
+
+    forEachRow(h, [&](unsigned y) {
+        const RenderColor *src = frame.getRow(y);
+        const float *ref = &mReference[size_t(y) * w * 3];
+        const float *refOpponent = &mReferenceOpponent[size_t(y) * w * 3];
+        float *diff = &mDifference[size_t(y) * w * 3];
+        for (unsigned x = 0; x < w; ++x) {
+            const float rgb[3] = { src[x].x, src[x].y, src[x].z };
+            for (int c = 0; c < 3; ++c) {
+                const double d = double(rgb[c]) - ref[x * 3 + c];
+                rowSq[y] += d * d;
+                rowRel[y] += d * d / (double(ref[x * 3 + c]) * ref[x * 3 + c] + 0.01);
+            }
+
+            float a[3];
+            toOpponent(rgb[0], rgb[1], rgb[2], a);
+            for (int c = 0; c < 3; ++c) {
+                diff[x * 3 + c] = a[c] - refOpponent[x * 3 + c];
+            }
+        }
+    });
+
+    // Box filtering the difference is the same as filtering both images,
+    // and stands in for FLIP's contrast sensitivity filter.
+    forEachRow(h, [&](unsigned y) {
+        const unsigned y0 = y > 0 ? y - 1 : y;
+        const unsigned y1 = y + 1 < h ? y + 1 : y;
+        for (unsigned x = 0; x < w; ++x) {
+            const unsigned x0 = x > 0 ? x - 1 : x;
+            const unsigned x1 = x + 1 < w ? x + 1 : x;
+            float sum[3] = { 0.f, 0.f, 0.f };
+            for (unsigned fy = y0; fy <= y1; ++fy) {
+                for (unsigned fx = x0; fx <= x1; ++fx) {
+                    const float *d = &mDifference[(size_t(fy) * w + fx) * 3];
+                    sum[0] += d[0];
+                    sum[1] += d[1];
+                    sum[2] += d[2];
+                }
+            }
+            const float n = float((y1 - y0 + 1) * (x1 - x0 + 1));
+            const float e = std::sqrt(sum[0] * sum[0] + sum[1] * sum[1] + sum[2] * sum[2]) / n;
+            rowFlip[y] += std::min(e, 1.f);
+        }
+    });
+
+    double sumSq = 0.0, sumRel = 0.0, sumFlip = 0.0;
+    for (unsigned y = 0; y < h; ++y) {
+        sumSq += rowSq[y];
+        sumRel += rowRel[y];
+        sumFlip += rowFlip[y];
+    }
+    const double numPixels = double(w) * h;
+    mSamples.push_back(Sample{ mCurrentRun, time - mRunStartTime - mMeasureTime,
+                               std::sqrt(sumSq / (numPixels * 3)), sumRel / (numPixels * 3), sumFlip / numPixels });
+    mFrameComplete = frameComplete;
+    mMeasureTime += scene_rdl2::util::getSeconds() - measureStart;
+}
+
+void
+ConvergenceBenchmark::writeResults() const
+{
+    const std::string samplesPath = mOutputPrefix + ".samples.csv";
+    std::ofstream samples(samplesPath);
+    if (!samples) {
+        scene_rdl2::logging::Logger::error("Unable to write ", samplesPath);
+    } else {
+        samples << "run,seconds,rmse,relmse,flip\n";
+        for (const Sample &s : mSamples) {
+            samples << describeRun(mRuns[s.mRun]) << ',' << s.mTime << ','
+                    << s.mRmse << ',' << s.mRelMse << ',' << s.mFlip << '\n';
+        }
+        std::cout << "Wrote " << samplesPath << std::endl;
+    }
+
+    // The first time each run's errors dropped under each threshold, empty if
+    // they never did.
+    const std::string thresholdsPath = mOutputPrefix + ".thresholds.csv";
+    std::ofstream thresholds(thresholdsPath);
+    if (!thresholds) {
+        scene_rdl2::logging::Logger::error("Unable to write ", thresholdsPath);
+        return;
+    }
+    thresholds << "run,error,threshold,seconds\n";
+    std::cout << "Time to threshold (seconds):" << std::endl;
+    for (size_t run = 0; run < mRuns.size(); ++run) {
+        for (int error = 0; error < 3; ++error) {
+            std::cout << "  " << std::left << std::setw(26) << describeRun(mRuns[run]) + " " + sErrorNames[error];
+            for (double threshold : sThresholds) {
+                double seconds = -1.0;
+                for (const Sample &s : mSamples) {
+                    const double value = error == 0 ? s.mRmse : (error == 1 ? s.mRelMse : s.mFlip);
+                    if (s.mRun == run && value <= threshold) {
+                        seconds = s.mTime;
+                        break;
+                    }
+                }
+                thresholds << describeRun(mRuns[run]) << ',' << sErrorNames[error] << ',' << threshold << ',';
+                if (seconds >= 0.0) {
+                    thresholds << seconds;
+                    std::cout << ' ' << threshold << ':' << std::fixed << std::setprecision(2) << seconds
+                              << std::defaultfloat << std::setprecision(6);
+                }
+                thresholds << '\n';
+            }
+            std::cout << std::right << std::endl;
+        }
+    }
+    std::cout << "Wrote " << thresholdsPath << std::endl;
+}
+
+} // namespace moonray_gui
+
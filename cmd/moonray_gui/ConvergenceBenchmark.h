@@ -0,0 +1,107 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+/// @file ConvergenceBenchmark.h
+
+#pragma once
+
+#include <scene_rdl2/common/fb_util/FbTypes.h>
+
+#include <string>
+#include <vector>
+
+namespace moonray_gui {
+
+/// A GUI configuration the benchmark renders the scene with.
+struct ConvergenceRun
+{
+    bool mFastProgressive;
+    bool mDenoise;
+};
+
+/**
+ * Measures how quickly the frames the GUI displays approach a reference
+ * image. The scene is rendered from scratch once for each ConvergenceRun, and
+ * every displayed frame is compared against the reference. The results show
+ * how long each configuration takes to get under a series of error
+ * thresholds, so GUI changes which take time away from rendering show up as
+ * regressions.
+ *
+ * Three errors are measured over the color channels:
+ *  - RMSE.
+ *  - Relative MSE, which is normalized by the reference so dark and bright
+ *    regions count equally.
+ *  - A cheap stand-in for FLIP: the color difference of the tone mapped
+ *    images in an opponent color space, after a small box filter, clamped to
+ *    1 per pixel and averaged.
+ */
+class ConvergenceBenchmark
+{
+public:
+    /// Each run renders for at most runDuration seconds. Results are
+    /// written to outputPrefix with ".samples.csv" and ".thresholds.csv"
+    /// appended.
+    ConvergenceBenchmark(const std::string &outputPrefix, double runDuration);
+
+    /// Returns false if the reference can't be read.
+    bool loadReference(const std::string &path);
+
+    /// Moves on to the next configuration to render, returning false once
+    /// every run is done or the benchmark has failed.
+    bool nextRun(ConvergenceRun *run);
+
+    /// Starts timing the current run, once its frame has been started.
+    void frameStarted(double time);
+
+    bool isWaitingForFrame() const { return mWaitingForFrame; }
+    bool isRunning() const { return mRunning; }
+
+    /// True once the current run has used up its time or its frame is
+    /// complete.
+    bool isRunFinished(double time) const;
+
+    /// Compares a displayed frame, rows from the bottom, to the reference.
+    /// This uses every core, and the time it takes is left out of the run,
+    /// so that measuring doesn't count against the configuration measured.
+    void addSample(double time, const scene_rdl2::fb_util::RenderBuffer &frame, bool frameComplete);
+
+    /// Writes the results and prints the time to each threshold.
+    void writeResults() const;
+
+private:
+    struct Sample
+    {
+        size_t mRun;
+        double mTime; // seconds since the run's frame started
+        double mRmse;
+        double mRelMse;
+        double mFlip;
+    };
+
+    std::string mOutputPrefix;
+    double mRunDuration;
+
+    /// Reference color, and the same in the opponent color space of the
+    /// FLIP stand in, 3 floats per pixel, rows from the bottom.
+    unsigned mWidth;
+    unsigned mHeight;
+    std::vector<float> mReference;
+    std::vector<float> mReferenceOpponent;
+
+    std::vector<ConvergenceRun> mRuns;
+    size_t mNextRun; // index into mRuns
+    size_t mCurrentRun;
+    bool mWaitingForFrame;
+    bool mRunning;
+    bool mFrameComplete;
+    bool mFailed;
+    double mRunStartTime;
+    double mMeasureTime; // seconds of the current run spent in addSample
+    std::vector<Sample> mSamples;
+
+    /// Per pixel opponent color difference, 3 floats per pixel.
+    std::vector<float> mDifference;
+};
+
+} // namespace moonray_gui
+
@@ -0,0 +1,261 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+/// @file DenoiseUtils.cc
+
+#include "DenoiseUtils.h"
+
+#include <scene_rdl2/common/platform/Platform.h>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace moonray_gui {
+
+using scene_rdl2::fb_util::RenderBuffer;
+using scene_rdl2::fb_util::RenderColor;
+using scene_rdl2::fb_util::VariablePixelBuffer;
+using scene_rdl2::math::HalfOpenViewport;
+
+namespace {
+
+template <typename Func> void
+forEachRow(unsigned h, bool parallel, const Func &func)
+{
+    if (parallel) {
+        tbb::parallel_for(tbb::blocked_range<unsigned>(0, h), [&](const tbb::blocked_range<unsigned> &range) {
+            for (unsigned y = range.begin(); y != range.end(); ++y) {
+                func(y);
+            }
+        });
+    } else {
+        for (unsigned y = 0; y < h; ++y) {
+            func(y);
+        }
+    }
+}
+
+// Controls how strongly albedo differences suppress a reduced resolution sample.
+constexpr float ALBEDO_SIGMA_SQ = 0.01f;
+
+// Exponent applied to the cosine between normals.
+constexpr float NORMAL_POWER = 32.f;
+
+// Keeps the weights from all vanishing when a pixel matches none of its
+// reduced resolution neighbours, in which case we degrade to bilinear.
+constexpr float MIN_RANGE_WEIGHT = 1e-4f;
+
+inline float
+rangeWeight(const RenderBuffer *albedo, const RenderBuffer *lowAlbedo,
+            const RenderBuffer *normal, const RenderBuffer *lowNormal,
+            unsigned x, unsigned y, unsigned lx, unsigned ly)
+{
+    float weight = 1.f;
+    if (albedo && lowAlbedo) {
+        const RenderColor &a = albedo->getPixel(x, y);
+        const RenderColor &b = lowAlbedo->getPixel(lx, ly);
+        const float dr = a.x - b.x;
+        const float dg = a.y - b.y;
+        const float db = a.z - b.z;
+        weight *= std::exp(-(dr * dr + dg * dg + db * db) / ALBEDO_SIGMA_SQ);
+    }
+    if (normal && lowNormal) {
+        const RenderColor &a = normal->getPixel(x, y);
+        const RenderColor &b = lowNormal->getPixel(lx, ly);
+        const float lenSq = (a.x * a.x + a.y * a.y + a.z * a.z) * (b.x * b.x + b.y * b.y + b.z * b.z);
+        if (lenSq > 0.f) {
+            const float cosine = (a.x * b.x + a.y * b.y + a.z * b.z) / std::sqrt(lenSq);
+            weight *= std::pow(std::max(cosine, 0.f), NORMAL_POWER);
+        }
+    }
+    return std::max(weight, MIN_RANGE_WEIGHT);
+}
+
+} // anonymous namespace
+
+bool
+clipRegion(HalfOpenViewport &region, unsigned w, unsigned h)
+{
+    region.mMinX = std::max(region.mMinX, 0);
+    region.mMinY = std::max(region.mMinY, 0);
+    region.mMaxX = std::min(region.mMaxX, int(w));
+    region.mMaxY = std::min(region.mMaxY, int(h));
+    return region.mMinX < region.mMaxX && region.mMinY < region.mMaxY;
+}
+
+HalfOpenViewport
+expandRegion(const HalfOpenViewport &region, int margin, unsigned w, unsigned h)
+{
+    HalfOpenViewport expanded(region.mMinX - margin, region.mMinY - margin,
+                              region.mMaxX + margin, region.mMaxY + margin);
+    clipRegion(expanded, w, h);
+    return expanded;
+}
+
+void
+cropBuffer(const RenderBuffer &src, const HalfOpenViewport &region, RenderBuffer *dst)
+{
+    const unsigned w = unsigned(region.mMaxX - region.mMinX);
+    const unsigned h = unsigned(region.mMaxY - region.mMinY);
+    MNRY_ASSERT(region.mMaxX <= int(src.getWidth()) && region.mMaxY <= int(src.getHeight()));
+
+    if (dst->getWidth() != w || dst->getHeight() != h) {
+        dst->init(w, h);
+    }
+
+    for (unsigned y = 0; y < h; ++y) {
+        const RenderColor *srcRow = src.getRow(region.mMinY + y) + region.mMinX;
+        std::copy(srcRow, srcRow + w, dst->getRow(y));
+    }
+}
+
+void
+pasteBuffer(const RenderBuffer &src, const HalfOpenViewport &srcRegion,
+            const HalfOpenViewport &dstRegion, RenderBuffer *dst)
+{
+    MNRY_ASSERT(dstRegion.mMinX >= srcRegion.mMinX && dstRegion.mMaxX <= srcRegion.mMaxX);
+    MNRY_ASSERT(dstRegion.mMinY >= srcRegion.mMinY && dstRegion.mMaxY <= srcRegion.mMaxY);
+
+    const int w = dstRegion.mMaxX - dstRegion.mMinX;
+    const int offsetX = dstRegion.mMinX - srcRegion.mMinX;
+    for (int y = dstRegion.mMinY; y < dstRegion.mMaxY; ++y) {
+        const RenderColor *srcRow = src.getRow(y - srcRegion.mMinY) + offsetX;
+        std::copy(srcRow, srcRow + w, dst->getRow(y) + dstRegion.mMinX);
+    }
+}
+
+void
+downsampleBuffer(const RenderBuffer &src, unsigned factor, RenderBuffer *dst, bool parallel)
+{
+    MNRY_ASSERT(factor > 0);
+    const unsigned w = src.getWidth();
+    const unsigned h = src.getHeight();
+    const unsigned lw = (w + factor - 1) / factor;
+    const unsigned lh = (h + factor - 1) / factor;
+
+    if (dst->getWidth() != lw || dst->getHeight() != lh) {
+        dst->init(lw, lh);
+    }
+
+    forEachRow(lh, parallel, [&](unsigned ly) {
+        const unsigned y0 = ly * factor;
+        const unsigned y1 = std::min(y0 + factor, h);
+        RenderColor *dstRow = dst->getRow(ly);
+        for (unsigned lx = 0; lx < lw; ++lx) {
+            const unsigned x0 = lx * factor;
+            const unsigned x1 = std::min(x0 + factor, w);
+            RenderColor sum(0.f, 0.f, 0.f, 0.f);
+            for (unsigned y = y0; y < y1; ++y) {
+                const RenderColor *srcRow = src.getRow(y);
+                for (unsigned x = x0; x < x1; ++x) {
+                    sum += srcRow[x];
+                }
+            }
+            dstRow[lx] = sum * (1.f / float((x1 - x0) * (y1 - y0)));
+        }
+    });
+}
+
+bool
+downsampleBuffer(const VariablePixelBuffer &src, unsigned factor, VariablePixelBuffer *dst, bool parallel)
+{
+    MNRY_ASSERT(factor > 0);
+
+    unsigned channels;
+    switch (src.getFormat()) {
+    case VariablePixelBuffer::FLOAT:  channels = 1; break;
+    case VariablePixelBuffer::FLOAT2: channels = 2; break;
+    case VariablePixelBuffer::FLOAT3: channels = 3; break;
+    case VariablePixelBuffer::FLOAT4: channels = 4; break;
+    default: return false;
+    }
+
+    const unsigned w = src.getWidth();
+    const unsigned h = src.getHeight();
+    const unsigned lw = (w + factor - 1) / factor;
+    const unsigned lh = (h + factor - 1) / factor;
+
+    if (dst->getFormat() != src.getFormat() || dst->getWidth() != lw || dst->getHeight() != lh) {
+        dst->init(src.getFormat(), lw, lh);
+    }
+
+    const float *srcData = reinterpret_cast<const float *>(src.getData());
+    float *dstData = reinterpret_cast<float *>(dst->getData());
+
+    forEachRow(lh, parallel, [&](unsigned ly) {
+        const unsigned y0 = ly * factor;
+        const unsigned y1 = std::min(y0 + factor, h);
+        for (unsigned lx = 0; lx < lw; ++lx) {
+            const unsigned x0 = lx * factor;
+            const unsigned x1 = std::min(x0 + factor, w);
+            float sum[4] = {0.f, 0.f, 0.f, 0.f};
+            for (unsigned y = y0; y < y1; ++y) {
+                const float *srcRow = srcData + size_t(y) * w * channels;
+                for (unsigned x = x0; x < x1; ++x) {
+                    for (unsigned c = 0; c < channels; ++c) {
+                        sum[c] += srcRow[x * channels + c];
+                    }
+                }
+            }
+            const float scale = 1.f / float((x1 - x0) * (y1 - y0));
+            float *dstPixel = dstData + (size_t(ly) * lw + lx) * channels;
+            for (unsigned c = 0; c < channels; ++c) {
+                dstPixel[c] = sum[c] * scale;
+            }
+        }
+    });
+    return true;
+}
+
+void
+upsampleBuffer(const RenderBuffer &src,
+               const RenderBuffer *albedo, const RenderBuffer *lowAlbedo,
+               const RenderBuffer *normal, const RenderBuffer *lowNormal,
+               RenderBuffer *dst, bool parallel)
+{
+    const unsigned w = dst->getWidth();
+    const unsigned h = dst->getHeight();
+    const unsigned lw = src.getWidth();
+    const unsigned lh = src.getHeight();
+    MNRY_ASSERT(lw > 0 && lh > 0);
+
+    const float scaleX = float(lw) / float(w);
+    const float scaleY = float(lh) / float(h);
+
+    forEachRow(h, parallel, [&](unsigned y) {
+        // Position of this row's pixel centers in the reduced resolution image.
+        const float fy = std::max((float(y) + 0.5f) * scaleY - 0.5f, 0.f);
+        const unsigned ly0 = std::min(unsigned(fy), lh - 1);
+        const unsigned ly1 = std::min(ly0 + 1, lh - 1);
+        const float ty = fy - float(ly0);
+
+        RenderColor *dstRow = dst->getRow(y);
+        for (unsigned x = 0; x < w; ++x) {
+            const float fx = std::max((float(x) + 0.5f) * scaleX - 0.5f, 0.f);
+            const unsigned lx0 = std::min(unsigned(fx), lw - 1);
+            const unsigned lx1 = std::min(lx0 + 1, lw - 1);
+            const float tx = fx - float(lx0);
+
+            const unsigned lxs[4] = { lx0, lx1, lx0, lx1 };
+            const unsigned lys[4] = { ly0, ly0, ly1, ly1 };
+            const float spatial[4] = { (1.f - tx) * (1.f - ty), tx * (1.f - ty),
+                                       (1.f - tx) * ty,         tx * ty };
+
+            RenderColor sum(0.f, 0.f, 0.f, 0.f);
+            float weightSum = 0.f;
+            for (int i = 0; i < 4; ++i) {
+                const float weight = spatial[i] *
+                    rangeWeight(albedo, lowAlbedo, normal, lowNormal, x, y, lxs[i], lys[i]);
+                sum += src.getPixel(lxs[i], lys[i]) * weight;
+                weightSum += weight;
+            }
+            dstRow[x] = weightSum > 0.f ? sum * (1.f / weightSum) : src.getPixel(lx0, ly0);
+        }
+    });
+}
+
+} // namespace moonray_gui
+
@@ -0,0 +1,62 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+/// @file DenoiseUtils.h
+
+#pragma once
+
+#include <scene_rdl2/common/fb_util/FbTypes.h>
+#include <scene_rdl2/common/fb_util/VariablePixelBuffer.h>
+#include <scene_rdl2/common/math/Viewport.h>
+
+namespace moonray_gui {
+
+// Number of extra pixels denoised around a region of interest. The denoiser
+// needs some surrounding context to avoid visible seams where the denoised
+// region meets the noisy frame.
+constexpr int DENOISE_REGION_MARGIN = 32;
+
+// Clips region to a w x h frame and returns true if anything is left.
+bool clipRegion(scene_rdl2::math::HalfOpenViewport &region, unsigned w, unsigned h);
+
+// Grows region by margin pixels on each side, clipped to a w x h frame.
+scene_rdl2::math::HalfOpenViewport expandRegion(const scene_rdl2::math::HalfOpenViewport &region,
+                                                int margin, unsigned w, unsigned h);
+
+// Copies the pixels of src covered by region into dst, which is resized to
+// the dimensions of region.
+void cropBuffer(const scene_rdl2::fb_util::RenderBuffer &src,
+                const scene_rdl2::math::HalfOpenViewport &region,
+                scene_rdl2::fb_util::RenderBuffer *dst);
+
+// Writes the pixels of src which fall inside dstRegion back into dst. src is
+// assumed to cover srcRegion of dst, with srcRegion containing dstRegion.
+void pasteBuffer(const scene_rdl2::fb_util::RenderBuffer &src,
+                 const scene_rdl2::math::HalfOpenViewport &srcRegion,
+                 const scene_rdl2::math::HalfOpenViewport &dstRegion,
+                 scene_rdl2::fb_util::RenderBuffer *dst);
+
+// Box filters src down by an integer factor into dst, which is resized to
+// the rounded up reduced resolution.
+void downsampleBuffer(const scene_rdl2::fb_util::RenderBuffer &src, unsigned factor,
+                      scene_rdl2::fb_util::RenderBuffer *dst, bool parallel);
+
+// As above for render outputs. dst takes the format of src. Returns false,
+// leaving dst untouched, if src isn't one of the float formats.
+bool downsampleBuffer(const scene_rdl2::fb_util::VariablePixelBuffer &src, unsigned factor,
+                      scene_rdl2::fb_util::VariablePixelBuffer *dst, bool parallel);
+
+// Upsamples the reduced resolution src into dst, which must already be sized
+// to the full resolution. Where full and reduced resolution guides are given
+// (either may be nullptr) this is a joint bilateral upsample which keeps the
+// result from bleeding across albedo and normal edges, otherwise it is a
+// plain bilinear upsample.
+void upsampleBuffer(const scene_rdl2::fb_util::RenderBuffer &src,
+                    const scene_rdl2::fb_util::RenderBuffer *albedo,
+                    const scene_rdl2::fb_util::RenderBuffer *lowAlbedo,
+                    const scene_rdl2::fb_util::RenderBuffer *normal,
+                    const scene_rdl2::fb_util::RenderBuffer *lowNormal,
+                    scene_rdl2::fb_util::RenderBuffer *dst, bool parallel);
+
+} // namespace moonray_gui
+
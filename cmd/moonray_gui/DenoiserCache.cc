@@ -0,0 +1,125 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+/// @file DenoiserCache.cc
+
+#include "DenoiserCache.h"
+
+#include <scene_rdl2/common/platform/Platform.h>
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace moonray_gui {
+
+DenoiserCache::DenoiserCache(size_t capacity) :
+    // The entry handed out by acquire() is always at the front of the list, so
+    // with room for at least two entries the worker can never evict it.
+    mCapacity(std::max(capacity, size_t(2))),
+    mStop(false)
+{
+    mWorker = std::thread(&DenoiserCache::workerLoop, this);
+}
+
+DenoiserCache::~DenoiserCache()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStop = true;
+    }
+    mCondition.notify_one();
+    mWorker.join();
+}
+
+moonray::denoiser::Denoiser *
+DenoiserCache::acquire(const DenoiserConfig &config, bool *pending)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    auto it = findOrQueue(config);
+    mEntries.splice(mEntries.begin(), mEntries, it);
+
+    *pending = (it->mState == STATE_PENDING);
+    return it->mState == STATE_READY ? it->mDenoiser.get() : nullptr;
+}
+
+void
+DenoiserCache::prefetch(const DenoiserConfig &config)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    findOrQueue(config);
+}
+
+std::list<DenoiserCache::Entry>::iterator
+DenoiserCache::findOrQueue(const DenoiserConfig &config)
+{
+    auto it = std::find_if(mEntries.begin(), mEntries.end(),
+                           [&](const Entry &entry) { return entry.mConfig == config; });
+    if (it != mEntries.end()) {
+        return it;
+    }
+
+    mEntries.push_front(Entry{config, STATE_PENDING, nullptr});
+    mQueue.push_back(config);
+    mCondition.notify_one();
+    return mEntries.begin();
+}
+
+void
+DenoiserCache::workerLoop()
+{
+    while (true) {
+        DenoiserConfig config;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCondition.wait(lock, [this] { return mStop || !mQueue.empty(); });
+            if (mStop) {
+                return;
+            }
+            config = mQueue.front();
+            mQueue.pop_front();
+        }
+
+        // This is the slow part, do it without holding the lock.
+        std::string errorMsg;
+        auto denoiser = std::make_unique<moonray::denoiser::Denoiser>(
+            config.mMode, config.mWidth, config.mHeight,
+            config.mUseAlbedo, config.mUseNormals, &errorMsg);
+        if (!errorMsg.empty()) {
+            std::cout << "Error creating denoiser: " << errorMsg << std::endl;
+            denoiser.reset();
+        }
+
+        // Denoisers evicted from the cache are destroyed once the lock is
+        // released, since tearing down a device can be slow too.
+        std::vector<std::unique_ptr<moonray::denoiser::Denoiser>> evicted;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            auto it = std::find_if(mEntries.begin(), mEntries.end(),
+                                   [&](const Entry &entry) { return entry.mConfig == config; });
+            if (it != mEntries.end()) {
+                it->mDenoiser = std::move(denoiser);
+                it->mState = it->mDenoiser ? STATE_READY : STATE_FAILED;
+            }
+
+            // Evict least recently used entries, but never the most recently
+            // used one nor ones that are still waiting on the worker.
+            if (mEntries.size() > mCapacity) {
+                auto candidate = std::prev(mEntries.end());
+                while (mEntries.size() > mCapacity && candidate != mEntries.begin()) {
+                    auto next = std::prev(candidate);
+                    if (candidate->mState != STATE_PENDING) {
+                        evicted.push_back(std::move(candidate->mDenoiser));
+                        mEntries.erase(candidate);
+                    }
+                    candidate = next;
+                }
+            }
+        }
+    }
+}
+
+} // namespace moonray_gui
+
@@ -0,0 +1,90 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+/// @file DenoiserCache.h
+
+#pragma once
+
+#include <mcrt_denoise/denoiser/Denoiser.h>
+
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace moonray_gui {
+
+struct DenoiserConfig
+{
+    moonray::denoiser::DenoiserMode mMode;
+    unsigned mWidth;
+    unsigned mHeight;
+    bool mUseAlbedo;
+    bool mUseNormals;
+
+    bool operator==(const DenoiserConfig &other) const
+    {
+        return mMode == other.mMode &&
+               mWidth == other.mWidth && mHeight == other.mHeight &&
+               mUseAlbedo == other.mUseAlbedo && mUseNormals == other.mUseNormals;
+    }
+};
+
+/**
+ * Small LRU cache of denoiser instances. Constructing a denoiser (model load,
+ * device init) is slow enough to cause a visible hitch, so construction always
+ * happens on a background thread and the frame loop never waits on it.
+ */
+class DenoiserCache
+{
+public:
+    explicit DenoiserCache(size_t capacity);
+    ~DenoiserCache();
+
+    /// Returns the denoiser for config if it is ready, otherwise queues its
+    /// creation and returns nullptr. pending is set to true if the denoiser
+    /// is still being created, false if it is ready or failed to create.
+    /// The returned denoiser stays valid until the next call to acquire() or
+    /// prefetch(); those must all be made from the same thread.
+    moonray::denoiser::Denoiser *acquire(const DenoiserConfig &config, bool *pending);
+
+    /// Queues creation of the denoiser for config without marking it as used.
+    void prefetch(const DenoiserConfig &config);
+
+private:
+    enum State
+    {
+        STATE_PENDING,
+        STATE_READY,
+        STATE_FAILED
+    };
+
+    struct Entry
+    {
+        DenoiserConfig mConfig;
+        State mState;
+        std::unique_ptr<moonray::denoiser::Denoiser> mDenoiser;
+    };
+
+    // Returns the entry for config, creating a pending one if needed.
+    // mMutex must be held.
+    std::list<Entry>::iterator findOrQueue(const DenoiserConfig &config);
+
+    void workerLoop();
+
+    const size_t mCapacity;
+
+    // Most recently used entry first.
+    std::list<Entry> mEntries;
+    std::deque<DenoiserConfig> mQueue;
+
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    bool mStop;
+    std::thread mWorker;
+};
+
+} // namespace moonray_gui
+
@@ -0,0 +1,42 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+/// @file ExrWriteScope.cc
+
+#include "ExrWriteScope.h"
+
+#include <OpenImageIO/imageio.h>
+
+namespace moonray_gui {
+
+namespace {
+
+std::shared_mutex sExrWriteMutex;
+
+}
+
+ExrWriteScope::ExrWriteScope() :
+    mSharedLock(sExrWriteMutex),
+    mRestore(false),
+    mPrevThreads(0)
+{
+}
+
+ExrWriteScope::ExrWriteScope(int threads) :
+    mLock(sExrWriteMutex),
+    mRestore(false),
+    mPrevThreads(0)
+{
+    mRestore = OIIO::getattribute("exr_threads", mPrevThreads);
+    OIIO::attribute("exr_threads", threads);
+}
+
+ExrWriteScope::~ExrWriteScope()
+{
+    if (mRestore) {
+        OIIO::attribute("exr_threads", mPrevThreads);
+    }
+}
+
+} // namespace moonray_gui
+
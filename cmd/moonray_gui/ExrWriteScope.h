@@ -0,0 +1,42 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+/// @file ExrWriteScope.h
+
+#pragma once
+
+#include <mutex>
+#include <shared_mutex>
+
+namespace moonray_gui {
+
+/**
+ * Keeps image writes apart from a write made with a different number of
+ * threads for OpenEXR to compress with. OIIO only has a process wide setting
+ * for that, so it is changed for the scope and restored afterwards, and no
+ * other write may run meanwhile. Writes which leave it alone run together.
+ */
+class ExrWriteScope
+{
+public:
+    /// Writes with whatever thread count is already set, alongside any other
+    /// such writes.
+    ExrWriteScope();
+
+    /// Writes with threads OpenEXR threads, on its own.
+    explicit ExrWriteScope(int threads);
+
+    ~ExrWriteScope();
+
+    ExrWriteScope(const ExrWriteScope &) = delete;
+    ExrWriteScope &operator=(const ExrWriteScope &) = delete;
+
+private:
+    std::shared_lock<std::shared_mutex> mSharedLock;
+    std::unique_lock<std::shared_mutex> mLock;
+    bool mRestore;
+    int mPrevThreads;
+};
+
+} // namespace moonray_gui
+
@@ -0,0 +1,65 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+/// @file FrameRateGovernor.cc
+
+#include "FrameRateGovernor.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace moonray_gui {
+
+// Weight of the newest frame in the moving average of frame times.
+#define GOVERNOR_SMOOTHING          0.2
+
+// The average may drift this far from the target before the scale changes.
+#define GOVERNOR_TOLERANCE          0.1
+
+// Largest resolution divisor, and the step divisors are rounded to.
+#define GOVERNOR_MAX_SCALE          4.f
+#define GOVERNOR_SCALE_STEP         0.125f
+
+FrameRateGovernor::FrameRateGovernor() :
+    mTargetFrameTime(0.0)
+{
+    reset();
+}
+
+void
+FrameRateGovernor::reset()
+{
+    mAverageFrameTime = -1.0;
+    mScale = 1.f;
+}
+
+float
+FrameRateGovernor::update(double frameTime)
+{
+    if (!isEnabled() || frameTime <= 0.0) {
+        return mScale;
+    }
+
+    mAverageFrameTime = mAverageFrameTime < 0.0 ? frameTime :
+        GOVERNOR_SMOOTHING * frameTime + (1.0 - GOVERNOR_SMOOTHING) * mAverageFrameTime;
+
+    const double ratio = mAverageFrameTime / mTargetFrameTime;
+    if (std::abs(ratio - 1.0) < GOVERNOR_TOLERANCE) {
+        return mScale;
+    }
+
+    // Pixel count goes with the square of the divisor.
+    float scale = mScale * float(std::sqrt(ratio));
+    scale = std::round(scale / GOVERNOR_SCALE_STEP) * GOVERNOR_SCALE_STEP;
+    scale = std::max(1.f, std::min(scale, GOVERNOR_MAX_SCALE));
+
+    if (scale != mScale) {
+        mScale = scale;
+        // Frame times measured at the old resolution no longer apply.
+        mAverageFrameTime = -1.0;
+    }
+    return mScale;
+}
+
+} // namespace moonray_gui
+
@@ -0,0 +1,41 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+/// @file FrameRateGovernor.h
+
+#pragma once
+
+namespace moonray_gui {
+
+/**
+ * Picks a resolution divisor for realtime rendering which keeps the measured
+ * frame time close to a target. Render cost is taken to be proportional to
+ * the number of pixels, and changes are damped so the resolution doesn't
+ * flicker between neighbouring values.
+ */
+class FrameRateGovernor
+{
+public:
+    FrameRateGovernor();
+
+    /// A target of 0 disables the governor.
+    void setTargetFrameTime(double seconds) { mTargetFrameTime = seconds; }
+    bool isEnabled() const { return mTargetFrameTime > 0.0; }
+
+    /// Forgets measured frame times and returns to full resolution.
+    void reset();
+
+    /// Takes the time the last frame took and returns the divisor to render
+    /// the next one at, 1 being full resolution.
+    float update(double frameTime);
+
+    float getScale() const { return mScale; }
+
+private:
+    double mTargetFrameTime;
+    double mAverageFrameTime;
+    float mScale;
+};
+
+} // namespace moonray_gui
+
@@ -0,0 +1,143 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+/// @file FrameSnapshot.cc
+
+#include "FrameSnapshot.h"
+#include "BufferPool.h"
+
+#include <moonray/rendering/rndr/RenderOutputDriver.h>
+#include <moonray/rendering/rndr/rndr.h>
+#include <scene_rdl2/scene/rdl2/RenderOutput.h>
+#include <scene_rdl2/scene/rdl2/SceneVariables.h>
+
+#include <string>
+#include <vector>
+
+namespace moonray_gui {
+
+namespace {
+
+unsigned
+getNumChannels(const scene_rdl2::fb_util::VariablePixelBuffer &buffer)
+{
+    switch (buffer.getFormat()) {
+    case scene_rdl2::fb_util::VariablePixelBuffer::FLOAT:  return 1;
+    case scene_rdl2::fb_util::VariablePixelBuffer::FLOAT2: return 2;
+    case scene_rdl2::fb_util::VariablePixelBuffer::FLOAT3: return 3;
+    case scene_rdl2::fb_util::VariablePixelBuffer::FLOAT4: return 4;
+    default:                                               return 0;
+    }
+}
+
+// Channel names the way the renderer names them: the channel name alone for
+// a single channel, otherwise with a suffix per channel picked by the
+// output's channel_suffix_mode.
+std::vector<std::string>
+getChannelNames(const scene_rdl2::rdl2::RenderOutput &ro, unsigned numChannels)
+{
+    using scene_rdl2::rdl2::RenderOutput;
+
+    const std::string name = ro.getChannelName().empty() ? ro.getName() : ro.getChannelName();
+    if (numChannels == 1) {
+        return {name};
+    }
+
+    const char *suffixes = "XYZW";
+    switch (ro.getChannelSuffixMode()) {
+    case RenderOutput::SUFFIX_MODE_RGB:
+        suffixes = "RGBA";
+        break;
+    case RenderOutput::SUFFIX_MODE_UVW:
+        suffixes = "UVWA";
+        break;
+    case RenderOutput::SUFFIX_MODE_AUTO:
+        switch (ro.getResult()) {
+        case RenderOutput::RESULT_BEAUTY:
+        case RenderOutput::RESULT_BEAUTY_AUX:
+        case RenderOutput::RESULT_MATERIAL_AOV:
+        case RenderOutput::RESULT_LIGHT_AOV:
+        case RenderOutput::RESULT_DISPLAY_FILTER:
+            suffixes = "RGBA";
+            break;
+        default:
+            break;
+        }
+        break;
+    default:
+        break;
+    }
+
+    std::vector<std::string> names;
+    for (unsigned c = 0; c < numChannels; ++c) {
+        names.push_back(name + "." + suffixes[c]);
+    }
+    return names;
+}
+
+std::string
+getCompression(const scene_rdl2::rdl2::RenderOutput &ro)
+{
+    using scene_rdl2::rdl2::RenderOutput;
+
+    switch (ro.getCompression()) {
+    case RenderOutput::COMPRESSION_NONE:  return "none";
+    case RenderOutput::COMPRESSION_RLE:   return "rle";
+    case RenderOutput::COMPRESSION_ZIPS:  return "zips";
+    case RenderOutput::COMPRESSION_PIZ:   return "piz";
+    case RenderOutput::COMPRESSION_PXR24: return "pxr24";
+    case RenderOutput::COMPRESSION_B44:   return "b44";
+    case RenderOutput::COMPRESSION_B44A:  return "b44a";
+    case RenderOutput::COMPRESSION_DWAA:  return "dwaa:" + std::to_string(int(ro.getCompressionLevel()));
+    case RenderOutput::COMPRESSION_DWAB:  return "dwab:" + std::to_string(int(ro.getCompressionLevel()));
+    default:                              return "zip";
+    }
+}
+
+} // anonymous namespace
+
+void
+FrameSnapshot::capture(const moonray::rndr::RenderContext &context, bool parallel)
+{
+    context.snapshotRenderBuffer(&mRenderBuffer, /*untile*/ true, parallel);
+    context.snapshotHeatMapBuffer(&mHeatMapBuffer, /*untile*/ true, parallel);
+    context.snapshotWeightBuffer(&mWeightBuffer, /*untile*/ true, parallel);
+    context.snapshotRenderBufferOdd(&mRenderBufferOdd, /*untile*/ true, parallel);
+
+    const scene_rdl2::rdl2::SceneVariables &vars = context.getSceneContext().getSceneVariables();
+    mOutputFilename = vars.get(scene_rdl2::rdl2::SceneVariables::sOutputFile);
+    mMetadata = vars.getExrHeaderAttributes();
+    mAperture = context.getRezedApertureWindow();
+    mRegion = context.getRezedRegionWindow();
+
+    const moonray::rndr::RenderOutputDriver *rod = context.getRenderOutputDriver();
+    const unsigned numRenderOutputs = rod ? rod->getNumberOfRenderOutputs() : 0;
+    mRenderOutputs.resize(numRenderOutputs);
+    for (unsigned i = 0; i < numRenderOutputs; ++i) {
+        RenderOutputSnapshot &output = mRenderOutputs[i];
+        context.snapshotRenderOutput(&output.mBuffer, int(i),
+                                     &mRenderBuffer, &mHeatMapBuffer, &mWeightBuffer, &mRenderBufferOdd,
+                                     /*untile*/ true, parallel);
+
+        const scene_rdl2::rdl2::RenderOutput &ro = *rod->getRenderOutput(i);
+        output.mFileName = ro.getFileName();
+        output.mFilePart = ro.getFilePart();
+        output.mChannelNames = getChannelNames(ro, getNumChannels(output.mBuffer));
+        output.mHalf = ro.getChannelFormat() == scene_rdl2::rdl2::RenderOutput::CHANNEL_FORMAT_HALF;
+        output.mCompression = getCompression(ro);
+        output.mMetadata = ro.getExrHeaderAttributes();
+    }
+}
+
+size_t
+FrameSnapshot::getMemoryUsage() const
+{
+    size_t size = getBufferSize(mRenderBuffer) + getBufferSize(mHeatMapBuffer) +
+                  getBufferSize(mWeightBuffer) + getBufferSize(mRenderBufferOdd);
+    for (const auto &output : mRenderOutputs) {
+        size += getBufferSize(output.mBuffer);
+    }
+    return size;
+}
+
+} // namespace moonray_gui
@@ -0,0 +1,70 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+/// @file FrameSnapshot.h
+
+#pragma once
+
+#include <scene_rdl2/common/fb_util/FbTypes.h>
+#include <scene_rdl2/common/fb_util/VariablePixelBuffer.h>
+#include <scene_rdl2/common/math/Viewport.h>
+#include <scene_rdl2/scene/rdl2/SceneObject.h>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace moonray {
+namespace rndr {
+class RenderContext;
+}
+}
+
+namespace moonray_gui {
+
+/**
+ * A render output as it is written out: its finished pixels and everything
+ * the output writer needs to know about where they go, so writing doesn't
+ * depend on the render output driver, which the next frame may rebuild.
+ */
+struct RenderOutputSnapshot
+{
+    scene_rdl2::fb_util::VariablePixelBuffer mBuffer;
+
+    std::string                              mFileName;
+    std::string                              mFilePart;
+    std::vector<std::string>                 mChannelNames;
+    bool                                     mHalf = false;
+    std::string                              mCompression;
+    const scene_rdl2::rdl2::SceneObject     *mMetadata = nullptr;
+};
+
+/**
+ * All the buffers of a completed frame, snapshotted once and shared between
+ * the display and the output writer.
+ */
+struct FrameSnapshot
+{
+    /// Untiles every buffer needed to display or write out the current frame
+    /// of context, along with the details needed to write it. Render outputs
+    /// are finished here too, while the frame is stopped.
+    void capture(const moonray::rndr::RenderContext &context, bool parallel);
+
+    /// Bytes held by the buffers.
+    size_t getMemoryUsage() const;
+
+    scene_rdl2::fb_util::RenderBuffer                     mRenderBuffer;
+    scene_rdl2::fb_util::HeatMapBuffer                    mHeatMapBuffer;
+    scene_rdl2::fb_util::FloatBuffer                      mWeightBuffer;
+    scene_rdl2::fb_util::RenderBuffer                     mRenderBufferOdd;
+    std::vector<RenderOutputSnapshot>                     mRenderOutputs;
+
+    // Metadata points into the scene, see OutputWriter.
+    std::string                                 mOutputFilename;
+    const scene_rdl2::rdl2::SceneObject        *mMetadata = nullptr;
+    scene_rdl2::math::HalfOpenViewport          mAperture;
+    scene_rdl2::math::HalfOpenViewport          mRegion;
+};
+
+} // namespace moonray_gui
+
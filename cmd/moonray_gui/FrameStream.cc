@@ -0,0 +1,513 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+/// @file FrameStream.cc
+
+#include "FrameStream.h"
+
+#include <scene_rdl2/render/logging/logging.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <new>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Size of the square tiles frames are published in. Frame tiles are compared
+// against what was last published, so smaller tiles send less of a frame
+// which is only partly changing.
+#define FRAME_STREAM_TILE_SIZE      32
+
+// The ring holds this many frames' worth of tiles, so a viewer has a whole
+// frame of publishing to catch up in before it is lapped.
+#define FRAME_STREAM_RING_FRAMES    2
+
+#define FRAME_STREAM_MAGIC          0x4d475346 // "MGSF"
+#define FRAME_STREAM_VERSION        1
+
+namespace moonray_gui {
+
+using scene_rdl2::fb_util::RenderBuffer;
+using scene_rdl2::fb_util::RenderColor;
+using scene_rdl2::math::Mat4f;
+
+/// Start of the shared memory segment, followed by mNumSlots slots.
+struct FrameStreamHeader
+{
+    std::atomic<uint32_t> mMagic; // written last, once the rest is valid
+    uint32_t mVersion;
+    uint32_t mWidth;
+    uint32_t mHeight;
+    uint32_t mTileSize;
+    uint32_t mNumSlots;
+    float mCameraXform[16];
+
+    /// Number of tiles published. Tile n lives in slot n % mNumSlots.
+    alignas(64) std::atomic<uint64_t> mWriteCount;
+};
+
+namespace {
+
+/// A tile in the ring, followed by its pixels, rows from the bottom.
+struct Slot
+{
+    /// 2n + 1 while tile n is being written into the slot, 2n + 2 once it
+    /// is complete.
+    std::atomic<uint64_t> mSequence;
+    uint32_t mX;
+    uint32_t mY;
+    uint32_t mWidth;
+    uint32_t mHeight;
+};
+
+inline size_t
+alignUp(size_t size)
+{
+    return (size + 63) & ~size_t(63);
+}
+
+inline size_t
+getSlotSize(unsigned tileSize)
+{
+    return alignUp(sizeof(Slot)) + size_t(tileSize) * tileSize * sizeof(RenderColor);
+}
+
+inline size_t
+getSegmentSize(unsigned tileSize, unsigned numSlots)
+{
+    return alignUp(sizeof(FrameStreamHeader)) + getSlotSize(tileSize) * numSlots;
+}
+
+inline Slot *
+getSlot(FrameStreamHeader *header, uint64_t n)
+{
+    char *slots = reinterpret_cast<char *>(header) + alignUp(sizeof(FrameStreamHeader));
+    return reinterpret_cast<Slot *>(slots + getSlotSize(header->mTileSize) * (n % header->mNumSlots));
+}
+
+inline RenderColor *
+getPixels(Slot *slot)
+{
+    return reinterpret_cast<RenderColor *>(reinterpret_cast<char *>(slot) + alignUp(sizeof(Slot)));
+}
+
+// Names are used in the shared memory name and socket path, so may not hold
+// path separators.
+bool
+getPaths(const std::string &name, std::string *shmName, std::string *socketPath)
+{
+    if (name.empty() || name.find('/') != std::string::npos) {
+        scene_rdl2::logging::Logger::error("Invalid frame stream name \"", name, "\"");
+        return false;
+    }
+    *shmName = "/moonray_gui_" + name;
+    *socketPath = "/tmp/moonray_gui_" + name + ".sock";
+    if (socketPath->size() >= sizeof(sockaddr_un::sun_path)) {
+        scene_rdl2::logging::Logger::error("Frame stream name \"", name, "\" is too long");
+        return false;
+    }
+    return true;
+}
+
+sockaddr_un
+makeAddress(const std::string &path)
+{
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    return address;
+}
+
+}
+
+FrameStreamServer::FrameStreamServer() :
+    mHeader(nullptr),
+    mMappedSize(0),
+    mListenSocket(-1),
+    mPublishAll(true)
+{
+}
+
+FrameStreamServer::~FrameStreamServer()
+{
+    close();
+}
+
+bool
+FrameStreamServer::open(const std::string &name, unsigned width, unsigned height, const Mat4f &cameraXform)
+{
+    close();
+    if (!getPaths(name, &mShmName, &mSocketPath)) {
+        return false;
+    }
+
+    const unsigned tileSize = FRAME_STREAM_TILE_SIZE;
+    const unsigned numTiles = ((width + tileSize - 1) / tileSize) * ((height + tileSize - 1) / tileSize);
+    const unsigned numSlots = std::max(numTiles, 1u) * FRAME_STREAM_RING_FRAMES;
+    const size_t size = getSegmentSize(tileSize, numSlots);
+
+    // Anything still here was left by a server which didn't exit cleanly.
+    // Viewers still attached to it keep their mapping until they notice.
+    shm_unlink(mShmName.c_str());
+    const int fd = shm_open(mShmName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+        scene_rdl2::logging::Logger::error("Unable to create shared memory ", mShmName, ": ", std::strerror(errno));
+        return false;
+    }
+    void *data = MAP_FAILED;
+    if (ftruncate(fd, off_t(size)) == 0) {
+        data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        scene_rdl2::logging::Logger::error("Unable to map shared memory ", mShmName, ": ", std::strerror(errno));
+        shm_unlink(mShmName.c_str());
+        return false;
+    }
+    mMappedSize = size;
+
+    // The segment comes zero filled, so every slot starts at sequence 0.
+    mHeader = new (data) FrameStreamHeader;
+    mHeader->mVersion = FRAME_STREAM_VERSION;
+    mHeader->mWidth = width;
+    mHeader->mHeight = height;
+    mHeader->mTileSize = tileSize;
+    mHeader->mNumSlots = numSlots;
+    std::memcpy(mHeader->mCameraXform, &cameraXform.vx.x, sizeof(mHeader->mCameraXform));
+    mHeader->mWriteCount.store(0, std::memory_order_relaxed);
+    mHeader->mMagic.store(FRAME_STREAM_MAGIC, std::memory_order_release);
+
+    unlink(mSocketPath.c_str());
+    mListenSocket = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    const sockaddr_un address = makeAddress(mSocketPath);
+    if (mListenSocket < 0 ||
+        bind(mListenSocket, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0 ||
+        listen(mListenSocket, 8) != 0) {
+        scene_rdl2::logging::Logger::error("Unable to listen on ", mSocketPath, ": ", std::strerror(errno));
+        close();
+        return false;
+    }
+
+    mPublished.init(width, height);
+    mPublishAll = true;
+    std::cout << "Publishing " << width << "x" << height << " frames to " << mShmName
+              << ", listening on " << mSocketPath << std::endl;
+    return true;
+}
+
+void
+FrameStreamServer::close()
+{
+    for (int viewer : mViewerSockets) {
+        ::close(viewer);
+    }
+    mViewerSockets.clear();
+    if (mListenSocket >= 0) {
+        ::close(mListenSocket);
+        unlink(mSocketPath.c_str());
+        mListenSocket = -1;
+    }
+    if (mHeader) {
+        munmap(mHeader, mMappedSize);
+        shm_unlink(mShmName.c_str());
+        mHeader = nullptr;
+    }
+}
+
+void
+FrameStreamServer::publish(const RenderBuffer &frame)
+{
+    if (!mHeader) return;
+    const unsigned w = frame.getWidth();
+    const unsigned h = frame.getHeight();
+    if (w != mHeader->mWidth || h != mHeader->mHeight) {
+        scene_rdl2::logging::Logger::error("Frame is ", w, "x", h, " but the frame stream is ",
+                                           mHeader->mWidth, "x", mHeader->mHeight);
+        return;
+    }
+
+    const unsigned tileSize = mHeader->mTileSize;
+    for (unsigned y0 = 0; y0 < h; y0 += tileSize) {
+        const unsigned th = std::min(tileSize, h - y0);
+        for (unsigned x0 = 0; x0 < w; x0 += tileSize) {
+            const unsigned tw = std::min(tileSize, w - x0);
+            bool changed = mPublishAll;
+            for (unsigned y = y0; y < y0 + th && !changed; ++y) {
+                changed = std::memcmp(frame.getRow(y) + x0, mPublished.getRow(y) + x0,
+                                      tw * sizeof(RenderColor)) != 0;
+            }
+            if (changed) {
+                publishTile(frame, x0, y0, tw, th);
+            }
+        }
+    }
+    mPublishAll = false;
+}
+
+void
+FrameStreamServer::publishTile(const RenderBuffer &frame, unsigned x0, unsigned y0, unsigned w, unsigned h)
+{
+    const uint64_t n = mHeader->mWriteCount.load(std::memory_order_relaxed);
+    Slot *slot = getSlot(mHeader, n);
+    slot->mSequence.store(2 * n + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot->mX = x0;
+    slot->mY = y0;
+    slot->mWidth = w;
+    slot->mHeight = h;
+    RenderColor *pixels = getPixels(slot);
+    for (unsigned y = 0; y < h; ++y) {
+        const RenderColor *src = frame.getRow(y0 + y) + x0;
+        std::memcpy(pixels + size_t(y) * w, src, w * sizeof(RenderColor));
+        std::memcpy(mPublished.getRow(y0 + y) + x0, src, w * sizeof(RenderColor));
+    }
+
+    slot->mSequence.store(2 * n + 2, std::memory_order_release);
+    mHeader->mWriteCount.store(n + 1, std::memory_order_release);
+}
+
+void
+FrameStreamServer::acceptViewers()
+{
+    for (;;) {
+        const int viewer = accept4(mListenSocket, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (viewer < 0) {
+            break;
+        }
+        mViewerSockets.push_back(viewer);
+        std::cout << "Viewer attached to " << mSocketPath << std::endl;
+    }
+}
+
+void
+FrameStreamServer::receiveCommands(std::vector<FrameStreamCommand> *commands)
+{
+    if (mListenSocket < 0) return;
+    acceptViewers();
+
+    for (auto it = mViewerSockets.begin(); it != mViewerSockets.end(); ) {
+        bool closed = false;
+        for (;;) {
+            FrameStreamCommand command;
+            const ssize_t received = recv(*it, &command, sizeof(command), MSG_DONTWAIT);
+            if (received == sizeof(command)) {
+                if (command.mType == FrameStreamCommand::RESEND) {
+                    mPublishAll = true;
+                }
+                commands->push_back(command);
+            } else if (received == 0 || (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+                closed = true;
+                break;
+            } else if (received < 0) {
+                break;
+            }
+            // Anything else is a truncated message, which is dropped.
+        }
+
+        if (closed) {
+            ::close(*it);
+            it = mViewerSockets.erase(it);
+            std::cout << "Viewer detached from " << mSocketPath << std::endl;
+        } else {
+            ++it;
+        }
+    }
+}
+
+FrameStreamClient::FrameStreamClient() :
+    mHeader(nullptr),
+    mMappedSize(0),
+    mSocket(-1),
+    mReadCount(0)
+{
+}
+
+FrameStreamClient::~FrameStreamClient()
+{
+    detach();
+}
+
+bool
+FrameStreamClient::attach(const std::string &name)
+{
+    detach();
+    std::string shmName, socketPath;
+    if (!getPaths(name, &shmName, &socketPath)) {
+        return false;
+    }
+
+    // Not finding the server isn't an error, it may not have started yet.
+    const int fd = shm_open(shmName.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    void *data = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && size_t(st.st_size) >= sizeof(FrameStreamHeader)) {
+        data = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+    FrameStreamHeader *header = static_cast<FrameStreamHeader *>(data);
+    if (header->mMagic.load(std::memory_order_acquire) != FRAME_STREAM_MAGIC ||
+        header->mVersion != FRAME_STREAM_VERSION ||
+        getSegmentSize(header->mTileSize, header->mNumSlots) > size_t(st.st_size)) {
+        munmap(data, size_t(st.st_size));
+        return false;
+    }
+
+    mSocket = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    const sockaddr_un address = makeAddress(socketPath);
+    if (mSocket < 0 || connect(mSocket, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0) {
+        if (mSocket >= 0) {
+            ::close(mSocket);
+            mSocket = -1;
+        }
+        munmap(data, size_t(st.st_size));
+        return false;
+    }
+
+    mHeader = header;
+    mMappedSize = size_t(st.st_size);
+
+    // Start from the tiles published from now on, with every tile of the
+    // frame among them.
+    mReadCount = mHeader->mWriteCount.load(std::memory_order_acquire);
+    FrameStreamCommand command = {};
+    command.mType = FrameStreamCommand::RESEND;
+    send(command);
+
+    if (mHeader) {
+        std::cout << "Attached to " << mHeader->mWidth << "x" << mHeader->mHeight
+                  << " frame stream " << shmName << std::endl;
+    }
+    return mHeader != nullptr;
+}
+
+void
+FrameStreamClient::detach()
+{
+    if (mSocket >= 0) {
+        ::close(mSocket);
+        mSocket = -1;
+    }
+    if (mHeader) {
+        munmap(mHeader, mMappedSize);
+        mHeader = nullptr;
+    }
+}
+
+Mat4f
+FrameStreamClient::getCameraXform() const
+{
+    Mat4f xform(scene_rdl2::math::one);
+    if (mHeader) {
+        std::memcpy(&xform.vx.x, mHeader->mCameraXform, sizeof(mHeader->mCameraXform));
+    }
+    return xform;
+}
+
+bool
+FrameStreamClient::update(RenderBuffer *frame)
+{
+    if (!mHeader) return false;
+
+    // The server never sends anything, so the socket only becomes readable
+    // once it has closed, which the kernel does for us if it crashes.
+    char byte;
+    if (recv(mSocket, &byte, 1, MSG_PEEK | MSG_DONTWAIT) == 0) {
+        scene_rdl2::logging::Logger::error("Render server has gone away");
+        detach();
+        return false;
+    }
+
+    const unsigned w = mHeader->mWidth;
+    const unsigned h = mHeader->mHeight;
+    bool changed = false;
+    if (frame->getWidth() != w || frame->getHeight() != h) {
+        frame->init(w, h);
+        frame->clear();
+        changed = true;
+    }
+
+    const uint64_t writeCount = mHeader->mWriteCount.load(std::memory_order_acquire);
+    for (; mReadCount < writeCount; ++mReadCount) {
+        const uint64_t n = mReadCount;
+        Slot *slot = getSlot(mHeader, n);
+
+        // Copy the tile out, then check the server didn't start writing over
+        // it while we did.
+        const uint64_t sequence = slot->mSequence.load(std::memory_order_acquire);
+        bool lapped = sequence != 2 * n + 2;
+        if (!lapped) {
+            const unsigned x0 = slot->mX;
+            const unsigned y0 = slot->mY;
+            const unsigned tw = slot->mWidth;
+            const unsigned th = slot->mHeight;
+            if (x0 + tw <= w && y0 + th <= h && tw <= mHeader->mTileSize && th <= mHeader->mTileSize) {
+                const RenderColor *pixels = getPixels(slot);
+                for (unsigned y = 0; y < th; ++y) {
+                    std::memcpy(frame->getRow(y0 + y) + x0, pixels + size_t(y) * tw, tw * sizeof(RenderColor));
+                }
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            lapped = slot->mSequence.load(std::memory_order_relaxed) != sequence;
+        }
+        changed = true;
+
+        if (lapped) {
+            // Some tiles are lost; skip to the present and have them all
+            // published again.
+            mReadCount = mHeader->mWriteCount.load(std::memory_order_acquire);
+            FrameStreamCommand command = {};
+            command.mType = FrameStreamCommand::RESEND;
+            send(command);
+            break;
+        }
+    }
+    return changed;
+}
+
+void
+FrameStreamClient::sendCamera(const Mat4f &xform)
+{
+    FrameStreamCommand command = {};
+    command.mType = FrameStreamCommand::CAMERA;
+    std::memcpy(command.mXform, &xform.vx.x, sizeof(command.mXform));
+    send(command);
+}
+
+void
+FrameStreamClient::sendRenderMode(bool fastProgressive, moonray::rndr::FastRenderMode fastMode)
+{
+    FrameStreamCommand command = {};
+    command.mType = FrameStreamCommand::RENDER_MODE;
+    command.mFastProgressive = fastProgressive ? 1 : 0;
+    command.mFastMode = uint32_t(fastMode);
+    send(command);
+}
+
+void
+FrameStreamClient::send(const FrameStreamCommand &command)
+{
+    if (mSocket < 0) return;
+    if (::send(mSocket, &command, sizeof(command), MSG_NOSIGNAL) != ssize_t(sizeof(command))) {
+        scene_rdl2::logging::Logger::error("Render server has gone away: ", std::strerror(errno));
+        detach();
+    }
+}
+
+} // namespace moonray_gui
+
@@ -0,0 +1,127 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+/// @file FrameStream.h
+
+#pragma once
+
+#include <moonray/rendering/rndr/rndr.h>
+#include <scene_rdl2/common/fb_util/FbTypes.h>
+#include <scene_rdl2/common/math/Mat4.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace moonray_gui {
+
+struct FrameStreamHeader;
+
+/// A message sent from a viewer to the render server.
+struct FrameStreamCommand
+{
+    enum Type : uint32_t
+    {
+        CAMERA,         // render from mXform
+        RENDER_MODE,    // switch between progressive and fast progressive
+        RESEND,         // the viewer fell behind, publish every tile again
+    };
+
+    Type mType;
+    float mXform[16];
+    uint32_t mFastProgressive;
+    uint32_t mFastMode;
+};
+
+/**
+ * The render side of a frame stream. The frame being rendered is published
+ * tile by tile into a ring in a POSIX shared memory segment, which any
+ * number of viewers on the same machine can read without copies through
+ * the kernel. Only tiles which changed since they were last published are
+ * written. Viewers send commands back over a Unix domain socket.
+ *
+ * Each slot of the ring is guarded by a sequence number which is odd while
+ * the slot is being written, so a viewer which is lapped by the server can
+ * tell and ask for everything to be published again.
+ */
+class FrameStreamServer
+{
+public:
+    FrameStreamServer();
+    ~FrameStreamServer();
+
+    /// Creates the shared memory segment and socket for name, replacing any
+    /// left behind by a server which died, for width x height frames.
+    /// cameraXform is the scene camera, which viewers start navigating
+    /// from. Returns false on failure.
+    bool open(const std::string &name, unsigned width, unsigned height,
+              const scene_rdl2::math::Mat4f &cameraXform);
+    void close();
+
+    /// Publishes the tiles of frame, rows from the bottom, which differ from
+    /// those last published, or every tile if a viewer has asked for them.
+    void publish(const scene_rdl2::fb_util::RenderBuffer &frame);
+
+    /// Accepts waiting viewers and appends the commands they have sent.
+    void receiveCommands(std::vector<FrameStreamCommand> *commands);
+
+private:
+    void acceptViewers();
+    void publishTile(const scene_rdl2::fb_util::RenderBuffer &frame, unsigned x0, unsigned y0,
+                     unsigned w, unsigned h);
+
+    std::string mShmName;
+    std::string mSocketPath;
+    FrameStreamHeader *mHeader;
+    size_t mMappedSize;
+    int mListenSocket;
+    std::vector<int> mViewerSockets;
+
+    /// Copy of every tile as it was last published, for finding changes.
+    scene_rdl2::fb_util::RenderBuffer mPublished;
+    bool mPublishAll;
+};
+
+/**
+ * The viewer side of a frame stream, which keeps a local copy of the frame
+ * being published by a FrameStreamServer up to date.
+ */
+class FrameStreamClient
+{
+public:
+    FrameStreamClient();
+    ~FrameStreamClient();
+
+    /// Maps the shared memory segment and connects to the server for name.
+    /// Returns false if there is no server running.
+    bool attach(const std::string &name);
+    void detach();
+
+    /// False before attach, and once the server has gone away.
+    bool isAttached() const { return mHeader != nullptr; }
+
+    /// The scene camera transform the server was started with.
+    scene_rdl2::math::Mat4f getCameraXform() const;
+
+    /// Copies tiles published since the last call into frame, rows from the
+    /// bottom, sizing it to the server's frames. Returns true if frame
+    /// changed. Detaches if the server has exited.
+    bool update(scene_rdl2::fb_util::RenderBuffer *frame);
+
+    void sendCamera(const scene_rdl2::math::Mat4f &xform);
+    void sendRenderMode(bool fastProgressive, moonray::rndr::FastRenderMode fastMode);
+
+private:
+    void send(const FrameStreamCommand &command);
+
+    FrameStreamHeader *mHeader;
+    size_t mMappedSize;
+    int mSocket;
+
+    /// Number of tiles published before the next one to read.
+    uint64_t mReadCount;
+};
+
+} // namespace moonray_gui
+
@@ -5,21 +5,47 @@
 
 #include <moonray/rendering/rndr/rndr.h>
 
+#include "FrameSnapshot.h"
 #include "GuiTypes.h"
+#include "TileProgress.h"
 
 #include <QEvent>
+#include <QImage>
+#include <QString>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
 namespace moonray_gui {
 
+/// A render output shown next to the main frame in multi-pane mode, already
+/// converted for display.
+struct DisplayPane
+{
+    QImage mImage;
+    QString mLabel;
+};
+
 class FrameUpdateEvent : public QEvent
 {
 public:
-    FrameUpdateEvent(const FrameBuffer &frame, FrameType frameType, DebugMode mode, float exposure, float gamma):
+    /// tileProgress, if given, is drawn over the frame. snapshot, if given,
+    /// is kept alive until the frame has been displayed since frame may point
+    /// into it.
+    FrameUpdateEvent(const FrameBuffer &frame, FrameType frameType, DebugMode mode, float exposure, float gamma,
+                     std::shared_ptr<const TileProgress> tileProgress = nullptr,
+                     std::shared_ptr<const FrameSnapshot> snapshot = nullptr):
         QEvent(FrameUpdateEvent::type()),
         mFrame(frame),
         mFrameType(frameType),
         mDebugMode(mode),
         mExposure(exposure),
-        mGamma(gamma)
+        mGamma(gamma),
+        mTileProgress(std::move(tileProgress)),
+        mSnapshot(std::move(snapshot)),
+        mDisplayScale(1.f),
+        mFrameNumber(0)
     {
     }
 
@@ -28,6 +54,28 @@ public:
     DebugMode getDebugMode() const { return mDebugMode; }
     float getExposure() const { return mExposure; }
     float getGamma() const { return mGamma; }
+    const std::shared_ptr<const TileProgress> &getTileProgress() const { return mTileProgress; }
+
+    /// Factor to enlarge the frame by for display, for frames rendered at
+    /// reduced resolution.
+    float getDisplayScale() const { return mDisplayScale; }
+    void setDisplayScale(float scale) { mDisplayScale = scale; }
+
+    /// Render outputs to show alongside the frame, empty outside multi-pane
+    /// mode, and the label for the frame's own pane.
+    const std::vector<DisplayPane> &getPanes() const { return mPanes; }
+    const QString &getFrameLabel() const { return mFrameLabel; }
+    void setPanes(std::vector<DisplayPane> panes, const QString &frameLabel)
+    {
+        mPanes = std::move(panes);
+        mFrameLabel = frameLabel;
+    }
+
+    /// Counts the frames sent for display, to match the displayed frame up
+    /// with the linear one it was made from.
+    uint64_t getFrameNumber() const { return mFrameNumber; }
+    void setFrameNumber(uint64_t frameNumber) { mFrameNumber = frameNumber; }
+
     static QEvent::Type type() { return sEventType; }
 
 private:
@@ -36,6 +84,12 @@ private:
     DebugMode mDebugMode;
     float mExposure;
     float mGamma;
+    std::shared_ptr<const TileProgress> mTileProgress;
+    std::shared_ptr<const FrameSnapshot> mSnapshot;
+    float mDisplayScale;
+    uint64_t mFrameNumber;
+    std::vector<DisplayPane> mPanes;
+    QString mFrameLabel;
     static QEvent::Type sEventType;
 };
 
@@ -173,8 +173,37 @@ uniform int channel;
 uniform int width;
 uniform int height;
 
+// tile progress: the time each 8x8 tile was last rendered to
+uniform sampler2D tileTimes;
+uniform int showTiles;
+uniform float tileTime;
+uniform float tileFadeTime;
+uniform float tileIntensity;
+
+// brightness to add for the tile progress outline at pixel p
+float tileOutline(const in ivec2 p)
+{
+    ivec2 q = p % 8;
+    if (q.x != 0 && q.x != 7 && q.y != 0 && q.y != 7 && p.x != width - 1 && p.y != height - 1) {
+        return 0.0;
+    }
+    float age = tileTime - texelFetch(tileTimes, p / 8, 0).r;
+    if (age <= 0.0) {
+        return tileIntensity;
+    }
+    // tiles no longer being rendered drop to a dimmer outline first
+    return tileIntensity * 0.6 * max(1.0 - age / tileFadeTime, 0.0);
+}
+
 void main() {
     vec4 t = texture(textureSampler, uv);
+    if (showTiles != 0) {
+        ivec2 p = min(ivec2(uv * vec2(width, height)), ivec2(width - 1, height - 1));
+        float outline = tileOutline(p);
+        if (outline > 0.0) {
+            t.rgb = clamp(t.rgb + vec3(outline), 0.0, 1.0);
+        }
+    }
     vec2 pos;
     pos.x = uv.x * (width - 1);
     pos.y = uv.y * (height - 1);
@@ -215,6 +244,11 @@ GlslBuffer::GlslBuffer(int width, int height, const float *lutOverride):
     mChannel(INVALID_HANDLE),
     mExposure(0.f),
     mGamma(1.f),
+    mTileTexture(INVALID_HANDLE),
+    mShowTiles(-1),
+    mTileTime(-1),
+    mTileFadeTime(-1),
+    mTileIntensity(-1),
     mLutOverride(lutOverride)
 {
     // all our programs require the same vertex shader,
@@ -277,6 +311,9 @@ GlslBuffer::~GlslBuffer()
     // cleanup vertex shader
     // TODO: does this happen automatically when the context is destroyed?
     glDeleteShader(mVertexShaderID);
+    if (mTileTexture != INVALID_HANDLE) {
+        glDeleteTextures(1, &mTileTexture);
+    }
 }
 
 // LINEAR RGBA -> CRT -> GAMMA -> RGB
@@ -404,13 +441,31 @@ GlslBuffer::makeCrtGammaProgram()
     var = glGetUniformLocation(mProgram, "height");
     glUniform1i(var, mHeight);
 
+    // tile progress overlay, off until we're given some
+    {
+        int textureUnit = 4;  // 0 = main image, 1 = pre1d, 2 = post1d, 3 = 3dlut, 4 = tile times
+        glActiveTexture(GL_TEXTURE0 + textureUnit);
+        if (mTileTexture == INVALID_HANDLE) {
+            glGenTextures(1, &mTileTexture);
+        }
+        glBindTexture(GL_TEXTURE_2D, mTileTexture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glUniform1i(glGetUniformLocation(mProgram, "tileTimes"), textureUnit);
+        glActiveTexture(GL_TEXTURE0);
+    }
+    mShowTiles = glGetUniformLocation(mProgram, "showTiles");
+    glUniform1i(mShowTiles, 0);
+    mTileTime = glGetUniformLocation(mProgram, "tileTime");
+    mTileFadeTime = glGetUniformLocation(mProgram, "tileFadeTime");
+    mTileIntensity = glGetUniformLocation(mProgram, "tileIntensity");
 
     mPixelBuffer.doneCurrent();
 }
 
 void
 GlslBuffer::render(const FrameBuffer &frame, FrameType frameType, DebugMode mode,
-                   float exposure, float gamma)
+                   float exposure, float gamma, const TileProgress *tileProgress)
 {
     mPixelBuffer.makeCurrent();
 
@@ -459,6 +514,20 @@ GlslBuffer::render(const FrameBuffer &frame, FrameType frameType, DebugMode mode
     }
 
     glUseProgram(mProgram);
+
+    // send tile progress to gpu, one texel per tile
+    glUniform1i(mShowTiles, tileProgress ? 1 : 0);
+    if (tileProgress) {
+        glActiveTexture(GL_TEXTURE4);
+        glBindTexture(GL_TEXTURE_2D, mTileTexture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, tileProgress->mTilesX, tileProgress->mTilesY, 0,
+                     GL_RED, GL_FLOAT, tileProgress->mTileTimes.data());
+        glActiveTexture(GL_TEXTURE0);
+        glUniform1f(mTileTime, tileProgress->mTime);
+        glUniform1f(mTileFadeTime, tileProgress->mFadeTime);
+        glUniform1f(mTileIntensity, tileProgress->mIntensity);
+    }
+
     glDrawArrays(GL_QUADS, 0, 4);
 
     glDisableVertexAttribArray(0);
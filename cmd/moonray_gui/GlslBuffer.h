@@ -6,6 +6,7 @@
 #pragma once
 
 #include "GuiTypes.h"
+#include "TileProgress.h"
 
 #include <QGLPixelBuffer>
 
@@ -22,12 +23,17 @@ public:
     void makeCrtGammaProgram();
 
     // render to pixel buffer, input should
-    // be a linear RenderBuffer
-    void render(const FrameBuffer &frame, FrameType frameType, DebugMode mode, float exposure, float gamma);
+    // be a linear RenderBuffer. tile progress
+    // outlines are drawn over it if given
+    void render(const FrameBuffer &frame, FrameType frameType, DebugMode mode, float exposure, float gamma,
+                const TileProgress *tileProgress = nullptr);
 
     // return pixel buffer as a QImage
     QImage asImage() const;
 
+    int getWidth() const { return mWidth; }
+    int getHeight() const { return mHeight; }
+
 private:
     int            mWidth;
     int            mHeight;
@@ -41,6 +47,13 @@ private:
     GLfloat        mExposure;
     GLfloat        mGamma;
 
+    // per tile timestamps for the tile progress overlay
+    GLuint         mTileTexture;
+    GLint          mShowTiles;
+    GLint          mTileTime;
+    GLint          mTileFadeTime;
+    GLint          mTileIntensity;
+
     // Color render override LUT. Set to nullptr if we aren't overriding
     // the LUT. This binary blob is assumed to contain 64*64*64 * RGB float
     // OpenGL compatible volume texture data.
@@ -61,6 +61,15 @@ enum DenoisingBufferMode
     NUM_DENOISING_BUFFER_MODES,
 };
 
+// How a frame from the snapshot history is shown against the live render.
+enum CompareMode
+{
+    COMPARE_OFF,
+    COMPARE_TOGGLE,     // show the history frame in place of the live one
+    COMPARE_WIPE,       // history frame to the left of the wipe, live to the right
+    NUM_COMPARE_MODES,
+};
+
 union FrameBuffer
 {
     const fb_util::Rgb888Buffer *rgb8;
@@ -3,8 +3,13 @@
 
 #include "MainWindow.h"
 
+#include "ContactSheetEvent.h"
 #include "FrameUpdateEvent.h"
+#include "MemoryStatsEvent.h"
+#include "PickWorker.h"
+#include "ProbeEvent.h"
 #include "RenderViewport.h"
+#include "SnapshotWriter.h"
 
 #include <QtGui>
 
@@ -24,7 +29,9 @@ MainWindow::MainWindow(QWidget* parent, CameraType initialType, const char *crtO
     mFastMode(nullptr),
     mGuide(nullptr),
     mSettings(nullptr),
-    mTimer(nullptr)
+    mToast(nullptr),
+    mTimer(nullptr),
+    mToastTimer(nullptr)
 {
     setupUi(initialType, crtOverride, snapPath);
 
@@ -56,10 +63,23 @@ MainWindow::MainWindow(QWidget* parent, CameraType initialType, const char *crtO
     mGuide->resize(width() / 2 , height());
     mGuide->hide();
 
+    // Setup notification text overlay, shown when a snapshot has been written
+    mToast = new QLabel(this);
+    mToast->setStyleSheet(QString::fromStdString("QLabel { margin : 10; padding : 5; background-color : ") +
+                          QString::fromStdString("rgba(0.0, 0.0, 0.0, 0.5); color : ") +
+                          QString::fromStdString("rgba(255.0, 255.0, 255.0, 1.0); }"));
+    mToast->hide();
+
     // Setup the timer for text overlay
     mTimer = new QTimer(this);
     connect(mTimer, SIGNAL(timeout()), this, SLOT(hideTextOverlay()));
 
+    // The notification has its own timer, so it and the other overlays don't
+    // cut each other short.
+    mToastTimer = new QTimer(this);
+    mToastTimer->setSingleShot(true);
+    connect(mToastTimer, SIGNAL(timeout()), mToast, SLOT(hide()));
+
     // Print welcome message to console
     std::cout << "Welcome to Moonray GUI. Press H while running the application to open the hotkey guide." << std::endl;
 }
@@ -70,7 +90,9 @@ MainWindow::~MainWindow()
     if (mFastMode) delete mFastMode;
     if (mGuide) delete mGuide;
     if (mSettings) delete mSettings;
+    if (mToast) delete mToast;
     if (mTimer) delete mTimer;
+    if (mToastTimer) delete mToastTimer;
 }
 
 
@@ -136,6 +158,39 @@ MainWindow::event(QEvent* event)
         return true;
     }
 
+    else if (event->type() == ContactSheetEvent::type()) {
+        mRenderViewport->updateContactSheet(static_cast<ContactSheetEvent*>(event));
+        return true;
+    }
+
+    else if (event->type() == PickResultEvent::type()) {
+        mRenderViewport->showPickResult(static_cast<PickResultEvent*>(event));
+        return true;
+    }
+
+    else if (event->type() == ProbeEvent::type()) {
+        mRenderViewport->showProbe(static_cast<ProbeEvent*>(event));
+        return true;
+    }
+
+    else if (event->type() == MemoryStatsEvent::type()) {
+        mRenderViewport->showMemoryStats(static_cast<MemoryStatsEvent*>(event));
+        return true;
+    }
+
+    else if (event->type() == SnapshotWrittenEvent::type()) {
+        // set text overlay timeout in milliseconds
+        constexpr int hideToast = 3000;
+        SnapshotWrittenEvent *written = static_cast<SnapshotWrittenEvent*>(event);
+        mRenderViewport->snapshotWritten(written);
+        mToast->setText(written->getMessage());
+        mToast->adjustSize();
+        mToast->move(0, height() - mToast->height());
+        mToast->show();
+        mToastTimer->start(hideToast);
+        return true;
+    }
+
     else if (event->type() == QEvent::KeyPress) {
         QKeyEvent *key = static_cast<QKeyEvent *>(event);
         // ESC key closes interactive viewport.
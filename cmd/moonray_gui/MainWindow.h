@@ -40,8 +40,10 @@ private:
     QLabel* mFastMode;
     QLabel* mGuide;
     QLabel* mSettings;
+    QLabel* mToast;
     
     QTimer* mTimer;
+    QTimer* mToastTimer;
 
     
 public slots:
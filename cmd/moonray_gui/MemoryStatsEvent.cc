@@ -0,0 +1,13 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+#include "MemoryStatsEvent.h"
+
+#include <QEvent>
+namespace moonray_gui {
+
+QEvent::Type MemoryStatsEvent::sEventType =
+        static_cast<QEvent::Type>(QEvent::registerEventType());
+
+} // namespace moonray_gui
+
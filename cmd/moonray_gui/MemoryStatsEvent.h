@@ -0,0 +1,31 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <QEvent>
+#include <QString>
+
+namespace moonray_gui {
+
+/// Live and peak memory of the GUI's buffers, shown while the memory stats
+/// overlay is on.
+class MemoryStatsEvent : public QEvent
+{
+public:
+    explicit MemoryStatsEvent(const QString &text):
+        QEvent(MemoryStatsEvent::type()),
+        mText(text)
+    {
+    }
+
+    const QString &getText() const { return mText; }
+    static QEvent::Type type() { return sEventType; }
+
+private:
+    QString mText;
+    static QEvent::Type sEventType;
+};
+
+} // namespace moonray_gui
+
@@ -11,6 +11,9 @@ class QMouseEvent;
 namespace moonray { namespace rndr { class RenderContext; } }
 
 namespace moonray_gui {
+
+class PickBuffer;
+
 ///
 /// Pure virtual base class which further navigation models may be implemented
 /// on top of.
@@ -26,6 +29,10 @@ public:
     // nothing by default.
     virtual void        setRenderContext(const moonray::rndr::RenderContext &context) {}
 
+    // Cameras which intersect with the scene may look up settled pixels here
+    // before casting rays. This function does nothing by default.
+    virtual void        setPickBuffer(const PickBuffer *pickBuffer) {}
+
     // If this camera model imposes any constraints on the input matrix, then
     // the constrained matrix is returned, otherwise the output will equal in 
     // input.
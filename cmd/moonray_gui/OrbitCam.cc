@@ -2,6 +2,7 @@
 // SPDX-License-Identifier: Apache-2.0
 
 #include "OrbitCam.h"
+#include "PickBuffer.h"
 #include <moonray/rendering/rndr/RenderContext.h>
 #include <scene_rdl2/common/math/Viewport.h>
 #include <scene_rdl2/common/platform/Platform.h>
@@ -173,6 +174,7 @@ public:
 
 OrbitCam::OrbitCam() :
     mRenderContext(nullptr),
+    mPickBuffer(nullptr),
     mCamera(new Camera),
     mSpeed(50.0f),
     mInputState(0),
@@ -196,6 +198,12 @@ OrbitCam::setRenderContext(const moonray::rndr::RenderContext &context)
     mRenderContext = &context;
 }
 
+void
+OrbitCam::setPickBuffer(const PickBuffer *pickBuffer)
+{
+    mPickBuffer = pickBuffer;
+}
+
 Mat4f
 OrbitCam::resetTransform(const Mat4f &xform, bool makeDefault)
 {
@@ -434,7 +442,8 @@ OrbitCam::recenterCamera()
 bool
 OrbitCam::pick(int x, int y, Vec3f *hitPoint) const
 {
-    MNRY_ASSERT(mRenderContext);
+    // There is no scene to pick from when viewing a frame stream.
+    if (!mRenderContext) return false;
 
     // must use offset between center point of aperture window and center point
     // of region window so that the region window is centered on the pick point.
@@ -442,8 +451,16 @@ OrbitCam::pick(int x, int y, Vec3f *hitPoint) const
     const scene_rdl2::math::HalfOpenViewport rvp = mRenderContext->getRezedRegionWindow();
     const int offsetX = (avp.max().x + avp.min().x) / 2 - (rvp.max().x + rvp.min().x) / 2;
     const int offsetY = (avp.max().y + avp.min().y) / 2 - (rvp.max().y + rvp.min().y) / 2;
+    const int pickX = x + offsetX;
+    const int pickY = y - offsetY;
+
+    // Settled pixels of the pick buffer save a ray cast, looked up at the
+    // same pixel the ray would be cast through. Its rows run from the bottom.
+    if (mPickBuffer && mPickBuffer->getPosition(pickX, int(rvp.height()) - 1 - pickY, hitPoint)) {
+        return true;
+    }
 
-    return mRenderContext->handlePickLocation(x + offsetX, y - offsetY, hitPoint);
+    return mRenderContext->handlePickLocation(pickX, pickY, hitPoint);
 }
 
 Mat4f
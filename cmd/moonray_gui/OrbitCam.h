@@ -38,6 +38,7 @@ public:
                         ~OrbitCam();
 
     void                setRenderContext(const moonray::rndr::RenderContext &context) override;
+    void                setPickBuffer(const PickBuffer *pickBuffer) override;
 
     /// The active render context should be set before calling this function.
     scene_rdl2::math::Mat4f  resetTransform(const scene_rdl2::math::Mat4f &xform, bool makeDefault) override;
@@ -70,6 +71,7 @@ private:
     void                printCameraMatrices() const;
 
     const moonray::rndr::RenderContext *mRenderContext;
+    const PickBuffer *  mPickBuffer;
     Camera *            mCamera;
 
     float               mSpeed;
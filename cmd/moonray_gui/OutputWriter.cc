@@ -0,0 +1,326 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+/// @file OutputWriter.cc
+
+#include "OutputWriter.h"
+#include "ExrWriteScope.h"
+
+#include <moonray/application/RaasApplication.h>
+#include <moonray/rendering/rndr/RenderOutputDriver.h>
+#include <moonray/rendering/rndr/rndr.h>
+#include <scene_rdl2/render/logging/logging.h>
+#include <scene_rdl2/scene/rdl2/Metadata.h>
+
+#include <OpenImageIO/imageio.h>
+#include <tbb/parallel_for.h>
+
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+namespace moonray_gui {
+
+// Snapshots kept around for reuse, and the number of snapshots which may be
+// waiting to be written before acquire() blocks.
+#define OUTPUT_WRITER_POOL_SIZE     2
+
+namespace {
+
+// Everything going to one file, in the order it is written.
+struct OutputFile
+{
+    std::string mPath;
+    bool mBeauty;
+    std::vector<const RenderOutputSnapshot *> mRenderOutputs;
+};
+
+void
+addMetadata(const scene_rdl2::rdl2::SceneObject *object, OIIO::ImageSpec *spec)
+{
+    const scene_rdl2::rdl2::Metadata *metadata = object ? object->asA<scene_rdl2::rdl2::Metadata>() : nullptr;
+    if (!metadata) {
+        return;
+    }
+
+    const std::vector<std::string> &names = metadata->getAttributeNames();
+    const std::vector<std::string> &types = metadata->getAttributeTypes();
+    const std::vector<std::string> &values = metadata->getAttributeValues();
+    const size_t count = std::min({names.size(), types.size(), values.size()});
+    for (size_t i = 0; i < count; ++i) {
+        if (types[i] == "int") {
+            spec->attribute(names[i], std::stoi(values[i]));
+        } else if (types[i] == "float") {
+            spec->attribute(names[i], std::stof(values[i]));
+        } else {
+            spec->attribute(names[i], values[i]);
+        }
+    }
+}
+
+// Writes render outputs sharing a file, one part per file part. Buffers are
+// bottom to top and cover the region window, which sits inside the aperture
+// window.
+void
+writeRenderOutputs(const std::string &path, const std::vector<const RenderOutputSnapshot *> &outputs,
+                   const scene_rdl2::math::HalfOpenViewport &aperture,
+                   const scene_rdl2::math::HalfOpenViewport &region)
+{
+    std::vector<std::string> partNames;
+    std::vector<std::vector<const RenderOutputSnapshot *>> parts;
+    for (const RenderOutputSnapshot *output : outputs) {
+        const auto it = std::find(partNames.begin(), partNames.end(), output->mFilePart);
+        if (it == partNames.end()) {
+            partNames.push_back(output->mFilePart);
+            parts.push_back({output});
+        } else {
+            parts[it - partNames.begin()].push_back(output);
+        }
+    }
+
+    const int width = region.mMaxX - region.mMinX;
+    const int height = region.mMaxY - region.mMinY;
+
+    std::vector<OIIO::ImageSpec> specs(parts.size());
+    std::vector<std::vector<float>> pixels(parts.size());
+    for (size_t p = 0; p < parts.size(); ++p) {
+        OIIO::ImageSpec &spec = specs[p];
+        for (const RenderOutputSnapshot *output : parts[p]) {
+            if (int(output->mBuffer.getWidth()) != width || int(output->mBuffer.getHeight()) != height) {
+                throw std::runtime_error("render output size doesn't match the region window");
+            }
+            for (const std::string &channel : output->mChannelNames) {
+                spec.channelnames.push_back(channel);
+                spec.channelformats.push_back(output->mHalf ? OIIO::TypeDesc::HALF : OIIO::TypeDesc::FLOAT);
+            }
+        }
+        spec.nchannels = int(spec.channelnames.size());
+        spec.format = OIIO::TypeDesc::FLOAT;
+        spec.width = width;
+        spec.height = height;
+        spec.x = region.mMinX;
+        spec.y = aperture.mMinY + aperture.mMaxY - region.mMaxY;
+        spec.full_x = aperture.mMinX;
+        spec.full_y = aperture.mMinY;
+        spec.full_width = aperture.mMaxX - aperture.mMinX;
+        spec.full_height = aperture.mMaxY - aperture.mMinY;
+        spec.attribute("compression", parts[p].front()->mCompression);
+        if (!partNames[p].empty()) {
+            spec.attribute("name", partNames[p]);
+        }
+        for (const RenderOutputSnapshot *output : parts[p]) {
+            addMetadata(output->mMetadata, &spec);
+        }
+
+        // Interleave the outputs' channels, flipping rows to top to bottom.
+        std::vector<float> &data = pixels[p];
+        data.resize(size_t(width) * size_t(height) * size_t(spec.nchannels));
+        size_t first = 0;
+        for (const RenderOutputSnapshot *output : parts[p]) {
+            const size_t numChannels = output->mChannelNames.size();
+            const float *src = reinterpret_cast<const float *>(output->mBuffer.getData());
+            for (int y = 0; y < height; ++y) {
+                const float *srcRow = src + size_t(height - 1 - y) * size_t(width) * numChannels;
+                float *dstRow = data.data() + size_t(y) * size_t(width) * size_t(spec.nchannels) + first;
+                for (int x = 0; x < width; ++x) {
+                    std::memcpy(dstRow + size_t(x) * size_t(spec.nchannels), srcRow + size_t(x) * numChannels,
+                                numChannels * sizeof(float));
+                }
+            }
+            first += numChannels;
+        }
+    }
+
+    auto out = OIIO::ImageOutput::create(path);
+    if (!out) {
+        throw std::runtime_error(OIIO::geterror());
+    }
+    if (!out->open(path, int(specs.size()), specs.data())) {
+        throw std::runtime_error(out->geterror());
+    }
+    for (size_t p = 0; p < parts.size(); ++p) {
+        if ((p > 0 && !out->open(path, specs[p], OIIO::ImageOutput::AppendSubimage)) ||
+            !out->write_image(OIIO::TypeDesc::FLOAT, pixels[p].data())) {
+            const std::string error = out->geterror();
+            out->close();
+            throw std::runtime_error(error);
+        }
+    }
+    if (!out->close()) {
+        throw std::runtime_error(out->geterror());
+    }
+}
+
+} // anonymous namespace
+
+OutputWriter::OutputWriter() :
+    mBusy(false),
+    mStop(false)
+{
+    mWorker = std::thread(&OutputWriter::workerLoop, this);
+}
+
+OutputWriter::~OutputWriter()
+{
+    waitForIdle();
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStop = true;
+    }
+    mCondition.notify_one();
+    mWorker.join();
+}
+
+std::shared_ptr<FrameSnapshot>
+OutputWriter::acquire()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    mIdleCondition.wait(lock, [this] { return mQueue.size() < OUTPUT_WRITER_POOL_SIZE; });
+
+    // A pooled snapshot only referenced by the pool is free to reuse. Nothing
+    // else can take a new reference to it, so this check can't go stale.
+    auto it = std::find_if(mPool.begin(), mPool.end(),
+                           [](const std::shared_ptr<FrameSnapshot> &snapshot) { return snapshot.use_count() == 1; });
+    if (it != mPool.end()) {
+        return *it;
+    }
+
+    auto snapshot = std::make_shared<FrameSnapshot>();
+    if (mPool.size() < OUTPUT_WRITER_POOL_SIZE) {
+        mPool.push_back(snapshot);
+    }
+    return snapshot;
+}
+
+void
+OutputWriter::submit(std::shared_ptr<const FrameSnapshot> snapshot, moonray::rndr::RenderContext &context)
+{
+    if (context.getDeepBuffer() || context.getCryptomatteBuffer()) {
+        // Don't race an earlier frame to the same files.
+        waitForIdle();
+        writeWithContext(*snapshot, context);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mQueue.push_back(std::move(snapshot));
+    }
+    mCondition.notify_one();
+}
+
+void
+OutputWriter::waitForIdle()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    mIdleCondition.wait(lock, [this] { return mQueue.empty() && !mBusy; });
+}
+
+size_t
+OutputWriter::getMemoryUsage()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    size_t size = 0;
+    for (const auto &snapshot : mPool) {
+        size += snapshot->getMemoryUsage();
+    }
+    return size;
+}
+
+void
+OutputWriter::releaseUnused()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mPool.erase(std::remove_if(mPool.begin(), mPool.end(),
+                               [](const std::shared_ptr<FrameSnapshot> &snapshot) { return snapshot.use_count() == 1; }),
+                mPool.end());
+}
+
+void
+OutputWriter::write(const FrameSnapshot &snapshot)
+{
+    // Render outputs may go to the same file as the beauty image, which they
+    // do by default, replacing it. Everything going to one file is written in
+    // order, and separate files in parallel.
+    std::vector<OutputFile> files;
+    files.push_back({snapshot.mOutputFilename, true, {}});
+    for (const RenderOutputSnapshot &output : snapshot.mRenderOutputs) {
+        auto it = std::find_if(files.begin(), files.end(),
+                               [&output](const OutputFile &file) { return file.mPath == output.mFileName; });
+        if (it == files.end()) {
+            files.push_back({output.mFileName, false, {}});
+            it = files.end() - 1;
+        }
+        it->mRenderOutputs.push_back(&output);
+    }
+
+    tbb::parallel_for(size_t(0), files.size(), [&](size_t i) {
+        const OutputFile &file = files[i];
+        ExrWriteScope exr;
+        if (file.mBeauty) {
+            moonray::writeImageWithMessage(&snapshot.mRenderBuffer, file.mPath,
+                                           snapshot.mMetadata, snapshot.mAperture, snapshot.mRegion);
+        }
+        if (file.mRenderOutputs.empty()) {
+            return;
+        }
+        try {
+            writeRenderOutputs(file.mPath, file.mRenderOutputs, snapshot.mAperture, snapshot.mRegion);
+            std::cout << "Wrote " << file.mPath << std::endl;
+        } catch (const std::exception &e) {
+            scene_rdl2::logging::Logger::error("Failed to write out ", file.mPath, ": ", e.what());
+        }
+    });
+}
+
+void
+OutputWriter::writeWithContext(const FrameSnapshot &snapshot, moonray::rndr::RenderContext &context)
+{
+    std::vector<scene_rdl2::fb_util::VariablePixelBuffer> aovBuffers;
+    std::vector<scene_rdl2::fb_util::VariablePixelBuffer> displayFilterBuffers;
+    context.snapshotAovBuffers(aovBuffers, /*untile*/ true, /*parallel*/ true);
+    context.snapshotDisplayFilterBuffers(displayFilterBuffers, /*untile*/ true, /*parallel*/ true);
+
+    // In order, as render outputs may go to the same file as the beauty
+    // image, which they do by default.
+    ExrWriteScope exr;
+    moonray::writeImageWithMessage(&snapshot.mRenderBuffer, snapshot.mOutputFilename,
+                                   snapshot.mMetadata, snapshot.mAperture, snapshot.mRegion);
+    moonray::writeRenderOutputsWithMessages(context.getRenderOutputDriver(),
+                                            context.getDeepBuffer(), context.getCryptomatteBuffer(),
+                                            &snapshot.mHeatMapBuffer, &snapshot.mWeightBuffer,
+                                            &snapshot.mRenderBufferOdd, aovBuffers, displayFilterBuffers);
+}
+
+void
+OutputWriter::workerLoop()
+{
+    while (true) {
+        std::shared_ptr<const FrameSnapshot> snapshot;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCondition.wait(lock, [this] { return mStop || !mQueue.empty(); });
+            if (mStop) {
+                return;
+            }
+            snapshot = std::move(mQueue.front());
+            mQueue.pop_front();
+            mBusy = true;
+        }
+
+        write(*snapshot);
+        snapshot.reset();
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mBusy = false;
+        }
+        mIdleCondition.notify_all();
+    }
+}
+
+} // namespace moonray_gui
+
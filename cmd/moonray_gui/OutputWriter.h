@@ -0,0 +1,79 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+/// @file OutputWriter.h
+
+#pragma once
+
+#include "FrameSnapshot.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace moonray {
+namespace rndr {
+class RenderContext;
+}
+}
+
+namespace moonray_gui {
+
+/**
+ * Writes frame outputs on a background thread so the render loop can get on
+ * with the next frame. Outputs going to different files are written in
+ * parallel. Snapshots are recycled once both the writer and the display are
+ * done with them.
+ */
+class OutputWriter
+{
+public:
+    OutputWriter();
+    ~OutputWriter();
+
+    /// Returns a snapshot to capture a frame into, reusing one nobody else
+    /// holds on to if possible. Blocks while two snapshots are still waiting
+    /// to be written.
+    std::shared_ptr<FrameSnapshot> acquire();
+
+    /// Writes snapshot, captured from context, out. Deep and cryptomatte data
+    /// are owned by the render context and change with the next frame, so if
+    /// context has either everything is written before this returns.
+    void submit(std::shared_ptr<const FrameSnapshot> snapshot, moonray::rndr::RenderContext &context);
+
+    /// Blocks until all submitted outputs are written. Their metadata points
+    /// into the scene, so this must be called before the scene is destroyed.
+    void waitForIdle();
+
+    /// Bytes held by the snapshots kept for reuse.
+    size_t getMemoryUsage();
+
+    /// Frees the snapshots kept for reuse which nobody else holds on to.
+    void releaseUnused();
+
+private:
+    static void write(const FrameSnapshot &snapshot);
+
+    /// Writes everything through the render output driver, which is the only
+    /// thing that knows how to write deep and cryptomatte outputs.
+    static void writeWithContext(const FrameSnapshot &snapshot, moonray::rndr::RenderContext &context);
+
+    void workerLoop();
+
+    std::vector<std::shared_ptr<FrameSnapshot>> mPool;
+    std::deque<std::shared_ptr<const FrameSnapshot>> mQueue;
+    bool mBusy;
+
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    std::condition_variable mIdleCondition;
+    bool mStop;
+    std::thread mWorker;
+};
+
+} // namespace moonray_gui
+
@@ -0,0 +1,223 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+/// @file PickBuffer.cc
+
+#include "PickBuffer.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace moonray_gui {
+
+using scene_rdl2::fb_util::FloatBuffer;
+using scene_rdl2::math::Mat4f;
+using scene_rdl2::math::Vec3f;
+
+// Samples a pixel needs before its depth and IDs are trusted.
+#define PICK_BUFFER_MIN_WEIGHT      4.f
+
+// Largest relative difference in depth between a pixel and its neighbours
+// for it to count as being on a single surface.
+#define PICK_BUFFER_DEPTH_TOLERANCE 0.02f
+
+namespace {
+
+constexpr uint32_t NO_ID = 0xffffffff;
+
+inline bool
+isValidDepth(float depth)
+{
+    return depth > 0.f && depth < 1e20f && std::isfinite(depth);
+}
+
+inline uint32_t
+getIdBits(float id)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &id, sizeof(bits));
+    return bits;
+}
+
+// Calls func with the index of each of the 4 neighbours of (x, y) inside a
+// w x h frame, stopping and returning false as soon as func does.
+template <typename Func> bool
+allNeighbours(unsigned w, unsigned h, unsigned x, unsigned y, const Func &func)
+{
+    const size_t i = size_t(y) * w + x;
+    return (x == 0     || func(i - 1)) &&
+           (x + 1 == w || func(i + 1)) &&
+           (y == 0     || func(i - w)) &&
+           (y + 1 == h || func(i + w));
+}
+
+void
+settleIds(const FloatBuffer &ids, const FloatBuffer &weights, std::vector<uint32_t> *settled)
+{
+    const unsigned w = ids.getWidth();
+    const unsigned h = ids.getHeight();
+    const float *src = ids.getData();
+    const float *weight = weights.getData();
+
+    settled->assign(size_t(w) * h, NO_ID);
+    for (unsigned y = 0; y < h; ++y) {
+        for (unsigned x = 0; x < w; ++x) {
+            const size_t i = size_t(y) * w + x;
+            if (weight[i] < PICK_BUFFER_MIN_WEIGHT || !std::isfinite(src[i])) {
+                continue;
+            }
+            const uint32_t id = getIdBits(src[i]);
+            if (allNeighbours(w, h, x, y, [&](size_t n) { return getIdBits(src[n]) == id; })) {
+                (*settled)[i] = id;
+            }
+        }
+    }
+}
+
+} // anonymous namespace
+
+PickBuffer::PickBuffer()
+{
+}
+
+void
+PickBuffer::update(const FloatBuffer &depth,
+                   const FloatBuffer &weights,
+                   const FloatBuffer *geometryIds,
+                   const FloatBuffer *materialIds,
+                   const Mat4f &c2w,
+                   const CameraProjection &projection)
+{
+    const unsigned w = depth.getWidth();
+    const unsigned h = depth.getHeight();
+    if (weights.getWidth() != w || weights.getHeight() != h) {
+        invalidate();
+        return;
+    }
+
+    // Built outside the lock so lookups aren't held up.
+    auto frame = std::make_shared<Frame>();
+    frame->mWidth = w;
+    frame->mHeight = h;
+    frame->mC2w = c2w;
+    frame->mProjection = projection;
+
+    const float *src = depth.getData();
+    const float *weight = weights.getData();
+    frame->mDepth.assign(size_t(w) * h, 0.f);
+    for (unsigned y = 0; y < h; ++y) {
+        for (unsigned x = 0; x < w; ++x) {
+            const size_t i = size_t(y) * w + x;
+            const float d = src[i];
+            if (weight[i] < PICK_BUFFER_MIN_WEIGHT || !isValidDepth(d)) {
+                continue;
+            }
+            if (allNeighbours(w, h, x, y, [&](size_t n) {
+                    return std::abs(src[n] - d) <= d * PICK_BUFFER_DEPTH_TOLERANCE;
+                })) {
+                frame->mDepth[i] = d;
+            }
+        }
+    }
+
+    if (geometryIds && geometryIds->getWidth() == w && geometryIds->getHeight() == h) {
+        settleIds(*geometryIds, weights, &frame->mGeometryIds);
+    }
+    if (materialIds && materialIds->getWidth() == w && materialIds->getHeight() == h) {
+        settleIds(*materialIds, weights, &frame->mMaterialIds);
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    mFrame = std::move(frame);
+}
+
+void
+PickBuffer::invalidate()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mFrame.reset();
+}
+
+void
+PickBuffer::clear()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mFrame.reset();
+    mGeometries.clear();
+    mMaterials.clear();
+}
+
+bool
+PickBuffer::getPosition(int x, int y, Vec3f *position) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (!mFrame || x < 0 || y < 0 || unsigned(x) >= mFrame->mWidth || unsigned(y) >= mFrame->mHeight) {
+        return false;
+    }
+
+    const float depth = mFrame->mDepth[size_t(y) * mFrame->mWidth + x];
+    if (depth <= 0.f) {
+        return false;
+    }
+
+    const Vec3f dir = mFrame->mProjection.pixelDirection(mFrame->mWidth, mFrame->mHeight, float(x), float(y));
+    *position = transformPoint(mFrame->mC2w, dir * depth);
+    return true;
+}
+
+bool
+PickBuffer::getId(const Frame &frame, const std::vector<uint32_t> &ids, int x, int y, uint32_t *id)
+{
+    if (ids.empty() || x < 0 || y < 0 || unsigned(x) >= frame.mWidth || unsigned(y) >= frame.mHeight) {
+        return false;
+    }
+    *id = ids[size_t(y) * frame.mWidth + x];
+    return *id != NO_ID;
+}
+
+const scene_rdl2::rdl2::Geometry *
+PickBuffer::findGeometry(int x, int y) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    uint32_t id;
+    if (!mFrame || !getId(*mFrame, mFrame->mGeometryIds, x, y, &id)) {
+        return nullptr;
+    }
+    const auto it = mGeometries.find(id);
+    return it != mGeometries.end() ? it->second : nullptr;
+}
+
+const scene_rdl2::rdl2::Material *
+PickBuffer::findMaterial(int x, int y) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    uint32_t id;
+    if (!mFrame || !getId(*mFrame, mFrame->mMaterialIds, x, y, &id)) {
+        return nullptr;
+    }
+    const auto it = mMaterials.find(id);
+    return it != mMaterials.end() ? it->second : nullptr;
+}
+
+void
+PickBuffer::addGeometry(int x, int y, const scene_rdl2::rdl2::Geometry *geometry)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    uint32_t id;
+    if (geometry && mFrame && getId(*mFrame, mFrame->mGeometryIds, x, y, &id)) {
+        mGeometries[id] = geometry;
+    }
+}
+
+void
+PickBuffer::addMaterial(int x, int y, const scene_rdl2::rdl2::Material *material)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    uint32_t id;
+    if (material && mFrame && getId(*mFrame, mFrame->mMaterialIds, x, y, &id)) {
+        mMaterials[id] = material;
+    }
+}
+
+} // namespace moonray_gui
+
@@ -0,0 +1,100 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+/// @file PickBuffer.h
+
+#pragma once
+
+#include "Reprojector.h"
+
+#include <scene_rdl2/common/fb_util/FbTypes.h>
+#include <scene_rdl2/common/math/Mat4.h>
+#include <scene_rdl2/common/math/Vec3.h>
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace scene_rdl2 {
+namespace rdl2 {
+class Geometry;
+class Material;
+}
+}
+
+namespace moonray_gui {
+
+/**
+ * Depth and object ID render outputs kept from a settled frame, so that focus
+ * and inspector picks become array lookups rather than ray casts into the
+ * scene. Only pixels with enough samples whose neighbours agree with them are
+ * kept, since depths and IDs averaged across an edge belong to no surface;
+ * everywhere else lookups fail and the caller should fall back to a ray pick.
+ *
+ * ID outputs hold arbitrary values, so they are tied to scene objects by
+ * remembering what a ray pick found at a pixel with the same ID.
+ *
+ * Updated from the render thread and read from any other.
+ */
+class PickBuffer
+{
+public:
+    PickBuffer();
+
+    /// Replaces the frame with one seen from c2w. weights are per pixel
+    /// sample counts. Either ID buffer may be null.
+    void update(const scene_rdl2::fb_util::FloatBuffer &depth,
+                const scene_rdl2::fb_util::FloatBuffer &weights,
+                const scene_rdl2::fb_util::FloatBuffer *geometryIds,
+                const scene_rdl2::fb_util::FloatBuffer *materialIds,
+                const scene_rdl2::math::Mat4f &c2w,
+                const CameraProjection &projection);
+
+    /// Drops the frame, for when the view or scene has changed. The objects
+    /// found for each ID are kept.
+    void invalidate();
+
+    /// Drops the frame and forgets the objects found for each ID, for when
+    /// the scene is about to be edited.
+    void clear();
+
+    /// Looks up the world space position under render buffer pixel (x, y),
+    /// rows from the bottom. Returns false if the pixel isn't settled.
+    bool getPosition(int x, int y, scene_rdl2::math::Vec3f *position) const;
+
+    /// Returns the object a ray pick found at a pixel with the same ID as
+    /// pixel (x, y), or null if there hasn't been one.
+    const scene_rdl2::rdl2::Geometry *findGeometry(int x, int y) const;
+    const scene_rdl2::rdl2::Material *findMaterial(int x, int y) const;
+
+    /// Remembers what a ray pick found at pixel (x, y) for other pixels with
+    /// the same ID.
+    void addGeometry(int x, int y, const scene_rdl2::rdl2::Geometry *geometry);
+    void addMaterial(int x, int y, const scene_rdl2::rdl2::Material *material);
+
+private:
+    struct Frame
+    {
+        unsigned mWidth = 0;
+        unsigned mHeight = 0;
+        scene_rdl2::math::Mat4f mC2w;
+        CameraProjection mProjection;
+
+        /// Unsettled pixels hold 0 depth, and no IDs.
+        std::vector<float> mDepth;
+        std::vector<uint32_t> mGeometryIds;
+        std::vector<uint32_t> mMaterialIds;
+    };
+
+    /// Returns the ID of pixel (x, y) in ids, or false if it has none.
+    static bool getId(const Frame &frame, const std::vector<uint32_t> &ids, int x, int y, uint32_t *id);
+
+    mutable std::mutex mMutex;
+    std::shared_ptr<const Frame> mFrame;
+    std::unordered_map<uint32_t, const scene_rdl2::rdl2::Geometry *> mGeometries;
+    std::unordered_map<uint32_t, const scene_rdl2::rdl2::Material *> mMaterials;
+};
+
+} // namespace moonray_gui
+
@@ -0,0 +1,217 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+/// @file PickWorker.cc
+
+#include "PickWorker.h"
+#include "PickBuffer.h"
+
+#include <moonray/rendering/rndr/rndr.h>
+#include <scene_rdl2/common/platform/Platform.h>
+#include <scene_rdl2/scene/rdl2/Geometry.h>
+#include <scene_rdl2/scene/rdl2/Light.h>
+#include <scene_rdl2/scene/rdl2/Material.h>
+
+#include <QCoreApplication>
+#include <QObject>
+
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+namespace moonray_gui {
+
+QEvent::Type PickResultEvent::sEventType =
+        static_cast<QEvent::Type>(QEvent::registerEventType());
+
+PickWorker::PickWorker(QObject *receiver) :
+    mReceiver(receiver),
+    mRenderContext(nullptr),
+    mPickBuffer(nullptr),
+    mHasPending(false),
+    mBusy(false),
+    mPauseCount(0),
+    mStop(false)
+{
+    mWorker = std::thread(&PickWorker::workerLoop, this);
+}
+
+PickWorker::~PickWorker()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mHasPending = false;
+        mStop = true;
+    }
+    mCondition.notify_one();
+    mWorker.join();
+}
+
+void
+PickWorker::setRenderContext(const moonray::rndr::RenderContext *context)
+{
+    pause();
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mRenderContext = context;
+    }
+    resume();
+}
+
+void
+PickWorker::setPickBuffer(PickBuffer *pickBuffer)
+{
+    pause();
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mPickBuffer = pickBuffer;
+    }
+    resume();
+}
+
+void
+PickWorker::submit(const PickRequest &request)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mPending = request;
+        mHasPending = true;
+    }
+    mCondition.notify_one();
+}
+
+void
+PickWorker::pause()
+{
+    // Only the pick already running is waited for, so a stream of hover
+    // picks can't hold this up.
+    std::unique_lock<std::mutex> lock(mMutex);
+    ++mPauseCount;
+    mIdleCondition.wait(lock, [this] { return !mBusy; });
+}
+
+void
+PickWorker::resume()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        MNRY_ASSERT(mPauseCount > 0);
+        --mPauseCount;
+    }
+    mCondition.notify_one();
+}
+
+QString
+PickWorker::pick(const moonray::rndr::RenderContext &context, PickBuffer *pickBuffer,
+                 const PickRequest &request)
+{
+    const int x = request.mX;
+    const int y = request.mY;
+    std::ostringstream ss;
+
+    switch (request.mMode) {
+    case INSPECT_LIGHT_CONTRIBUTIONS:
+        {
+            moonray::shading::LightContribArray rdlLights;
+            context.handlePickLightContributions(x, y, rdlLights);
+            std::sort(rdlLights.begin(), rdlLights.end(),
+                      [&](const moonray::shading::LightContrib &l0, const moonray::shading::LightContrib &l1) {
+                          return l0.second < l1.second;
+                      });
+            ss << "Light Pick Results: (" << x << ", " << y << ")";
+            for (unsigned int i = 0; i < rdlLights.size(); ++i) {
+                ss << "\n\t" << rdlLights[i].first->getName() << ": " << rdlLights[i].second;
+            }
+        }
+        break;
+    case INSPECT_GEOMETRY:
+        {
+            const scene_rdl2::rdl2::Geometry *geometry = pickBuffer ? pickBuffer->findGeometry(x, y) : nullptr;
+            if (!geometry) {
+                geometry = context.handlePickGeometry(x, y);
+                if (pickBuffer) {
+                    pickBuffer->addGeometry(x, y, geometry);
+                }
+            }
+            ss << "Geometry Pick Result: (" << x << ", " << y << ")";
+            if (geometry) {
+                ss << "\n\t" << geometry->getName();
+            }
+        }
+        break;
+    case INSPECT_GEOMETRY_PART:
+        {
+            std::string parts;
+            const scene_rdl2::rdl2::Geometry *geometry = context.handlePickGeometryPart(x, y, parts);
+            ss << "Geometry Part Pick Result: (" << x << ", " << y << ")";
+            if (geometry) {
+                ss << "\n\t" << geometry->getName() << ", " << parts;
+            }
+        }
+        break;
+    case INSPECT_MATERIAL:
+        {
+            const scene_rdl2::rdl2::Material *material = pickBuffer ? pickBuffer->findMaterial(x, y) : nullptr;
+            if (!material) {
+                material = context.handlePickMaterial(x, y);
+                if (pickBuffer) {
+                    pickBuffer->addMaterial(x, y, material);
+                }
+            }
+            ss << "Material Pick Result: (" << x << ", " << y << ")";
+            if (material) {
+                ss << "\n\t" << material->getName();
+            }
+        }
+        break;
+    case INSPECT_NONE:
+    default:
+        break;
+    }
+    return QString::fromStdString(ss.str());
+}
+
+void
+PickWorker::workerLoop()
+{
+    while (true) {
+        PickRequest request;
+        const moonray::rndr::RenderContext *context;
+        PickBuffer *pickBuffer;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCondition.wait(lock, [this] { return mStop || (mHasPending && mPauseCount == 0); });
+            if (mStop) {
+                return;
+            }
+            request = mPending;
+            mHasPending = false;
+            context = mRenderContext;
+            pickBuffer = mPickBuffer;
+            mBusy = true;
+        }
+
+        const QString text = context ? pick(*context, pickBuffer, request) : QString();
+        if (!text.isEmpty()) {
+            // Hovering would flood the terminal, so only clicks are printed.
+            if (!request.mHover) {
+                std::cout << text.toStdString() << std::endl;
+            }
+
+            // QCoreApplication::postEvent() is thread-safe and takes ownership.
+            if (mReceiver) {
+                QCoreApplication::postEvent(mReceiver, new PickResultEvent(request.mWidgetPos, text));
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mBusy = false;
+        }
+        mIdleCondition.notify_all();
+    }
+}
+
+} // namespace moonray_gui
+
@@ -0,0 +1,110 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+/// @file PickWorker.h
+
+#pragma once
+
+#include "GuiTypes.h"
+
+#include <QEvent>
+#include <QPoint>
+#include <QString>
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+class QObject;
+
+namespace moonray {
+namespace rndr {
+class RenderContext;
+}
+}
+
+namespace moonray_gui {
+
+class PickBuffer;
+
+/// Sent to the receiver of a PickWorker with the result of each pick.
+class PickResultEvent : public QEvent
+{
+public:
+    PickResultEvent(const QPoint &widgetPos, const QString &text) :
+        QEvent(PickResultEvent::type()),
+        mWidgetPos(widgetPos),
+        mText(text)
+    {
+    }
+
+    /// Where the pick was made, in viewport widget coordinates.
+    const QPoint &getWidgetPos() const { return mWidgetPos; }
+    const QString &getText() const { return mText; }
+    static QEvent::Type type() { return sEventType; }
+
+private:
+    QPoint mWidgetPos;
+    QString mText;
+    static QEvent::Type sEventType;
+};
+
+struct PickRequest
+{
+    InspectorMode mMode = INSPECT_NONE;
+    int mX = 0; // render buffer pixel
+    int mY = 0;
+    QPoint mWidgetPos;
+    bool mHover = false; // picked by hovering rather than clicking
+};
+
+/**
+ * Runs pixel inspector picks away from the Qt thread, since a ray cast into a
+ * heavy scene can take long enough to stall the UI. Only the latest request
+ * is kept, so hovering with the mouse never builds up a backlog of picks.
+ */
+class PickWorker
+{
+public:
+    /// receiver is sent a PickResultEvent as each pick completes.
+    explicit PickWorker(QObject *receiver);
+    ~PickWorker();
+
+    void setRenderContext(const moonray::rndr::RenderContext *context);
+
+    /// Geometry and material picks are looked up here first, and what ray
+    /// picks find is added to it.
+    void setPickBuffer(PickBuffer *pickBuffer);
+
+    /// Queues a pick, replacing any queued pick which hasn't started yet.
+    void submit(const PickRequest &request);
+
+    /// Blocks until the pick in progress, if any, is done, and holds back
+    /// further picks until the matching resume(). Picks read the scene, so
+    /// this must be called before the scene or camera is modified, including
+    /// by stopping or starting a frame. Calls may be nested.
+    void pause();
+    void resume();
+
+private:
+    static QString pick(const moonray::rndr::RenderContext &context, PickBuffer *pickBuffer,
+                        const PickRequest &request);
+    void workerLoop();
+
+    QObject *mReceiver;
+    const moonray::rndr::RenderContext *mRenderContext;
+    PickBuffer *mPickBuffer;
+    PickRequest mPending;
+    bool mHasPending;
+    bool mBusy;
+    int mPauseCount;
+
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    std::condition_variable mIdleCondition;
+    bool mStop;
+    std::thread mWorker;
+};
+
+} // namespace moonray_gui
+
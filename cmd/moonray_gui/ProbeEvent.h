@@ -0,0 +1,31 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <QEvent>
+#include <QString>
+
+namespace moonray_gui {
+
+/// Values of every snapshotted buffer at the pixel under the cursor, shown
+/// while the hover probe is on.
+class ProbeEvent : public QEvent
+{
+public:
+    explicit ProbeEvent(const QString &text):
+        QEvent(ProbeEvent::type()),
+        mText(text)
+    {
+    }
+
+    const QString &getText() const { return mText; }
+    static QEvent::Type type() { return sEventType; }
+
+private:
+    QString mText;
+    static QEvent::Type sEventType;
+};
+
+} // namespace moonray_gui
+
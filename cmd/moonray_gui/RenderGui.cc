@@ -1,9 +1,14 @@
 // Copyright 2023-2024 DreamWorks Animation LLC
 // SPDX-License-Identifier: Apache-2.0
 
+#include "ContactSheetEvent.h"
+#include "DenoiseUtils.h"
 #include "FrameUpdateEvent.h"
 #include "MainWindow.h"
+#include "MemoryStatsEvent.h"
 #include "NavigationCam.h"
+#include "OutputWriter.h"
+#include "ProbeEvent.h"
 #include "RenderGui.h"
 #include "RenderViewport.h"
 
@@ -14,194 +19,79 @@
 #include <scene_rdl2/common/platform/Platform.h>
 #include <scene_rdl2/scene/rdl2/Camera.h>
 #include <scene_rdl2/scene/rdl2/RenderOutput.h>
+#include <scene_rdl2/scene/rdl2/SceneVariables.h>
 
 #include <QApplication>
 
 #include <algorithm>
+#include <cstring>
+#include <iostream>
 #include <limits>
 #include <memory>
 #include <string>
 #include <pthread.h>
 
-// Experimental:
-// Set to non-zero to only draw the corners of overlaid quads instead of the
-// full square. It may be slightly less distracting.
-#define DRAW_PARTIAL_TILE_OUTLINE       0
+// Brightness of the outline around tiles being rendered to, and the time in
+// seconds it takes to fade once they aren't.
+#define TILE_PROGRESS_INTENSITY         0.2f
+#define TILE_PROGRESS_FADE_TIME         0.2f
 
+// Seconds between contact sheet updates, and the width thumbnails are
+// reduced to (by an integer factor, so they may come out a little wider).
+#define CONTACT_SHEET_INTERVAL          1.0
+#define CONTACT_SHEET_THUMBNAIL_WIDTH   320
 
-namespace moonray_gui {
-using namespace scene_rdl2::math;
+// Memory the snapshots of recently viewed render outputs may use.
+#define RENDER_OUTPUT_CACHE_BUDGET_MB   512
 
-inline uint8_t
-convertToByteColor(float col)
-{
-    return uint8_t(math::saturate(col) * 255.f);
-}
+// Seconds between pick buffer updates.
+#define PICK_BUFFER_INTERVAL            0.5
 
-inline void
-addSaturate(uint8_t &fb, uint8_t c)
-{
-    uint8_t result = static_cast<uint8_t>(fb + c);
-    fb = (result >= fb) ? result : 255;
-}
+// Seconds between checks for idle buffers, and between updates of the GUI
+// memory overlay.
+#define BUFFER_POOL_INTERVAL            0.5
+#define MEMORY_STATS_INTERVAL           1.0
 
-inline void
-addSaturate(float &fb, float c)
-{
-    float result = fb + c;
-    fb = math::saturate(result);
-}
+// Number of denoiser configurations kept alive at once.
+#define DENOISER_CACHE_SIZE             4
 
-inline void
-addSaturate(scene_rdl2::fb_util::ByteColor &bc, uint8_t c)
-{
-    addSaturate(bc.r, c);
-    addSaturate(bc.g, c);
-    addSaturate(bc.b, c);
-}
+// Time in seconds the camera must be still before we go back to denoising at
+// full resolution, and the frame size above which we denoise at quarter
+// rather than half resolution while it moves.
+#define MOTION_DENOISE_IDLE_TIME            0.25
+#define MOTION_DENOISE_QUARTER_RES_PIXELS   (1920 * 1080)
 
-inline void
-addSaturate(scene_rdl2::fb_util::RenderColor &rc, float c)
-{
-    addSaturate(rc.x, c);
-    addSaturate(rc.y, c);
-    addSaturate(rc.z, c);
-}
 
-inline void
-addSaturate(math::Vec3f &v, float c)
-{
-    addSaturate(v.x, c);
-    addSaturate(v.y, c);
-    addSaturate(v.z, c);
-}
+namespace moonray_gui {
+using namespace scene_rdl2::math;
 
-template<typename BufferType, typename ScalarType> void 
-drawHorizontalLine(BufferType *buf, unsigned x0, unsigned x1, unsigned y, const ScalarType col)
-{
-    auto *row = buf->getRow(y);
-    for (unsigned x = x0; x < x1; ++x) {
-        addSaturate(row[x], col);
-    }
-}
+namespace {
 
-template<typename BufferType, typename ScalarType> void
-drawVerticalLine(BufferType *buf, unsigned x, unsigned y0, unsigned y1, const ScalarType col)
+// Formats the channels of pixel (x, y) of a float render output.
+QString
+formatPixel(const scene_rdl2::fb_util::VariablePixelBuffer &buffer, unsigned x, unsigned y)
 {
-    for (unsigned y = y0; y < y1; ++y) {
-        auto &pixel = buf->getPixel(x, y);
-        addSaturate(pixel, col);
+    unsigned channels;
+    switch (buffer.getFormat()) {
+    case scene_rdl2::fb_util::VariablePixelBuffer::FLOAT:  channels = 1; break;
+    case scene_rdl2::fb_util::VariablePixelBuffer::FLOAT2: channels = 2; break;
+    case scene_rdl2::fb_util::VariablePixelBuffer::FLOAT3: channels = 3; break;
+    case scene_rdl2::fb_util::VariablePixelBuffer::FLOAT4: channels = 4; break;
+    default: return QString("-");
+    }
+    if (x >= buffer.getWidth() || y >= buffer.getHeight()) {
+        return QString("-");
     }
-}
-
-template<typename BufferType, typename ScalarType> void
-drawFullTileOutline(BufferType *buf, const scene_rdl2::fb_util::Tile &tile, const ScalarType col)
-{
-    drawHorizontalLine(buf, tile.mMinX,     tile.mMaxX,     tile.mMinY,     col);
-    drawHorizontalLine(buf, tile.mMinX,     tile.mMaxX,     tile.mMaxY - 1, col);
-    drawVerticalLine(buf,   tile.mMinX,     tile.mMinY + 1, tile.mMaxY - 1, col);
-    drawVerticalLine(buf,   tile.mMaxX - 1, tile.mMinY + 1, tile.mMaxY - 1, col);
-}
-
-template<typename BufferType, typename ScalarType> void
-drawPoint(BufferType *buf, unsigned x, unsigned y, const ScalarType col)
-{
-    auto &pixel = buf->getPixel(x, y);
-    addSaturate(pixel, col);
-}
-
-inline uint8_t
-fadeColor(uint8_t c)
-{
-    return static_cast<uint8_t>(c >> 1);
-}
-
-inline float
-fadeColor(float c)
-{
-    return c * 0.5f;
-}
-
-template<typename BufferType, typename ScalarType> void
-drawPartialTileOutline(BufferType *buf, const scene_rdl2::fb_util::Tile &tile, const ScalarType col)
-{
-    ScalarType fadeCol = fadeColor(col);
-
-    drawPoint(buf, tile.mMinX,     tile.mMinY,     col);
-    drawPoint(buf, tile.mMinX + 1, tile.mMinY,     fadeCol);
-    drawPoint(buf, tile.mMinX,     tile.mMinY + 1, fadeCol);
-    drawPoint(buf, tile.mMinX + 2, tile.mMinY,     col);
-    drawPoint(buf, tile.mMinX,     tile.mMinY + 2, col);
-
-    drawPoint(buf, tile.mMinX,     tile.mMaxY - 1, col);
-    drawPoint(buf, tile.mMinX + 1, tile.mMaxY - 1, fadeCol);
-    drawPoint(buf, tile.mMinX,     tile.mMaxY - 2, fadeCol);
-    drawPoint(buf, tile.mMinX + 2, tile.mMaxY - 1, col);
-    drawPoint(buf, tile.mMinX,     tile.mMaxY - 3, col);
-
-    drawPoint(buf, tile.mMaxX - 1, tile.mMinY,     col);
-    drawPoint(buf, tile.mMaxX - 2, tile.mMinY,     fadeCol);
-    drawPoint(buf, tile.mMaxX - 1, tile.mMinY + 1, fadeCol);
-    drawPoint(buf, tile.mMaxX - 3, tile.mMinY,     col);
-    drawPoint(buf, tile.mMaxX - 1, tile.mMinY + 2, col);
-
-    drawPoint(buf, tile.mMaxX - 1, tile.mMaxY - 1, col);
-    drawPoint(buf, tile.mMaxX - 2, tile.mMaxY - 1, fadeCol);
-    drawPoint(buf, tile.mMaxX - 1, tile.mMaxY - 2, fadeCol);
-    drawPoint(buf, tile.mMaxX - 3, tile.mMaxY - 1, col);
-    drawPoint(buf, tile.mMaxX - 1, tile.mMaxY - 3, col);
-}
 
-template <typename BufferType, typename ScalarType> void
-drawClippedPoint(BufferType *buf, unsigned x, unsigned y, const ScalarType col)
-{
-    if (x < buf->getWidth() && y < buf->getHeight()) {
-        drawPoint(buf, x, y, col);
+    const float *pixel = reinterpret_cast<const float *>(buffer.getData()) +
+                         (size_t(y) * buffer.getWidth() + x) * channels;
+    QString text;
+    for (unsigned c = 0; c < channels; ++c) {
+        text += QString::number(pixel[c], 'g', 5) + (c + 1 < channels ? " " : "");
     }
+    return text;
 }
 
-template<typename BufferType, typename ScalarType> void
-drawPartialTileOutlineClipped(BufferType *buf, const scene_rdl2::fb_util::Tile &tile, const ScalarType col)
-{
-    ScalarType fadeCol = fadeColor(col);
-
-    drawClippedPoint(buf, tile.mMinX,     tile.mMinY,     col);
-    drawClippedPoint(buf, tile.mMinX + 1, tile.mMinY,     col);
-    drawClippedPoint(buf, tile.mMinX,     tile.mMinY + 1, col);
-    drawClippedPoint(buf, tile.mMinX + 2, tile.mMinY,     fadeCol);
-    drawClippedPoint(buf, tile.mMinX,     tile.mMinY + 2, fadeCol);
-
-    drawClippedPoint(buf, tile.mMinX,     tile.mMaxY - 1, col);
-    drawClippedPoint(buf, tile.mMinX + 1, tile.mMaxY - 1, col);
-    drawClippedPoint(buf, tile.mMinX,     tile.mMaxY - 2, col);
-    drawClippedPoint(buf, tile.mMinX + 2, tile.mMaxY - 1, fadeCol);
-    drawClippedPoint(buf, tile.mMinX,     tile.mMaxY - 3, fadeCol);
-
-    drawClippedPoint(buf, tile.mMaxX - 1, tile.mMinY,     col);
-    drawClippedPoint(buf, tile.mMaxX - 2, tile.mMinY,     col);
-    drawClippedPoint(buf, tile.mMaxX - 1, tile.mMinY + 1, col);
-    drawClippedPoint(buf, tile.mMaxX - 3, tile.mMinY,     fadeCol);
-    drawClippedPoint(buf, tile.mMaxX - 1, tile.mMinY + 2, fadeCol);
-
-    drawClippedPoint(buf, tile.mMaxX - 1, tile.mMaxY - 1, col);
-    drawClippedPoint(buf, tile.mMaxX - 2, tile.mMaxY - 1, col);
-    drawClippedPoint(buf, tile.mMaxX - 1, tile.mMaxY - 2, col);
-    drawClippedPoint(buf, tile.mMaxX - 3, tile.mMaxY - 1, fadeCol);
-    drawClippedPoint(buf, tile.mMaxX - 1, tile.mMaxY - 3, fadeCol);
-}
-
-template<typename BufferType, typename ScalarType> void
-drawTileOutline(BufferType *buf, const scene_rdl2::fb_util::Tile &tile, const ScalarType col)
-{
-    if (DRAW_PARTIAL_TILE_OUTLINE) {
-        if (tile.getArea() == 64) {
-            drawPartialTileOutline(buf, tile, col);
-        } else {
-            drawPartialTileOutlineClipped(buf, tile, col);
-        }
-    } else {
-        drawFullTileOutline(buf, tile, col);
-    }
 }
 
 RenderGui::RenderGui(CameraType initialCamType,
@@ -215,15 +105,41 @@ RenderGui::RenderGui(CameraType initialCamType,
     , mLastSnapshotTimestamp(0)
     , mLastSnapshotTime(0.0)
     , mLastFilmActivity(0)
-    , mLastCameraUpdateTime(0)
     , mLastCameraXform()
     , mC12C0()
     , mLastRenderOutputGuiIndx(0)
     , mRenderOutput(-1)
     , mLastTotalRenderOutputs(0)
-    , mLastRenderOutputName("")
+    , mRenderOutputCache(size_t(RENDER_OUTPUT_CACHE_BUDGET_MB) << 20)
+    , mLastPaneToggleCount(0)
+    , mLastContactSheetTime(0.0)
+    , mLastProbeX(-1)
+    , mLastProbeY(-1)
+    , mLastProbeTime(0.0)
+    , mDisplayUpdateCount(0)
+    , mLastProbeDisplayUpdate(0)
+    , mPickBufferEnabled(false)
+    , mPickBufferTimestamp(0)
+    , mPickBufferFilmActivity(0)
+    , mLastPickBufferTime(0.0)
+    , mStreamClient(nullptr)
+    , mStreamFastProgressive(false)
+    , mStreamFastMode(moonray::rndr::FastRenderMode::NORMALS)
+    , mOutputWriter(nullptr)
+    , mLastBufferPoolTime(0.0)
+    , mLastMemoryStatsTime(0.0)
+    , mPicksPaused(false)
     , mHandler(nullptr)
     , mOkToRenderTiles(false)
+    , mTileEpoch(util::getSeconds())
+    , mDenoiserCache(DENOISER_CACHE_SIZE)
+    , mLastFrameWidth(0)
+    , mLastFrameHeight(0)
+    , mLastCameraMoveTime(0.0)
+    , mReducedResDenoiseShown(false)
+    , mBaseRes(1.f)
+    , mLastRealtimeFrameEnd(-1.0)
+    , mDisplayScale(1.f)
     , mColorManager()
 {
     mMainWindow = new MainWindow(nullptr, mInitialCameraType, crtOverride, snapPath);
@@ -235,15 +151,181 @@ RenderGui::RenderGui(CameraType initialCamType,
     mHandler->mIsActive = true;
     mMasterTimestamp = 1;
     mColorManager.setupConfig();
+
+    // Buffers are sized by whatever first snapshots into them, and freed
+    // again when the feature they belong to goes unused. The render buffer
+    // is kept, since it is shown again as is when switching render outputs
+    // and is all there is of a streamed frame.
+    mBufferPool.addPinned(BUFFER_FRAME, &mRenderBuffer);
+    mBufferPool.add(BUFFER_FRAME, &mHeatMapBuffer);
+    mBufferPool.add(BUFFER_FRAME, &mWeightBuffer);
+    mBufferPool.add(BUFFER_FRAME, &mRenderBufferOdd);
+    mBufferPool.add(BUFFER_FRAME, &mRenderOutputBuffer);
+    mBufferPool.add(BUFFER_FRAME, &mDisplayBuffer);
+    mBufferPool.add(BUFFER_FRAME, &mPaneDisplayBuffer);
+    mBufferPool.add(BUFFER_FRAME,
+                    [this] {
+                        size_t size = 0;
+                        for (const auto &buffer : mPaneOutputBuffers) {
+                            size += getBufferSize(buffer);
+                        }
+                        for (const PaneCache &cache : mPaneCaches) {
+                            size += size_t(cache.mImage.bytesPerLine()) * cache.mImage.height();
+                        }
+                        return size;
+                    },
+                    [this] {
+                        std::vector<scene_rdl2::fb_util::VariablePixelBuffer>().swap(mPaneOutputBuffers);
+                        std::vector<PaneCache>().swap(mPaneCaches);
+                    });
+
+    mBufferPool.add(BUFFER_DENOISE, &mDenoisedRenderBuffer);
+    mBufferPool.add(BUFFER_DENOISE, &mAlbedoBuffer);
+    mBufferPool.add(BUFFER_DENOISE, &mNormalBuffer);
+    mBufferPool.add(BUFFER_DENOISE, &mDenoiserOutputBuffer);
+    mBufferPool.add(BUFFER_DENOISE, &mRegionBeautyBuffer);
+    mBufferPool.add(BUFFER_DENOISE, &mRegionAlbedoBuffer);
+    mBufferPool.add(BUFFER_DENOISE, &mRegionNormalBuffer);
+    mBufferPool.add(BUFFER_DENOISE, &mLowResBeautyBuffer);
+    mBufferPool.add(BUFFER_DENOISE, &mLowResAlbedoBuffer);
+    mBufferPool.add(BUFFER_DENOISE, &mLowResNormalBuffer);
+    mBufferPool.add(BUFFER_DENOISE, &mUpsampledBuffer);
+
+    mBufferPool.add(BUFFER_REPROJECTION, &mReprojectedRenderBuffer);
+    mBufferPool.add(BUFFER_REPROJECTION, &mDepthOutputBuffer);
+    mBufferPool.add(BUFFER_REPROJECTION, &mReprojectionWeightBuffer);
+    mBufferPool.add(BUFFER_REPROJECTION,
+                    [this] { return mReprojector.getMemoryUsage(); },
+                    [this] { mReprojector.release(); });
+
+    mBufferPool.add(BUFFER_PICK, &mPickDepthBuffer);
+    mBufferPool.add(BUFFER_PICK, &mPickGeometryIdBuffer);
+    mBufferPool.add(BUFFER_PICK, &mPickMaterialIdBuffer);
+    mBufferPool.add(BUFFER_PICK, &mPickWeightBuffer);
+
+    mBufferPool.add(BUFFER_CONTACT_SHEET, &mContactSheetOutputBuffer);
+    mBufferPool.add(BUFFER_CONTACT_SHEET, &mContactSheetThumbnail);
+    mBufferPool.add(BUFFER_CONTACT_SHEET, &mContactSheetBeauty);
+    mBufferPool.add(BUFFER_CONTACT_SHEET, &mContactSheetDisplayBuffer);
+
+    // The render output cache keeps within its own budget, and is needed
+    // again as soon as another output is selected.
+    mBufferPool.add(BUFFER_RENDER_OUTPUT_CACHE,
+                    [this] { return mRenderOutputCache.getMemoryUsage(); },
+                    nullptr);
+
+    // The history is only ever added to by the user, so it is left to them.
+    mBufferPool.add(BUFFER_SNAPSHOT_HISTORY,
+                    [this] { return mMainWindow->getRenderViewport()->getSnapshotHistoryMemoryUsage(); },
+                    nullptr);
+
+    mBufferPool.add(BUFFER_OUTPUT_WRITER,
+                    [this] { return mOutputWriter ? mOutputWriter->getMemoryUsage() : 0; },
+                    [this] { if (mOutputWriter) mOutputWriter->releaseUnused(); });
 }
 
 
 RenderGui::~RenderGui()
 {
+    if (mBufferPool.getPeakTotal()) {
+        std::cout << "Peak GUI buffer memory: " << (mBufferPool.getPeakTotal() >> 20) << " MB" << std::endl;
+    }
     delete mMainWindow;
     delete mHandler;
 }
 
+void
+RenderGui::enablePickBuffer(const std::string &geometryIdOutput, const std::string &materialIdOutput)
+{
+    mPickBufferEnabled = true;
+    mPickGeometryIdOutput = geometryIdOutput;
+    mPickMaterialIdOutput = materialIdOutput;
+    mMainWindow->getRenderViewport()->setPickBuffer(&mPickBuffer);
+}
+
+bool
+RenderGui::recordSession(const std::string &path)
+{
+    return mMainWindow->getRenderViewport()->recordSession(path);
+}
+
+bool
+RenderGui::replaySession(const std::string &path)
+{
+    return mMainWindow->getRenderViewport()->replaySession(path);
+}
+
+bool
+RenderGui::runConvergenceBenchmark(const std::string &reference, const std::string &outputPrefix,
+                                   double runDuration)
+{
+    std::unique_ptr<ConvergenceBenchmark> benchmark(new ConvergenceBenchmark(outputPrefix, runDuration));
+    if (!benchmark->loadReference(reference)) {
+        return false;
+    }
+    mConvergenceBenchmark = std::move(benchmark);
+    return true;
+}
+
+bool
+RenderGui::enableFrameServer(const std::string &name)
+{
+    const std::string prefix = "/moonray_gui_" + name;
+    return mLinearFrameWriter.open(prefix + ".linear") &&
+           mMainWindow->getRenderViewport()->publishDisplayFrames(prefix + ".display");
+}
+
+void
+RenderGui::publishLinearFrame(const scene_rdl2::fb_util::RenderBuffer &renderBuffer,
+                              const scene_rdl2::fb_util::VariablePixelBuffer &renderOutputBuffer,
+                              bool parallel)
+{
+    // Rows are flipped to run from the top, like the displayed frame.
+    if (mRenderOutput < 0) {
+        const unsigned w = renderBuffer.getWidth();
+        const unsigned h = renderBuffer.getHeight();
+        mLinearFrameWriter.write(mDisplayUpdateCount, w, h, 4, SharedFrameHeader::FLOAT32, parallel,
+                                 [&](unsigned y) { return renderBuffer.getRow(h - 1 - y); });
+        return;
+    }
+
+    unsigned channels;
+    switch (renderOutputBuffer.getFormat()) {
+    case scene_rdl2::fb_util::VariablePixelBuffer::FLOAT:  channels = 1; break;
+    case scene_rdl2::fb_util::VariablePixelBuffer::FLOAT2: channels = 2; break;
+    case scene_rdl2::fb_util::VariablePixelBuffer::FLOAT3: channels = 3; break;
+    case scene_rdl2::fb_util::VariablePixelBuffer::FLOAT4: channels = 4; break;
+    default: return;
+    }
+    const unsigned w = renderOutputBuffer.getWidth();
+    const unsigned h = renderOutputBuffer.getHeight();
+    const float *data = reinterpret_cast<const float *>(renderOutputBuffer.getData());
+    mLinearFrameWriter.write(mDisplayUpdateCount, w, h, channels, SharedFrameHeader::FLOAT32, parallel,
+                             [&](unsigned y) { return data + size_t(h - 1 - y) * w * channels; });
+}
+
+void
+RenderGui::updateConvergenceBenchmark(double currentTime)
+{
+    if (!mConvergenceBenchmark || mConvergenceBenchmark->isWaitingForFrame()) return;
+    if (mConvergenceBenchmark->isRunning() && !mConvergenceBenchmark->isRunFinished(currentTime)) return;
+
+    ConvergenceRun run;
+    if (mConvergenceBenchmark->nextRun(&run)) {
+        // Each run starts from an empty frame.
+        RenderViewport *vp = mMainWindow->getRenderViewport();
+        vp->setFastProgressive(run.mFastProgressive);
+        vp->setDenoisingEnabled(run.mDenoise);
+        mReprojector.clearHistory();
+        ++mMasterTimestamp;
+        return;
+    }
+
+    mConvergenceBenchmark->writeResults();
+    mConvergenceBenchmark.reset();
+    QMetaObject::invokeMethod(mMainWindow, "close", Qt::QueuedConnection);
+}
+
 
 bool
 RenderGui::isActive()
@@ -268,8 +350,14 @@ void
 RenderGui::updateFrame(const scene_rdl2::fb_util::RenderBuffer *renderBuffer,
                        const scene_rdl2::fb_util::VariablePixelBuffer *renderOutputBuffer,
                        bool showProgress,
-                       bool parallel)
+                       bool parallel,
+                       std::shared_ptr<const FrameSnapshot> snapshot)
 {
+    ++mDisplayUpdateCount;
+
+    const double currentTime = util::getSeconds();
+    mBufferPool.touch(BUFFER_FRAME, currentTime);
+
     const DebugMode mode = mMainWindow->getRenderViewport()->getDebugMode();
     const bool applyCrt = mMainWindow->getRenderViewport()->getApplyColorRenderTransform();
     const float exposure = mMainWindow->getRenderViewport()->getExposure();
@@ -277,68 +365,65 @@ RenderGui::updateFrame(const scene_rdl2::fb_util::RenderBuffer *renderBuffer,
     const bool useOCIO = mMainWindow->getRenderViewport()->getUseOCIO();
     bool denoise = mMainWindow->getRenderViewport()->getDenoisingEnabled();
 
-    // Apply denoising whilst frame is in linear HDR format.
-    if (denoise && mode != NUM_SAMPLES && mRenderOutput < 0) {
-        unsigned w = renderBuffer->getWidth();
-        unsigned h = renderBuffer->getHeight();
-
-        const moonray::rndr::RenderOutputDriver *rod = mRenderContext->getRenderOutputDriver();
-        const int albedoIndx = rod->getDenoiserAlbedoInput();
-        const int normalIndx = rod->getDenoiserNormalInput();
-
-        moonray::denoiser::DenoiserMode mode = mMainWindow->getRenderViewport()->getDenoiserMode();
-
-        DenoisingBufferMode bufferMode = mMainWindow->getRenderViewport()->getDenoisingBufferMode();
-        bool useAlbedo = (albedoIndx >= 0 && bufferMode != DN_BUFFERS_BEAUTY);
-        bool useNormals = (albedoIndx >= 0 && normalIndx >= 0) && bufferMode == DN_BUFFERS_BEAUTY_ALBEDO_NORMALS;
-
-        // Recreate denoiser if not yet created or config has changed
-        if (mDenoiser == nullptr ||
-            mode != mDenoiser->mode() ||
-            w != mDenoiser->imageWidth() || h != mDenoiser->imageHeight() ||
-            useAlbedo != mDenoiser->useAlbedo() ||
-            useNormals != mDenoiser->useNormals()) {
-            std::string errorMsg;
-            mDenoiser = std::make_unique<moonray::denoiser::Denoiser>(
-                mode, w, h, useAlbedo, useNormals, &errorMsg);
-            if (!errorMsg.empty()) {
-                std::cout << "Error creating denoiser: " << errorMsg << std::endl;
-                mDenoiser.release();
-            }
-            mDenoisedRenderBuffer.init(w, h);
-        }
-
-        if (mDenoiser) {
-            if (useAlbedo) {
-                mRenderContext->snapshotAovBuffer(&mAlbedoBuffer, rod->getAovBuffer(albedoIndx), true, false);
-            }
+    // Warm up a denoiser for the current configuration at startup and whenever
+    // the resolution changes, so turning denoising on doesn't stall the frame loop.
+    if (renderBuffer->getWidth() != mLastFrameWidth || renderBuffer->getHeight() != mLastFrameHeight) {
+        mLastFrameWidth = renderBuffer->getWidth();
+        mLastFrameHeight = renderBuffer->getHeight();
+        mDenoiserCache.prefetch(getDenoiserConfig(mLastFrameWidth, mLastFrameHeight));
+
+        // Also warm up the reduced resolution denoiser used during navigation.
+        const unsigned factor = getMotionDenoiseFactor(mLastFrameWidth, mLastFrameHeight);
+        mDenoiserCache.prefetch(getDenoiserConfig((mLastFrameWidth + factor - 1) / factor,
+                                                  (mLastFrameHeight + factor - 1) / factor));
+    }
 
-            if (useNormals) {
-                mRenderContext->snapshotAovBuffer(&mNormalBuffer, rod->getAovBuffer(normalIndx), true, false);
-            }
+    std::shared_ptr<const TileProgress> tileProgress;
+    if (showProgress) {
+        tileProgress = updateTileProgress(renderBuffer->getWidth(), renderBuffer->getHeight());
+    }
 
-            const scene_rdl2::fb_util::RenderColor *inputBeautyPixels = renderBuffer->getData();
-            const scene_rdl2::fb_util::RenderColor *inputAlbedoPixels = useAlbedo ? mAlbedoBuffer.getData() : nullptr;
-            const scene_rdl2::fb_util::RenderColor *inputNormalPixels = useNormals ? mNormalBuffer.getData() : nullptr;
-            scene_rdl2::fb_util::RenderColor *denoisedPixels = mDenoisedRenderBuffer.getData();
-            std::string errorMsg;
+    // Fill in the parts of a restarted frame which have no samples yet from
+    // the previous one. This happens before denoising so the denoiser sees
+    // the combined frame. Not while benchmarking, where it would carry one
+    // run's converged frame into the next.
+    if (mRenderOutput < 0 && mode != NUM_SAMPLES) {
+        if (mMainWindow->getRenderViewport()->getReprojectionEnabled() && !mConvergenceBenchmark) {
+            renderBuffer = reprojectFrame(renderBuffer, parallel);
+        } else {
+            mReprojector.clearHistory();
+        }
+    }
 
-            mDenoiser->denoise(reinterpret_cast<const float*>(inputBeautyPixels),
-                               reinterpret_cast<const float*>(inputAlbedoPixels),
-                               reinterpret_cast<const float*>(inputNormalPixels),
-                               reinterpret_cast<float*>(denoisedPixels),
-                               &errorMsg);
+    // Apply denoising whilst frame is in linear HDR format. Anything not
+    // denoised is shown at full resolution, so needs no refresh later.
+    if (denoise && mode != NUM_SAMPLES && mRenderOutput < 0) {
+        renderBuffer = denoiseFrame(renderBuffer, parallel);
+    } else {
+        mReducedResDenoiseShown = false;
+    }
 
-            if (!errorMsg.empty()) {
-                std::cout << "Error denoising: " << errorMsg << std::endl;
-            }
+    // Measure what the user would be looking at.
+    if (mConvergenceBenchmark && mRenderContext && mode != NUM_SAMPLES && mRenderOutput < 0) {
+        mConvergenceBenchmark->addSample(util::getSeconds(), *renderBuffer, mRenderContext->isFrameComplete());
+    }
 
-            renderBuffer = &mDenoisedRenderBuffer;
-        }
+    // The sample count view has no linear frame of its own to publish.
+    if (mLinearFrameWriter.isOpen() && mode != NUM_SAMPLES) {
+        publishLinearFrame(*renderBuffer, *renderOutputBuffer, parallel);
     }
 
     /// -------------------------------- Color Grading -------------------------------------------------
 
+    scene_rdl2::fb_util::PixelBufferUtilOptions options = parallel?
+            scene_rdl2::fb_util::PIXEL_BUFFER_UTIL_OPTIONS_PARALLEL :
+            scene_rdl2::fb_util::PIXEL_BUFFER_UTIL_OPTIONS_NONE;
+
+    // Panes always take the CPU color transform, whichever path the frame takes.
+    std::vector<DisplayPane> panes = getDisplayPanes(*renderBuffer, options, parallel);
+    const QString frameLabel = mRenderOutput < 0 ? QString("beauty") :
+                                                   QString::fromStdString(mRenderOutputNames[mRenderOutput]);
+
     // assumes user is directly applying lut instead of ocio config file
     if (// are we applying the color render transform?
         applyCrt
@@ -348,16 +433,8 @@ RenderGui::updateFrame(const scene_rdl2::fb_util::RenderBuffer *renderBuffer,
         // but we cheat a bit and apply the transform to any 3 or 4
         // channel aov
         && (mRenderOutput < 0
-            || mRenderOutputBuffer.getFormat() == scene_rdl2::fb_util::VariablePixelBuffer::FLOAT3
-            || mRenderOutputBuffer.getFormat() == scene_rdl2::fb_util::VariablePixelBuffer::FLOAT4)) {
-
-        // draw the tile progress boxes into the approriate buffer
-        if (showProgress) {
-            DisplayBuffer buf = mRenderOutput < 0?
-                DISPLAY_BUFFER_IS_RENDER_BUFFER:
-                DISPLAY_BUFFER_IS_RENDER_OUTPUT_BUFFER;
-            showTileProgress(buf);
-        }
+            || renderOutputBuffer->getFormat() == scene_rdl2::fb_util::VariablePixelBuffer::FLOAT3
+            || renderOutputBuffer->getFormat() == scene_rdl2::fb_util::VariablePixelBuffer::FLOAT4)) {
 
         FrameBuffer frame;
         FrameType frameType;
@@ -365,13 +442,13 @@ RenderGui::updateFrame(const scene_rdl2::fb_util::RenderBuffer *renderBuffer,
             frame.xyzw32 = renderBuffer;
             frameType = FRAME_TYPE_IS_XYZW32;
         } else {
-            switch (mRenderOutputBuffer.getFormat()) {
+            switch (renderOutputBuffer->getFormat()) {
             case scene_rdl2::fb_util::VariablePixelBuffer::FLOAT3:
-                frame.xyz32 = &mRenderOutputBuffer.getFloat3Buffer();
+                frame.xyz32 = &renderOutputBuffer->getFloat3Buffer();
                 frameType = FRAME_TYPE_IS_XYZ32;
                 break;
             case scene_rdl2::fb_util::VariablePixelBuffer::FLOAT4:
-                frame.xyzw32 = &mRenderOutputBuffer.getFloat4Buffer();
+                frame.xyzw32 = &renderOutputBuffer->getFloat4Buffer();
                 frameType = FRAME_TYPE_IS_XYZW32;
                 break;
             default:
@@ -382,15 +459,15 @@ RenderGui::updateFrame(const scene_rdl2::fb_util::RenderBuffer *renderBuffer,
            }
         }
         // QApplication::postEvent handles deleting the raw pointer later, no risk of memory leak
-        FrameUpdateEvent *event = new FrameUpdateEvent(frame, frameType, mode, exposure, gamma);
+        FrameUpdateEvent *event = new FrameUpdateEvent(frame, frameType, mode, exposure, gamma,
+                                                       std::move(tileProgress), std::move(snapshot));
+        event->setDisplayScale(mDisplayScale);
+        event->setFrameNumber(mDisplayUpdateCount);
+        event->setPanes(std::move(panes), frameLabel);
         QApplication::postEvent(mMainWindow, event);
         return;
     }
 
-    scene_rdl2::fb_util::PixelBufferUtilOptions options = parallel?
-            scene_rdl2::fb_util::PIXEL_BUFFER_UTIL_OPTIONS_PARALLEL :
-            scene_rdl2::fb_util::PIXEL_BUFFER_UTIL_OPTIONS_NONE;
-
     // Apply color render transform
     mColorManager.applyCRT(mMainWindow, 
                            useOCIO, 
@@ -401,19 +478,241 @@ RenderGui::updateFrame(const scene_rdl2::fb_util::RenderBuffer *renderBuffer,
                            options, 
                            parallel);
 
-    if (showProgress) {
-        showTileProgress(DISPLAY_BUFFER_IS_DISPLAY_BUFFER);
-    }
-
     // Post an event to the main window on the GUI thread. Thankfully,
     // QCoreApplication::postEvent() is thread-safe.
     FrameBuffer frame;
     frame.rgb8 = &mDisplayBuffer;
-    FrameUpdateEvent* event = new FrameUpdateEvent(frame, FRAME_TYPE_IS_RGB8, mode, exposure, gamma);
+    FrameUpdateEvent* event = new FrameUpdateEvent(frame, FRAME_TYPE_IS_RGB8, mode, exposure, gamma,
+                                                   std::move(tileProgress));
+    event->setDisplayScale(mDisplayScale);
+    event->setFrameNumber(mDisplayUpdateCount);
+    event->setPanes(std::move(panes), frameLabel);
     QApplication::postEvent(mMainWindow, event);
 }
 
-void
+DenoiserConfig
+RenderGui::getDenoiserConfig(unsigned w, unsigned h) const
+{
+    // The render output driver is only set up once a frame has been started,
+    // and streamed frames come without the denoiser's other inputs.
+    const moonray::rndr::RenderOutputDriver *rod = mRenderContext ? mRenderContext->getRenderOutputDriver() : nullptr;
+    const int albedoIndx = rod ? rod->getDenoiserAlbedoInput() : -1;
+    const int normalIndx = rod ? rod->getDenoiserNormalInput() : -1;
+
+    DenoisingBufferMode bufferMode = mMainWindow->getRenderViewport()->getDenoisingBufferMode();
+
+    DenoiserConfig config;
+    config.mMode = mMainWindow->getRenderViewport()->getDenoiserMode();
+    config.mWidth = w;
+    config.mHeight = h;
+    config.mUseAlbedo = (albedoIndx >= 0 && bufferMode != DN_BUFFERS_BEAUTY);
+    config.mUseNormals = (albedoIndx >= 0 && normalIndx >= 0) && bufferMode == DN_BUFFERS_BEAUTY_ALBEDO_NORMALS;
+    return config;
+}
+
+unsigned
+RenderGui::getMotionDenoiseFactor(unsigned w, unsigned h)
+{
+    return size_t(w) * size_t(h) > MOTION_DENOISE_QUARTER_RES_PIXELS ? 4 : 2;
+}
+
+int
+RenderGui::getDepthRenderOutput() const
+{
+    const moonray::rndr::RenderOutputDriver *rod = mRenderContext->getRenderOutputDriver();
+    if (!rod) {
+        return -1;
+    }
+    for (unsigned i = 0; i < rod->getNumberOfRenderOutputs(); ++i) {
+        if (rod->getRenderOutput(i)->getResult() == rdl2::RenderOutput::RESULT_DEPTH) {
+            return int(i);
+        }
+    }
+    return -1;
+}
+
+const scene_rdl2::fb_util::RenderBuffer *
+RenderGui::reprojectFrame(const scene_rdl2::fb_util::RenderBuffer *renderBuffer, bool parallel)
+{
+    // Realtime and streamed frames are shown as they are.
+    if (!mRenderContext || mRenderContext->getRenderMode() == moonray::rndr::RenderMode::REALTIME) {
+        mReprojector.clearHistory();
+        return renderBuffer;
+    }
+
+    // We need a depth output to know where each pixel lands in the new view,
+    // and a perspective camera to project with.
+    const int depthIndx = getDepthRenderOutput();
+    CameraProjection projection;
+    if (depthIndx < 0 || !CameraProjection::fromCamera(mRenderContext->getCamera(), &projection)) {
+        mReprojector.clearHistory();
+        return renderBuffer;
+    }
+    // Only a frame seen from elsewhere needs reprojecting, and a completed
+    // frame only needs storing once. Blending in history from the same view
+    // would just hold on to stale pixels.
+    if (mReprojector.hasHistoryFrom(mLastCameraXform)) {
+        return renderBuffer;
+    }
+    mBufferPool.touch(BUFFER_REPROJECTION, util::getSeconds());
+
+    mRenderContext->snapshotRenderOutput(&mDepthOutputBuffer, depthIndx,
+                                         &mRenderBuffer, &mHeatMapBuffer, &mWeightBuffer, &mRenderBufferOdd,
+                                         true, parallel);
+    if (mDepthOutputBuffer.getFormat() != scene_rdl2::fb_util::VariablePixelBuffer::FLOAT) {
+        mReprojector.clearHistory();
+        return renderBuffer;
+    }
+    const scene_rdl2::fb_util::FloatBuffer &depth = mDepthOutputBuffer.getFloatBuffer();
+
+    // A completed frame is the best history we can have, and needs no help.
+    if (mRenderContext->isFrameComplete()) {
+        mReprojector.setHistory(*renderBuffer, depth, mLastCameraXform, projection);
+        return renderBuffer;
+    }
+
+    mRenderContext->snapshotWeightBuffer(&mReprojectionWeightBuffer, true, parallel);
+    if (!mReprojector.reproject(*renderBuffer, depth, mReprojectionWeightBuffer,
+                                mLastCameraXform, projection, &mReprojectedRenderBuffer, parallel)) {
+        return renderBuffer;
+    }
+    return &mReprojectedRenderBuffer;
+}
+
+const scene_rdl2::fb_util::RenderBuffer *
+RenderGui::denoiseFrame(const scene_rdl2::fb_util::RenderBuffer *renderBuffer, bool parallel)
+{
+    const unsigned w = renderBuffer->getWidth();
+    const unsigned h = renderBuffer->getHeight();
+
+    // When the user has selected a region we only denoise that region plus a
+    // margin of surrounding context, and composite the result back into the
+    // noisy frame.
+    scene_rdl2::math::HalfOpenViewport region;
+    const bool useRegion = mMainWindow->getRenderViewport()->getDenoiseRegion(w, h, region) &&
+                           clipRegion(region, w, h);
+    const scene_rdl2::math::HalfOpenViewport denoiseRegion = useRegion ?
+        expandRegion(region, DENOISE_REGION_MARGIN, w, h) :
+        scene_rdl2::math::HalfOpenViewport(0, 0, int(w), int(h));
+    const unsigned dw = unsigned(denoiseRegion.mMaxX - denoiseRegion.mMinX);
+    const unsigned dh = unsigned(denoiseRegion.mMaxY - denoiseRegion.mMinY);
+
+    // Frames only live for a few milliseconds while the camera is moving, so
+    // during navigation we denoise a downsampled copy of the frame and
+    // upsample the result.
+    const double currentTime = util::getSeconds();
+    mBufferPool.touch(BUFFER_DENOISE, currentTime);
+    const bool cameraMoving = (currentTime - mLastCameraMoveTime) < MOTION_DENOISE_IDLE_TIME;
+    const unsigned factor = cameraMoving ? getMotionDenoiseFactor(dw, dh) : 1;
+    const unsigned lw = (dw + factor - 1) / factor;
+    const unsigned lh = (dh + factor - 1) / factor;
+
+    // Denoisers are created in the background. Show the noisy frame until the
+    // one we need is ready, and ask for a refresh so the denoised frame is
+    // shown as soon as it is, even if rendering has already completed.
+    const DenoiserConfig config = getDenoiserConfig(lw, lh);
+    bool pending = false;
+    moonray::denoiser::Denoiser *denoiser = mDenoiserCache.acquire(config, &pending);
+    if (!denoiser) {
+        mReducedResDenoiseShown = false;
+        if (pending) {
+            mMainWindow->getRenderViewport()->setNeedsRefresh(true);
+        }
+        return renderBuffer;
+    }
+
+    if (mDenoiserOutputBuffer.getWidth() != lw || mDenoiserOutputBuffer.getHeight() != lh) {
+        mDenoiserOutputBuffer.init(lw, lh);
+    }
+
+    const bool useAlbedo = config.mUseAlbedo;
+    const bool useNormals = config.mUseNormals;
+    const moonray::rndr::RenderOutputDriver *rod = mRenderContext ? mRenderContext->getRenderOutputDriver() : nullptr;
+    if (useAlbedo) {
+        mRenderContext->snapshotAovBuffer(&mAlbedoBuffer, rod->getAovBuffer(rod->getDenoiserAlbedoInput()),
+                                          true, false);
+    }
+
+    if (useNormals) {
+        mRenderContext->snapshotAovBuffer(&mNormalBuffer, rod->getAovBuffer(rod->getDenoiserNormalInput()),
+                                          true, false);
+    }
+
+    const scene_rdl2::fb_util::RenderBuffer *beautyInput = renderBuffer;
+    const scene_rdl2::fb_util::RenderBuffer *albedoInput = &mAlbedoBuffer;
+    const scene_rdl2::fb_util::RenderBuffer *normalInput = &mNormalBuffer;
+    if (useRegion) {
+        cropBuffer(*renderBuffer, denoiseRegion, &mRegionBeautyBuffer);
+        beautyInput = &mRegionBeautyBuffer;
+        if (useAlbedo) {
+            cropBuffer(mAlbedoBuffer, denoiseRegion, &mRegionAlbedoBuffer);
+            albedoInput = &mRegionAlbedoBuffer;
+        }
+        if (useNormals) {
+            cropBuffer(mNormalBuffer, denoiseRegion, &mRegionNormalBuffer);
+            normalInput = &mRegionNormalBuffer;
+        }
+    }
+
+    // Full resolution guides are kept around for the upsample.
+    const scene_rdl2::fb_util::RenderBuffer *albedoGuide = useAlbedo ? albedoInput : nullptr;
+    const scene_rdl2::fb_util::RenderBuffer *normalGuide = useNormals ? normalInput : nullptr;
+    if (factor > 1) {
+        downsampleBuffer(*beautyInput, factor, &mLowResBeautyBuffer, parallel);
+        beautyInput = &mLowResBeautyBuffer;
+        if (useAlbedo) {
+            downsampleBuffer(*albedoInput, factor, &mLowResAlbedoBuffer, parallel);
+            albedoInput = &mLowResAlbedoBuffer;
+        }
+        if (useNormals) {
+            downsampleBuffer(*normalInput, factor, &mLowResNormalBuffer, parallel);
+            normalInput = &mLowResNormalBuffer;
+        }
+    }
+
+    const scene_rdl2::fb_util::RenderColor *inputBeautyPixels = beautyInput->getData();
+    const scene_rdl2::fb_util::RenderColor *inputAlbedoPixels = useAlbedo ? albedoInput->getData() : nullptr;
+    const scene_rdl2::fb_util::RenderColor *inputNormalPixels = useNormals ? normalInput->getData() : nullptr;
+    scene_rdl2::fb_util::RenderColor *denoisedPixels = mDenoiserOutputBuffer.getData();
+    std::string errorMsg;
+
+    denoiser->denoise(reinterpret_cast<const float*>(inputBeautyPixels),
+                      reinterpret_cast<const float*>(inputAlbedoPixels),
+                      reinterpret_cast<const float*>(inputNormalPixels),
+                      reinterpret_cast<float*>(denoisedPixels),
+                      &errorMsg);
+
+    if (!errorMsg.empty()) {
+        std::cout << "Error denoising: " << errorMsg << std::endl;
+    }
+
+    // Remember to redisplay at full resolution once the camera settles.
+    mReducedResDenoiseShown = (factor > 1);
+
+    const scene_rdl2::fb_util::RenderBuffer *denoised = &mDenoiserOutputBuffer;
+    if (factor > 1) {
+        if (mUpsampledBuffer.getWidth() != dw || mUpsampledBuffer.getHeight() != dh) {
+            mUpsampledBuffer.init(dw, dh);
+        }
+        upsampleBuffer(mDenoiserOutputBuffer,
+                       albedoGuide, useAlbedo ? &mLowResAlbedoBuffer : nullptr,
+                       normalGuide, useNormals ? &mLowResNormalBuffer : nullptr,
+                       &mUpsampledBuffer, parallel);
+        denoised = &mUpsampledBuffer;
+    }
+
+    if (!useRegion) {
+        return denoised;
+    }
+
+    // Composite the denoised region (without its margin) over the noisy frame.
+    cropBuffer(*renderBuffer, scene_rdl2::math::HalfOpenViewport(0, 0, int(w), int(h)),
+               &mDenoisedRenderBuffer);
+    pasteBuffer(*denoised, denoiseRegion, region, &mDenoisedRenderBuffer);
+    return &mDenoisedRenderBuffer;
+}
+
+const scene_rdl2::fb_util::VariablePixelBuffer *
 RenderGui::snapshotFrame(scene_rdl2::fb_util::RenderBuffer *renderBuffer,
                          scene_rdl2::fb_util::HeatMapBuffer *heatMapBuffer,
                          scene_rdl2::fb_util::FloatBuffer *weightBuffer,
@@ -423,22 +722,54 @@ RenderGui::snapshotFrame(scene_rdl2::fb_util::RenderBuffer *renderBuffer,
 {
     DebugMode mode = mMainWindow->getRenderViewport()->getDebugMode();
 
+    // The hover probe reads the beauty and weights whatever is displayed.
+    int probeX, probeY;
+    const bool probe = mMainWindow->getRenderViewport()->getProbePosition(&probeX, &probeY);
+
     // Special case if debug mode is set to NUM_SAMPLES, in which case we want to display
     // the weights buffer directly with some transform applied to aid visualization.
     if (mode == NUM_SAMPLES) {
         mRenderContext->snapshotWeightBuffer(renderOutputBuffer, untile, parallel);
-        return;
+        if (probe) {
+            mRenderContext->snapshotRenderBuffer(renderBuffer, untile, parallel);
+            mRenderContext->snapshotWeightBuffer(weightBuffer, untile, parallel);
+        }
+        return renderOutputBuffer;
     }
 
+    const auto *rod = mRenderContext->getRenderOutputDriver();
+
+    // Source buffers are snapshotted at most once, however many of the
+    // outputs being displayed are built from them.
+    bool haveRenderBuffer = false;
+    bool haveHeatMap = false;
+    bool haveWeights = false;
+    bool haveRenderBufferOdd = false;
+    auto snapshotSources = [&](int indx) {
+        if (rod->requiresRenderBuffer(indx) && !haveRenderBuffer) {
+            mRenderContext->snapshotRenderBuffer(renderBuffer, untile, parallel);
+            haveRenderBuffer = true;
+        }
+        if (rod->requiresHeatMap(indx) && !haveHeatMap) {
+            mRenderContext->snapshotHeatMapBuffer(heatMapBuffer, untile, parallel);
+            haveHeatMap = true;
+        }
+        if (rod->requiresWeightBuffer(indx) && !haveWeights) {
+            mRenderContext->snapshotWeightBuffer(weightBuffer, untile, parallel);
+            haveWeights = true;
+        }
+        if (rod->requiresRenderBufferOdd(indx) && !haveRenderBufferOdd) {
+            mRenderContext->snapshotRenderBufferOdd(renderBufferOdd, untile, parallel);
+            haveRenderBufferOdd = true;
+        }
+    };
+
     if (mRenderOutput < 0) {
         // snapshot the plain old render buffer output
         mRenderContext->snapshotRenderBuffer(renderBuffer, untile, parallel);
-        return;
+        haveRenderBuffer = true;
     }
 
-    // snapshot something other than the render buffer
-    const auto *rod = mRenderContext->getRenderOutputDriver();
-
     // If we have had a scene change but have not yet started rendering, the
     // progressive update might call us anyway.  This works for the render
     // buffer, since the render driver referenced by RenderContext is
@@ -446,26 +777,97 @@ RenderGui::snapshotFrame(scene_rdl2::fb_util::RenderBuffer *renderBuffer,
     // the render output driver does not - and it is only setup during
     // start frame based on scene data.  We should be called
     // again shortly after the frame is started.
-    if (!rod) return;
+    if (!rod) return renderOutputBuffer;
 
-    MNRY_ASSERT(mRenderOutput < static_cast<int>(rod->getNumberOfRenderOutputs()));
+    const scene_rdl2::fb_util::VariablePixelBuffer *result = renderOutputBuffer;
+    if (mRenderOutput >= 0) {
+        MNRY_ASSERT(mRenderOutput < static_cast<int>(rod->getNumberOfRenderOutputs()));
 
-    if (rod->requiresRenderBuffer(mRenderOutput)) {
-        mRenderContext->snapshotRenderBuffer(renderBuffer, untile, parallel);
+        // Snapshot straight into the cache, so switching back to this output
+        // later can show it without waiting on a new snapshot.
+        const unsigned filmActivity = mRenderContext->getFilmActivity();
+        scene_rdl2::fb_util::VariablePixelBuffer *outputBuffer = mRenderOutputCache.acquire(mRenderOutput);
+        snapshotSources(mRenderOutput);
+        mRenderContext->snapshotRenderOutput(outputBuffer, mRenderOutput,
+                                             renderBuffer, heatMapBuffer, weightBuffer, renderBufferOdd,
+                                             untile, parallel);
+        mRenderOutputCache.tag(mRenderOutput, mRenderTimestamp, filmActivity);
+        result = outputBuffer;
+    }
+
+    if (mMainWindow->getRenderViewport()->getMultiPaneEnabled()) {
+        const unsigned filmActivity = mRenderContext->getFilmActivity();
+        mPaneOutputBuffers.resize(mPaneOutputs.size());
+        mPaneCaches.resize(mPaneOutputs.size());
+        for (size_t i = 0; i < mPaneOutputs.size(); ++i) {
+            // Nothing has landed in this output since its last snapshot.
+            PaneCache &cache = mPaneCaches[i];
+            if (cache.mRenderOutput == mPaneOutputs[i] && cache.mTimestamp == mRenderTimestamp &&
+                cache.mFilmActivity == filmActivity && mPaneOutputBuffers[i].getWidth() != 0) {
+                continue;
+            }
+            snapshotSources(mPaneOutputs[i]);
+            mRenderContext->snapshotRenderOutput(&mPaneOutputBuffers[i], mPaneOutputs[i],
+                                                 renderBuffer, heatMapBuffer, weightBuffer, renderBufferOdd,
+                                                 untile, parallel);
+            cache.mRenderOutput = mPaneOutputs[i];
+            cache.mTimestamp = mRenderTimestamp;
+            cache.mFilmActivity = filmActivity;
+            cache.mImage = QImage();
+        }
     }
-    if (rod->requiresHeatMap(mRenderOutput)) {
-        mRenderContext->snapshotHeatMapBuffer(heatMapBuffer, untile, parallel);
+
+    if (probe) {
+        if (!haveRenderBuffer) {
+            mRenderContext->snapshotRenderBuffer(renderBuffer, untile, parallel);
+        }
+        if (!haveWeights) {
+            mRenderContext->snapshotWeightBuffer(weightBuffer, untile, parallel);
+        }
     }
-    if (rod->requiresWeightBuffer(mRenderOutput)) {
-        mRenderContext->snapshotWeightBuffer(weightBuffer, untile, parallel);
+    return result;
+}
+
+void
+RenderGui::displaySnapshot(const std::shared_ptr<const FrameSnapshot> &snapshot, bool parallel)
+{
+    mBufferPool.touch(BUFFER_OUTPUT_WRITER, util::getSeconds());
+
+    DebugMode mode = mMainWindow->getRenderViewport()->getDebugMode();
+
+    // Pick out what snapshotFrame would have, but from the buffers already
+    // untiled for writing.
+    if (mode == NUM_SAMPLES) {
+        const scene_rdl2::fb_util::FloatBuffer &weights = snapshot->mWeightBuffer;
+        mRenderOutputBuffer.init(scene_rdl2::fb_util::VariablePixelBuffer::FLOAT,
+                                 weights.getWidth(), weights.getHeight());
+        std::memcpy(mRenderOutputBuffer.getFloatBuffer().getData(), weights.getData(),
+                    weights.getArea() * sizeof(float));
+    } else if (mRenderOutput >= 0) {
+        const auto *rod = mRenderContext->getRenderOutputDriver();
+        if (!rod) return;
+
+        MNRY_ASSERT(mRenderOutput < static_cast<int>(rod->getNumberOfRenderOutputs()));
+
+        mRenderContext->snapshotRenderOutput(&mRenderOutputBuffer, mRenderOutput,
+                                             &snapshot->mRenderBuffer, &snapshot->mHeatMapBuffer,
+                                             &snapshot->mWeightBuffer, &snapshot->mRenderBufferOdd,
+                                             true, parallel);
     }
-    if (rod->requiresRenderBufferOdd(mRenderOutput)) {
-        mRenderContext->snapshotRenderBufferOdd(renderBufferOdd, untile, parallel);
+
+    if (mode != NUM_SAMPLES && mMainWindow->getRenderViewport()->getMultiPaneEnabled()) {
+        mPaneOutputBuffers.resize(mPaneOutputs.size());
+        mPaneCaches.assign(mPaneOutputs.size(), PaneCache());
+        for (size_t i = 0; i < mPaneOutputs.size(); ++i) {
+            mPaneCaches[i].mRenderOutput = mPaneOutputs[i];
+            mRenderContext->snapshotRenderOutput(&mPaneOutputBuffers[i], mPaneOutputs[i],
+                                                 &snapshot->mRenderBuffer, &snapshot->mHeatMapBuffer,
+                                                 &snapshot->mWeightBuffer, &snapshot->mRenderBufferOdd,
+                                                 true, parallel);
+        }
     }
 
-    mRenderContext->snapshotRenderOutput(renderOutputBuffer, mRenderOutput,
-                                         renderBuffer, heatMapBuffer, weightBuffer, renderBufferOdd,
-                                         untile, parallel);
+    updateFrame(&snapshot->mRenderBuffer, &mRenderOutputBuffer, false, parallel, snapshot);
 }
 
 void
@@ -476,58 +878,136 @@ RenderGui::beginInteractiveRendering(const Mat4f& cameraXform,
     mLastSnapshotTimestamp = 0;
     mLastSnapshotTime = 0.0;
     mLastFilmActivity = 0;
-    mLastCameraUpdateTime = -1.0;
     mLastCameraXform = cameraXform;
 
+    // The scene may have changed under the previous frame.
+    mReprojector.clearHistory();
+
+    // Start realtime rendering at the scene's own resolution.
+    mBaseRes = mRenderContext->getSceneContext().getSceneVariables().get(rdl2::SceneVariables::sResKey);
+    mFrameRateGovernor.reset();
+    mLastRealtimeFrameEnd = -1.0;
+    mDisplayScale = 1.f;
+
     RenderViewport *vp = mMainWindow->getRenderViewport();
 
     // Give the navigation camera access to the scene in case it needs to run
     // collision checks.
     vp->setCameraRenderContext(*mRenderContext);
 
+    // Update the camera.
+    computeCameraMotionXformOffset();
+    const Mat4f conditionedXform = vp->resetCameraTransform(cameraXform, makeDefaultXform);
+    if (!isEqual(mLastCameraXform, conditionedXform)) {
+        setCameraXform(conditionedXform);
+    }
+
+    if (mPicksPaused) {
+        vp->resumePicks();
+        mPicksPaused = false;
+    }
+}
+
+void
+RenderGui::beginStreamViewing(FrameStreamClient *client, const Mat4f& cameraXform, bool makeDefaultXform)
+{
+    mStreamClient = client;
+    RenderViewport *vp = mMainWindow->getRenderViewport();
     if (makeDefaultXform) {
-        vp->setDefaultCameraTransform(cameraXform);
+        vp->resetCameraTransform(cameraXform, true);
     }
 
-    // Update the camera.
-    computeCameraMotionXformOffset();
-    NavigationCam *cam = vp->getNavigationCam();
-    if (cam) {
-        Mat4f conditionedXform = cam->resetTransform(cameraXform, false);
-        if (!isEqual(mLastCameraXform, conditionedXform)) {
-            setCameraXform(conditionedXform);
-        }
+    // A render process we have reattached to may have restarted, so tell it
+    // everything.
+    mLastCameraXform = updateNavigationCam(util::getSeconds());
+    mStreamFastProgressive = vp->isFastProgressive();
+    mStreamFastMode = vp->getFastMode();
+    client->sendCamera(mLastCameraXform);
+    client->sendRenderMode(mStreamFastProgressive, mStreamFastMode);
+}
+
+void
+RenderGui::updateStreamViewing()
+{
+    const double currentTime = util::getSeconds();
+    RenderViewport *vp = mMainWindow->getRenderViewport();
+
+    updateBufferPool(currentTime);
+
+    const Mat4f cameraXform = updateNavigationCam(currentTime);
+    if (!isEqual(mLastCameraXform, cameraXform)) {
+        mStreamClient->sendCamera(cameraXform);
+        mLastCameraXform = cameraXform;
+        mLastCameraMoveTime = currentTime;
+    }
+
+    if (vp->isFastProgressive() != mStreamFastProgressive || vp->getFastMode() != mStreamFastMode) {
+        mStreamFastProgressive = vp->isFastProgressive();
+        mStreamFastMode = vp->getFastMode();
+        mStreamClient->sendRenderMode(mStreamFastProgressive, mStreamFastMode);
+    }
+
+    // Render outputs aren't streamed, so the beauty is all there is to show.
+    if (mStreamClient->update(&mRenderBuffer) || vp->getNeedsRefresh()) {
+        vp->setNeedsRefresh(false);
+        updateFrame(&mRenderBuffer, &mRenderOutputBuffer, false, true);
+        mBufferPool.measure();
     }
 }
 
 uint32_t
 RenderGui::updateInteractiveRendering()
 {
+    updateBufferPool(util::getSeconds());
+
+    uint32_t result = 0;
     switch (mRenderContext->getRenderMode())
     {
     case moonray::rndr::RenderMode::PROGRESSIVE:
     case moonray::rndr::RenderMode::PROGRESSIVE_FAST:
     case moonray::rndr::RenderMode::PROGRESS_CHECKPOINT:
     case moonray::rndr::RenderMode::BATCH:
-        return updateProgressiveRendering();
+        result = updateProgressiveRendering();
+        break;
 
     case moonray::rndr::RenderMode::REALTIME:
-        return updateRealTimeRendering();
+        result = updateRealTimeRendering();
+        break;
 
     default:
         MNRY_ASSERT(0);
     }
 
-    return 0;
+    // Buffers are sized while frames are displayed, so peaks are measured
+    // straight after rather than only when idle buffers are freed.
+    mBufferPool.measure();
+    return result;
 }
 
 Mat4f 
 RenderGui::endInteractiveRendering()
 {
+    // Picks refer to scene data which is about to change. They are held back
+    // until rendering begins again.
+    if (!mPicksPaused) {
+        mMainWindow->getRenderViewport()->pausePicks();
+        mPicksPaused = true;
+    }
+
     if (mRenderContext->isFrameRendering()) {
         mRenderContext->stopFrame();
     }
 
+    // Leave the scene at the resolution it was loaded with.
+    if (mFrameRateGovernor.getScale() != 1.f) {
+        mFrameRateGovernor.reset();
+        setResolutionScale(1.f);
+    }
+
+    // Pending snapshots refer to scene data which is about to change too.
+    mMainWindow->getRenderViewport()->waitForSnapshots();
+    mPickBuffer.clear();
+
     return updateNavigationCam(util::getSeconds());
 }
 
@@ -539,42 +1019,73 @@ RenderGui::updateProgressiveRendering()
 
     RenderViewport* renderVp = MNRY_VERIFY(mMainWindow->getRenderViewport());
 
+    // Throttle rendering to the specified frames per second.
+    float fps = mRenderContext->getSceneContext().getSceneVariables().get(rdl2::SceneVariables::sFpsKey);
+    if (fps < 0.000001f) {
+        fps = 24.0f;
+    }
+
     // This block of code won't get executed on the first iteration after
     // beginInteractiveRendering is called but will be for all subsequent 
     // iterations.
     if (mRenderContext->isFrameRendering() || mRenderContext->isFrameComplete()) {
 
-        // Throttle rendering to the specified frames per second.
-        float fps = mRenderContext->getSceneContext().getSceneVariables().get(rdl2::SceneVariables::sFpsKey);
-        if (fps < 0.000001f) {
-            fps = 24.0f;
-        }
+        // The contact sheet stands in for the frame at its own, slower rate.
+        const bool contactSheet = renderVp->getContactSheetEnabled() && renderVp->getDebugMode() != NUM_SAMPLES;
+        const double snapshotInterval = contactSheet ? CONTACT_SHEET_INTERVAL :
+                                                       (1.0 / fps) - 0.001f;   // 1 ms slop
 
         // Have we elapsed enough time to show another part of the frame?
-        const bool snapshotIntervalElapsed = (currentTime - mLastSnapshotTime) >= ((1.0 / fps) - 0.001f);   // 1 ms slop
+        const bool snapshotIntervalElapsed = (currentTime - mLastSnapshotTime) >= snapshotInterval;
 
         const unsigned filmActivity = mRenderContext->getFilmActivity();
         const bool renderSamplesPending = (filmActivity != mLastFilmActivity);
-        bool roChanged = updateRenderOutput();
+        const bool roChanged = updateRenderOutput();
 
         // In NORMAL view mode, we want to check if we have a complete frame.  In
         // SNOOP mode, we allow partial frames
         const bool readyForDisplay = mRenderContext->isFrameReadyForDisplay();
 
+        // Show the last snapshot of an output being switched to straight
+        // away. If samples have landed since it was taken it is refreshed at
+        // the next snapshot interval, like any other frame.
+        if (roChanged && readyForDisplay && !contactSheet && mRenderOutput >= 0 &&
+            renderVp->getDebugMode() != NUM_SAMPLES && !renderVp->getMultiPaneEnabled()) {
+            unsigned cachedFilmActivity;
+            const auto *cached = mRenderOutputCache.find(mRenderOutput, mRenderTimestamp, &cachedFilmActivity);
+            if (cached) {
+                mLastSnapshotTimestamp = mRenderTimestamp;
+                mLastSnapshotTime = currentTime;
+                mLastFilmActivity = cachedFilmActivity;
+
+                updateFrame(&mRenderBuffer, cached, false, false);
+
+                // Nothing to refresh if no samples have landed since.
+                if (cachedFilmActivity == filmActivity) {
+                    renderVp->setNeedsRefresh(false);
+                }
+                updated = true;
+            }
+        }
+
         // All these conditions must be met before we push another new frame up.
-        if (readyForDisplay && ((snapshotIntervalElapsed && renderSamplesPending) || roChanged)) {
+        if (!updated && readyForDisplay && ((snapshotIntervalElapsed && renderSamplesPending) || roChanged)) {
 
             mLastSnapshotTimestamp = mRenderTimestamp;
             mLastSnapshotTime = currentTime;
             mLastFilmActivity = filmActivity;
 
-            snapshotFrame(&mRenderBuffer, &mHeatMapBuffer, &mWeightBuffer, &mRenderBufferOdd,
-                          &mRenderOutputBuffer, true, false);
+            if (contactSheet) {
+                updateContactSheet(false);
+            } else {
+                const auto *outputBuffer = snapshotFrame(&mRenderBuffer, &mHeatMapBuffer, &mWeightBuffer,
+                                                         &mRenderBufferOdd, &mRenderOutputBuffer, true, false);
 
-            updateFrame(&mRenderBuffer, &mRenderOutputBuffer,
-                        !mRenderContext->isFrameComplete() &&
-                        renderVp->getShowTileProgress(),
-                        false);
+                updateFrame(&mRenderBuffer, outputBuffer,
+                            !mRenderContext->isFrameComplete() &&
+                            renderVp->getShowTileProgress(),
+                            false);
+            }
 
             updated = true;
         }
@@ -585,14 +1096,33 @@ RenderGui::updateProgressiveRendering()
     // has completed rendering. One current example is if you toggle the show
     // alpha mode after rendering has completed. Another is when the tile
     // overlays are fading out right after the frame completes.
+    // The same goes for a frame we denoised at reduced resolution while the
+    // camera was moving, once the camera has come to rest.
+    if (mReducedResDenoiseShown && (currentTime - mLastCameraMoveTime) >= MOTION_DENOISE_IDLE_TIME) {
+        renderVp->setNeedsRefresh(true);
+    }
+
     bool needsRefresh = renderVp->getNeedsRefresh();
     if (!updated && needsRefresh && mRenderContext->isFrameComplete()) {
-        snapshotFrame(&mRenderBuffer, &mHeatMapBuffer, &mWeightBuffer,
-                      &mRenderBufferOdd, &mRenderOutputBuffer, true, false);
-        updateFrame(&mRenderBuffer, &mRenderOutputBuffer, false, true);
+        // Set again below if the refreshed frame is still denoised at reduced
+        // resolution, otherwise this refresh is the last one it needs.
+        mReducedResDenoiseShown = false;
+        if (renderVp->getContactSheetEnabled() && renderVp->getDebugMode() != NUM_SAMPLES) {
+            updateContactSheet(true);
+        } else {
+            const auto *outputBuffer = snapshotFrame(&mRenderBuffer, &mHeatMapBuffer, &mWeightBuffer,
+                                                     &mRenderBufferOdd, &mRenderOutputBuffer, true, false);
+            updateFrame(&mRenderBuffer, outputBuffer, false, true);
+        }
         renderVp->setNeedsRefresh(false);
     }
 
+    // Probe values follow the cursor at the display rate.
+    updateProbe(currentTime, 1.0 / fps);
+
+    updatePickBuffer(currentTime);
+    updateConvergenceBenchmark(currentTime);
+
     // This check forces us to wait on the previous frame being displayed at least once
     // before triggering the next frame. If we didn't do this, we may never see
     // anything displayed, or motion may be jerky.
@@ -601,7 +1131,8 @@ RenderGui::updateProgressiveRendering()
         // Check if there have been any scene changes since the last render.
         Mat4f cameraXform = updateNavigationCam(currentTime);
         const bool cameraChanged = !math::isEqual(mLastCameraXform, cameraXform);
-        bool sceneChanged = cameraChanged || (mMasterTimestamp != mRenderTimestamp);
+        bool otherChanged = (mMasterTimestamp != mRenderTimestamp);
+        bool sceneChanged = cameraChanged || otherChanged;
 
         // Check if the progressive mode changed
         moonray::rndr::RenderMode currentMode = renderVp->isFastProgressive() ?
@@ -609,18 +1140,21 @@ RenderGui::updateProgressiveRendering()
             moonray::rndr::RenderMode::PROGRESSIVE;
         if (mRenderContext->getRenderMode() != currentMode) {
             mRenderContext->setRenderMode(currentMode);
-            sceneChanged = true;
+            sceneChanged = otherChanged = true;
         }
 
         // Check if the fast progressive mode changed
         moonray::rndr::FastRenderMode currentFastMode = renderVp->getFastMode();
         if (mRenderContext->getFastRenderMode() != currentFastMode) {
             mRenderContext->setFastRenderMode(currentFastMode);
-            sceneChanged = true;
+            sceneChanged = otherChanged = true;
         }   
 
         if (sceneChanged) {
 
+            // Picks cast rays into the scene we're about to change.
+            renderVp->pausePicks();
+
             // Stop the previous frame (if we were rendering one).
             if (mRenderContext->isFrameRendering()) {
                 mRenderContext->stopFrame();
@@ -629,6 +1163,12 @@ RenderGui::updateProgressiveRendering()
             mRenderTimestamp = ++mMasterTimestamp;
             mLastFilmActivity = 0;
 
+            // Only camera moves can be reprojected; anything else makes the
+            // previous frame wrong.
+            if (otherChanged) {
+                mReprojector.clearHistory();
+            }
+
             //
             // Here is the point in the frame where we've stopped all render threads
             // and it's safe to update the scene.
@@ -639,14 +1179,16 @@ RenderGui::updateProgressiveRendering()
 
             // Kick off a new frame with the updated camera/progressive mode
             mRenderContext->startFrame();
+            renderVp->resumePicks();
+            if (mConvergenceBenchmark) {
+                mConvergenceBenchmark->frameStarted(util::getSeconds());
+            }
 
             // Update the tile progress rendering state.
             mOkToRenderTiles = false;
             unsigned numTiles = unsigned(mRenderContext->getTiles()->size());
-            if (mFadeLevels[0].getNumBits() != numTiles) {
-                for (unsigned i = 0; i < NUM_TILE_FADE_STEPS; ++i) {
-                    mFadeLevels[i].init(numTiles);
-                }
+            if (mTilesRenderedTo.getNumBits() != numTiles) {
+                mTilesRenderedTo.init(numTiles);
             }
         }
     }
@@ -665,15 +1207,42 @@ RenderGui::updateRealTimeRendering()
     if (mRenderContext->isFrameRendering()) {
 
         if (mRenderContext->isFrameReadyForDisplay()) {
+            // Picks cast rays into the scene, which changes until the next
+            // frame is started.
+            mMainWindow->getRenderViewport()->pausePicks();
             mRenderContext->stopFrame();
 
             mRenderTimestamp = ++mMasterTimestamp;
 
+            // This frame was rendered at the governor's current scale.
+            mDisplayScale = mFrameRateGovernor.getScale();
+
             updateRenderOutput();
-            snapshotFrame(&mRenderBuffer, &mHeatMapBuffer, &mWeightBuffer, &mRenderBufferOdd,
-                          &mRenderOutputBuffer, true, true);
 
-            updateFrame(&mRenderBuffer, &mRenderOutputBuffer, false, true);
+            // The contact sheet stands in for the frame at its own, slower
+            // rate, and has to be taken before the next frame starts.
+            const RenderViewport *vp = mMainWindow->getRenderViewport();
+            const bool contactSheet = vp->getContactSheetEnabled() && vp->getDebugMode() != NUM_SAMPLES;
+            const scene_rdl2::fb_util::VariablePixelBuffer *outputBuffer = &mRenderOutputBuffer;
+            if (contactSheet) {
+                if (currentTime - mLastContactSheetTime >= CONTACT_SHEET_INTERVAL) {
+                    updateContactSheet(true);
+                }
+            } else {
+                outputBuffer = snapshotFrame(&mRenderBuffer, &mHeatMapBuffer, &mWeightBuffer, &mRenderBufferOdd,
+                                             &mRenderOutputBuffer, true, true);
+            }
+
+            // When pipelined, the next frame is started as soon as this one
+            // has been snapshotted and is displayed while it renders. The
+            // denoiser reads its albedo and normal inputs straight from the
+            // render context, so it has to run before the next frame starts.
+            const bool pipelined = vp->getPipelinedRealtime() &&
+                                   !(vp->getDenoisingEnabled() &&
+                                     vp->getDenoisingBufferMode() != DN_BUFFERS_BEAUTY);
+            if (!pipelined && !contactSheet) {
+                updateFrame(&mRenderBuffer, outputBuffer, false, true);
+            }
 
             // Here is the point in the frame where we've stopped all render
             // threads and it's safe to update the scene.
@@ -683,11 +1252,33 @@ RenderGui::updateRealTimeRendering()
             // Update realtime frame statistics.
             mRenderContext->commitCurrentRealtimeStats();
 
+            // Pick the resolution for the next frame from how long the
+            // frames so far took, display included.
+            if (mFrameRateGovernor.isEnabled()) {
+                const double frameEnd = util::getSeconds();
+                if (mLastRealtimeFrameEnd >= 0.0) {
+                    const float scale = mFrameRateGovernor.update(frameEnd - mLastRealtimeFrameEnd);
+                    if (scale != mDisplayScale) {
+                        setResolutionScale(scale);
+                    }
+                }
+                mLastRealtimeFrameEnd = frameEnd;
+            }
+
             // Update the camera.
             Mat4f cameraXform = updateNavigationCam(currentTime);
             setCameraXform(cameraXform);
 
             mRenderContext->startFrame();
+            mMainWindow->getRenderViewport()->resumePicks();
+
+            // Leave the render threads the rest of the machine.
+            if (pipelined && !contactSheet) {
+                updateFrame(&mRenderBuffer, outputBuffer, false, false);
+            }
+
+            // Probe values follow the cursor with each frame.
+            updateProbe(currentTime, 0.0);
         }
 
     } else {
@@ -698,12 +1289,14 @@ RenderGui::updateRealTimeRendering()
         Mat4f cameraXform = updateNavigationCam(currentTime);
 
         // Update the camera.
+        mMainWindow->getRenderViewport()->pausePicks();
         setCameraXform(cameraXform);
 
         mRenderTimestamp = ++mMasterTimestamp;
 
         // Kick off a new frame with the updated camera.
         mRenderContext->startFrame();
+        mMainWindow->getRenderViewport()->resumePicks();
     }
 
     return mRenderContext->isFrameRendering() ? mRenderTimestamp : 0;
@@ -740,72 +1333,36 @@ RenderGui::setCameraXform(const Mat4f& c2w)
     camera->endUpdate();
     mRenderContext->setSceneUpdated();
 
-    mLastCameraXform = c2w;
-}
+    // Every frame starts from scratch, so the pick buffer has to as well.
+    mPickBuffer.invalidate();
 
-Mat4f
-RenderGui::updateNavigationCam(double currentTime)
-{
-    NavigationCam *cam = mMainWindow->getRenderViewport()->getNavigationCam();
-    if (!cam) {
-        return Mat4f(math::one);
+    if (!isEqual(mLastCameraXform, c2w)) {
+        mLastCameraMoveTime = util::getSeconds();
     }
-
-    double dt = (mLastCameraUpdateTime < 0.0) ? 0.0 : (currentTime - mLastCameraUpdateTime);
-    mLastCameraUpdateTime = currentTime;
-
-    return cam->update(static_cast<float>(dt));
+    mLastCameraXform = c2w;
 }
 
 void
-RenderGui::drawTileOutlines(DisplayBuffer buf, const std::vector<scene_rdl2::fb_util::Tile> &tiles,
-                            float tileColor, int fadeLevelIdx)
-{
-    switch (buf) {
-    case DISPLAY_BUFFER_IS_DISPLAY_BUFFER:
-        {
-            const uint8_t byteColor = convertToByteColor(tileColor);
-            mFadeLevels[fadeLevelIdx].forEachBitSet([&](unsigned idx) {
-                MNRY_ASSERT(idx < tiles.size());
-                drawTileOutline(&mDisplayBuffer, tiles[idx], byteColor);
-            });
-        }
-        break;
-    case DISPLAY_BUFFER_IS_RENDER_BUFFER:
-        mFadeLevels[fadeLevelIdx].forEachBitSet([&](unsigned idx) {
-            MNRY_ASSERT(idx < tiles.size());
-            drawTileOutline(&mRenderBuffer, tiles[idx], tileColor);
-        });
-        break;
-    case DISPLAY_BUFFER_IS_RENDER_OUTPUT_BUFFER:
-        switch (mRenderOutputBuffer.getFormat()) {
-        case scene_rdl2::fb_util::VariablePixelBuffer::FLOAT3:
-            mFadeLevels[fadeLevelIdx].forEachBitSet([&](unsigned idx) {
-                MNRY_ASSERT(idx < tiles.size());
-                drawTileOutline(&mRenderOutputBuffer.getFloat3Buffer(), tiles[idx], tileColor);
-            });
-            break;
-        case scene_rdl2::fb_util::VariablePixelBuffer::FLOAT4:
-            mFadeLevels[fadeLevelIdx].forEachBitSet([&](unsigned idx) {
-                MNRY_ASSERT(idx < tiles.size());
-                drawTileOutline(&mRenderOutputBuffer.getFloat4Buffer(), tiles[idx], tileColor);
-            });
-            break;
-        default:
-            MNRY_ASSERT(0 && "tile progress in render output buffer unhandled");
-        }
-        break;
-    default:
-        MNRY_ASSERT(0 && "unknown display buffer");
-    }
+RenderGui::setResolutionScale(float scale)
+{
+    rdl2::SceneVariables &vars =
+        const_cast<rdl2::SceneVariables &>(mRenderContext->getSceneContext().getSceneVariables());
+    vars.beginUpdate();
+    vars.set(rdl2::SceneVariables::sResKey, mBaseRes * scale);
+    vars.endUpdate();
+    mRenderContext->setSceneUpdated();
 }
 
-void
-RenderGui::showTileProgress(DisplayBuffer buf)
+Mat4f
+RenderGui::updateNavigationCam(double currentTime)
 {
-    // Color of new tiles, additive on framebuffer.
-    static const float refTileColor = 0.2f;
+    // The camera itself is stepped on the Qt thread.
+    return mMainWindow->getRenderViewport()->getCameraTransform(currentTime);
+}
 
+std::shared_ptr<const TileProgress>
+RenderGui::updateTileProgress(unsigned width, unsigned height)
+{
     // Initial passes essentially try and render something to all tiles as fast
     // as possible so we have an image to extrapolate. This is problematic if
     // rendering diagnostic tiles on top since they cover the entire image
@@ -815,57 +1372,60 @@ RenderGui::showTileProgress(DisplayBuffer buf)
     // Here we set that threshold at 10%.
     static const float tileRatioThreshold = 0.1f;
 
-    // Render all the tiles which we are are currently submitting primary rays
-    // for over all threads.
-
+    // Find the tiles which we are are currently submitting primary rays for
+    // over all threads.
     const std::vector<scene_rdl2::fb_util::Tile> &tiles =
         *(mRenderContext->getTiles());
-    mRenderContext->getTilesRenderedTo(mFadeLevels[0]);
+    if (mTilesRenderedTo.getNumBits() != tiles.size()) {
+        mTilesRenderedTo.init(unsigned(tiles.size()));
+    }
+    mRenderContext->getTilesRenderedTo(mTilesRenderedTo);
 
     if (!mOkToRenderTiles) {
         auto totalTiles = tiles.size();
-        float ratio = float(double(mFadeLevels[0].getNumBitsSet()) / double(totalTiles));
+        float ratio = float(double(mTilesRenderedTo.getNumBitsSet()) / double(totalTiles));
 
         if (ratio < tileRatioThreshold) {
             mOkToRenderTiles = true;
         } else {
             // Early return.
-            return;
+            return nullptr;
         }
     }
 
-    // Render full bright tiles we've rendered this frame.
-    drawTileOutlines(buf, tiles, refTileColor, 0);
-
-    // Render the tiles for each different fade level.
-    for (unsigned i = 1; i < NUM_TILE_FADE_STEPS; ++i) {
-
-        // Ensure each bit is only set to on for a single list, with lower indexed
-        // lists getting priority over higher indexed lists.
-        mFadeLevels[i].combine(mFadeLevels[0], [](uint32_t &a, uint32_t b) {
-            a &= ~b;
-        });
-
-        // Compute fade amount.
-        float t = (1.f - (float(i) / float(NUM_TILE_FADE_STEPS))) * 0.6f;
-        const float fadeColor = refTileColor * t;
-
-        drawTileOutlines(buf, tiles, fadeColor, i);
+    // Only a timestamp per tile is kept, outlines are drawn and faded when
+    // the frame is displayed.
+    const unsigned tilesX = (width + TILE_PROGRESS_TILE_SIZE - 1) / TILE_PROGRESS_TILE_SIZE;
+    const unsigned tilesY = (height + TILE_PROGRESS_TILE_SIZE - 1) / TILE_PROGRESS_TILE_SIZE;
+    if (mTileTimes.size() != size_t(tilesX) * tilesY) {
+        mTileTimes.assign(size_t(tilesX) * tilesY, -std::numeric_limits<float>::max());
     }
 
-    // Do actual fade. (TODO: use std::move instead of the logic below)
-    // Note: mFadeLevels[0] is cleared next time around.
-    for (int i = NUM_TILE_FADE_STEPS - 1; i > 0; --i) {
-        mFadeLevels[i].combine(mFadeLevels[i - 1], [](uint32_t &a, uint32_t b) {
-            a = b;
-        });
-    }
+    const float now = float(util::getSeconds() - mTileEpoch);
+    mTilesRenderedTo.forEachBitSet([&](unsigned idx) {
+        MNRY_ASSERT(idx < tiles.size());
+        const unsigned tx = tiles[idx].mMinX / TILE_PROGRESS_TILE_SIZE;
+        const unsigned ty = tiles[idx].mMinY / TILE_PROGRESS_TILE_SIZE;
+        if (tx < tilesX && ty < tilesY) {
+            mTileTimes[ty * tilesX + tx] = now;
+        }
+    });
+
+    auto progress = std::make_shared<TileProgress>();
+    progress->mTilesX = tilesX;
+    progress->mTilesY = tilesY;
+    progress->mTileTimes = mTileTimes;
+    progress->mTime = now;
+    progress->mFadeTime = TILE_PROGRESS_FADE_TIME;
+    progress->mIntensity = TILE_PROGRESS_INTENSITY;
+    return progress;
 }
 
 bool
 RenderGui::updateRenderOutput()
 {
     bool updated = false;
+    bool switched = false;
     int guiIndx = mMainWindow->getRenderViewport()->getRenderOutputIndx();
     const auto *rod = mRenderContext->getRenderOutputDriver();
 
@@ -876,66 +1436,331 @@ RenderGui::updateRenderOutput()
     }
     const int numRenderOutputs = rod->getNumberOfRenderOutputs();
 
+    if (mLastTotalRenderOutputs != numRenderOutputs) {
+        // the scene changed - our render output indices are potentially out
+        // of range or invalid.  Names are only looked up here, everything
+        // else goes through the index.
+        std::vector<std::string> oldNames;
+        oldNames.swap(mRenderOutputNames);
+        mRenderOutputIndices.clear();
+        for (int i = 0; i < numRenderOutputs; ++i) {
+            mRenderOutputNames.push_back(rod->getRenderOutput(i)->getName());
+            mRenderOutputIndices[mRenderOutputNames.back()] = i;
+        }
+
+        // Returns the new index of the output which was at old index indx,
+        // or -1 if there isn't one.
+        auto remap = [&](int indx) {
+            if (indx < 0 || indx >= int(oldNames.size())) return -1;
+            auto it = mRenderOutputIndices.find(oldNames[indx]);
+            return it == mRenderOutputIndices.end() ? -1 : it->second;
+        };
+
+        // first try to match the render output name. If we didn't find
+        // it and we are out of range, put us at the last render output
+        // - this implies an update
+        const int oldRenderOutput = mRenderOutput;
+        const int newRenderOutput = remap(mRenderOutput);
+        if (newRenderOutput >= 0) {
+            mRenderOutput = newRenderOutput;
+        } else if (!(mRenderOutput < numRenderOutputs)) {
+            mRenderOutput = numRenderOutputs - 1;
+        }
+
+        // if we have some kind of change, but our index is
+        // in range, just flag this as an update
+        if (oldRenderOutput >= 0 && newRenderOutput < 0) {
+            switched = true;
+        }
+
+        std::vector<int> paneOutputs;
+        for (int indx : mPaneOutputs) {
+            const int newIndx = remap(indx);
+            if (newIndx >= 0) {
+                paneOutputs.push_back(newIndx);
+            }
+        }
+        mPaneOutputs.swap(paneOutputs);
+
+        mRenderOutputCache.clear();
+        mLastTotalRenderOutputs = numRenderOutputs;
+    }
+
     if (guiIndx != mLastRenderOutputGuiIndx) {
         if (guiIndx > mLastRenderOutputGuiIndx) {
             // find next active output
             if (mRenderOutput + 1 < numRenderOutputs) {
                 mRenderOutput++;
-                updated = true;
+                switched = true;
             }
         } else if (guiIndx < mLastRenderOutputGuiIndx) {
             // find previous active output
             if (mRenderOutput >= 0) {
                 mRenderOutput--;
-                updated = true;
+                switched = true;
                 // -1 means to use the render buffer
             }
         }
         mLastRenderOutputGuiIndx = guiIndx;
     }
 
-    if (mLastTotalRenderOutputs != numRenderOutputs) {
-        // the scene changed - our mRenderOutput index is potentially out
-        // of range or invalid.  first try to match the render output name
-        for (int i = 0; i < numRenderOutputs; ++i) {
-            if (mLastRenderOutputName == rod->getRenderOutput(i)->getName()) {
-                // found it, no update needed
-                mRenderOutput = i;
-                break;
+    // Add the output being viewed to the panes, or take it back out.
+    const int paneToggleCount = mMainWindow->getRenderViewport()->getPaneToggleCount();
+    if (paneToggleCount != mLastPaneToggleCount) {
+        mLastPaneToggleCount = paneToggleCount;
+        if (mRenderOutput >= 0) {
+            const std::string &outputName = mRenderOutputNames[mRenderOutput];
+            auto it = std::find(mPaneOutputs.begin(), mPaneOutputs.end(), mRenderOutput);
+            if (it == mPaneOutputs.end()) {
+                mPaneOutputs.push_back(mRenderOutput);
+                std::cerr << "added " << outputName << " to the panes\n";
+            } else {
+                mPaneOutputs.erase(it);
+                std::cerr << "removed " << outputName << " from the panes\n";
             }
-        }
-
-        // if we didn't find it and we are out of range, put
-        // us at the last render output - this implies an update
-        if (!(mRenderOutput < numRenderOutputs)) {
-            mRenderOutput = numRenderOutputs - 1;
-        }
-
-        // if we have some kind of change, but our index is
-        // in range, just flag this as an update
-        const std::string outputName = mRenderOutput > 0? rod->getRenderOutput(mRenderOutput)->getName() : "";
-        if (mLastRenderOutputName != outputName) {
             updated = true;
         }
-
-        mLastTotalRenderOutputs = numRenderOutputs;
     }
 
-    if (updated) {
+    if (switched) {
+        updated = true;
         if (mRenderOutput < 0) {
             std::cerr << "switch output to render buffer\n";
-            mLastRenderOutputName = "";
         } else {
-            const std::string outputName = rod->getRenderOutput(mRenderOutput)->getName();
             std::cerr << "switch output to "
-                      << outputName
+                      << mRenderOutputNames[mRenderOutput]
                       << '\n';
-            mLastRenderOutputName = outputName;
         }
     }
     return updated;
 }
 
+void
+RenderGui::updateBufferPool(double currentTime)
+{
+    if (currentTime - mLastBufferPoolTime < BUFFER_POOL_INTERVAL) return;
+    mLastBufferPoolTime = currentTime;
+
+    const size_t released = mBufferPool.update(currentTime);
+    if (released) {
+        std::cout << "Freed " << (released >> 20) << " MB of idle GUI buffers, "
+                  << (mBufferPool.getLiveTotal() >> 20) << " MB still in use" << std::endl;
+    }
+
+    if (!mMainWindow->getRenderViewport()->getMemoryStatsEnabled() ||
+        currentTime - mLastMemoryStatsTime < MEMORY_STATS_INTERVAL) return;
+    mLastMemoryStatsTime = currentTime;
+
+    // QApplication::postEvent handles deleting the raw pointer later, no risk of memory leak
+    QApplication::postEvent(mMainWindow, new MemoryStatsEvent(QString::fromStdString(mBufferPool.getReport())));
+}
+
+void
+RenderGui::updatePickBuffer(double currentTime)
+{
+    if (!mPickBufferEnabled || !mRenderContext->isFrameReadyForDisplay()) return;
+    if (currentTime - mLastPickBufferTime < PICK_BUFFER_INTERVAL) return;
+
+    // Nothing new to settle.
+    const unsigned filmActivity = mRenderContext->getFilmActivity();
+    if (mPickBufferTimestamp == mRenderTimestamp && mPickBufferFilmActivity == filmActivity) return;
+
+    mLastPickBufferTime = currentTime;
+    mBufferPool.touch(BUFFER_PICK, currentTime);
+    mPickBufferTimestamp = mRenderTimestamp;
+    mPickBufferFilmActivity = filmActivity;
+
+    // Positions come from depth, so like reprojection we need a depth output
+    // and a perspective camera.
+    const int depthIndx = getDepthRenderOutput();
+    CameraProjection projection;
+    if (depthIndx < 0 || !CameraProjection::fromCamera(mRenderContext->getCamera(), &projection)) return;
+
+    mRenderContext->snapshotRenderOutput(&mPickDepthBuffer, depthIndx,
+                                         &mRenderBuffer, &mHeatMapBuffer, &mWeightBuffer, &mRenderBufferOdd,
+                                         true, false);
+    if (mPickDepthBuffer.getFormat() != scene_rdl2::fb_util::VariablePixelBuffer::FLOAT) return;
+    mRenderContext->snapshotWeightBuffer(&mPickWeightBuffer, true, false);
+
+    // Returns the named ID output, or null if there is no such float output.
+    auto snapshotIds = [&](const std::string &name, scene_rdl2::fb_util::VariablePixelBuffer *buffer)
+        -> const scene_rdl2::fb_util::FloatBuffer * {
+        const auto it = mRenderOutputIndices.find(name);
+        if (name.empty() || it == mRenderOutputIndices.end()) return nullptr;
+        mRenderContext->snapshotRenderOutput(buffer, it->second,
+                                             &mRenderBuffer, &mHeatMapBuffer, &mWeightBuffer, &mRenderBufferOdd,
+                                             true, false);
+        if (buffer->getFormat() != scene_rdl2::fb_util::VariablePixelBuffer::FLOAT) return nullptr;
+        return &buffer->getFloatBuffer();
+    };
+
+    mPickBuffer.update(mPickDepthBuffer.getFloatBuffer(), mPickWeightBuffer,
+                       snapshotIds(mPickGeometryIdOutput, &mPickGeometryIdBuffer),
+                       snapshotIds(mPickMaterialIdOutput, &mPickMaterialIdBuffer),
+                       mLastCameraXform, projection);
+}
+
+void
+RenderGui::updateProbe(double currentTime, double interval)
+{
+    int x, y;
+    if (!mMainWindow->getRenderViewport()->getProbePosition(&x, &y)) return;
+
+    if (x == mLastProbeX && y == mLastProbeY && mDisplayUpdateCount == mLastProbeDisplayUpdate) return;
+    if (currentTime - mLastProbeTime < interval) return;
+
+    mLastProbeX = x;
+    mLastProbeY = y;
+    mLastProbeTime = currentTime;
+    mLastProbeDisplayUpdate = mDisplayUpdateCount;
+
+    QString text = QString("(%1, %2)").arg(x).arg(y);
+    if (x < 0 || y < 0 || unsigned(x) >= mRenderBuffer.getWidth() || unsigned(y) >= mRenderBuffer.getHeight()) {
+        QApplication::postEvent(mMainWindow, new ProbeEvent(text));
+        return;
+    }
+
+    // Everything here was snapshotted for display already, nothing is
+    // rendered or snapshotted for the probe itself.
+    const scene_rdl2::fb_util::RenderColor &beauty = mRenderBuffer.getPixel(x, y);
+    text += QString("\nbeauty: %1 %2 %3").arg(beauty.x, 0, 'g', 5).arg(beauty.y, 0, 'g', 5).arg(beauty.z, 0, 'g', 5);
+    text += QString("\nalpha: %1").arg(beauty.w, 0, 'g', 5);
+    if (unsigned(x) < mWeightBuffer.getWidth() && unsigned(y) < mWeightBuffer.getHeight()) {
+        text += QString("\nsamples: %1").arg(mWeightBuffer.getPixel(x, y), 0, 'g', 5);
+    }
+
+    mRenderOutputCache.forEach(mRenderTimestamp, [&](int indx, const scene_rdl2::fb_util::VariablePixelBuffer &buffer) {
+        if (indx < int(mRenderOutputNames.size())) {
+            text += "\n" + QString::fromStdString(mRenderOutputNames[indx]) + ": " + formatPixel(buffer, x, y);
+        }
+    });
+    const size_t numPanes = std::min(mPaneOutputs.size(), mPaneOutputBuffers.size());
+    for (size_t i = 0; i < numPanes; ++i) {
+        if (mPaneOutputs[i] < int(mRenderOutputNames.size())) {
+            text += "\n" + QString::fromStdString(mRenderOutputNames[mPaneOutputs[i]]) + ": " +
+                    formatPixel(mPaneOutputBuffers[i], x, y);
+        }
+    }
+
+    // QApplication::postEvent handles deleting the raw pointer later, no risk of memory leak
+    QApplication::postEvent(mMainWindow, new ProbeEvent(text));
+}
+
+void
+RenderGui::updateContactSheet(bool parallel)
+{
+    // Without render outputs the sheet is just the beauty, which still keeps
+    // the viewport updating.
+    const auto *rod = mRenderContext->getRenderOutputDriver();
+
+    mLastContactSheetTime = util::getSeconds();
+
+    // The frame's source buffers are snapshotted for the thumbnails too.
+    mBufferPool.touch(BUFFER_CONTACT_SHEET, mLastContactSheetTime);
+    mBufferPool.touch(BUFFER_FRAME, mLastContactSheetTime);
+
+    const RenderViewport *vp = mMainWindow->getRenderViewport();
+    const scene_rdl2::fb_util::PixelBufferUtilOptions options = parallel?
+            scene_rdl2::fb_util::PIXEL_BUFFER_UTIL_OPTIONS_PARALLEL :
+            scene_rdl2::fb_util::PIXEL_BUFFER_UTIL_OPTIONS_NONE;
+
+    // Every source buffer is snapshotted once and shared by all the outputs.
+    // Each output is then reduced to a thumbnail before any color transform,
+    // so that only runs on thumbnail sized buffers.
+    const int numRenderOutputs = rod ? rod->getNumberOfRenderOutputs() : 0;
+    bool heatMap = false;
+    bool weights = false;
+    bool renderBufferOdd = false;
+    for (int i = 0; i < numRenderOutputs; ++i) {
+        heatMap |= rod->requiresHeatMap(i);
+        weights |= rod->requiresWeightBuffer(i);
+        renderBufferOdd |= rod->requiresRenderBufferOdd(i);
+    }
+    mRenderContext->snapshotRenderBuffer(&mRenderBuffer, true, parallel);
+    if (heatMap) {
+        mRenderContext->snapshotHeatMapBuffer(&mHeatMapBuffer, true, parallel);
+    }
+    if (weights) {
+        mRenderContext->snapshotWeightBuffer(&mWeightBuffer, true, parallel);
+    }
+    if (renderBufferOdd) {
+        mRenderContext->snapshotRenderBufferOdd(&mRenderBufferOdd, true, parallel);
+    }
+
+    const unsigned factor = std::max(1u, mRenderBuffer.getWidth() / CONTACT_SHEET_THUMBNAIL_WIDTH);
+    downsampleBuffer(mRenderBuffer, factor, &mContactSheetBeauty, parallel);
+
+    std::vector<DisplayPane> thumbnails;
+    auto addThumbnail = [&](int renderOutput, const std::string &name) {
+        mColorManager.applyCRT(mMainWindow, vp->getUseOCIO(), renderOutput, mContactSheetBeauty,
+                               mContactSheetThumbnail, &mContactSheetDisplayBuffer, options, parallel);
+        const int width = int(mContactSheetDisplayBuffer.getWidth());
+        const int height = int(mContactSheetDisplayBuffer.getHeight());
+        QImage image(reinterpret_cast<const uchar*>(mContactSheetDisplayBuffer.getData()), width, height,
+                     width * 3, QImage::Format_RGB888);
+        thumbnails.push_back({image.mirrored(false, true), QString::fromStdString(name)});
+    };
+
+    addThumbnail(-1, "beauty");
+    for (int i = 0; i < numRenderOutputs; ++i) {
+        mRenderContext->snapshotRenderOutput(&mContactSheetOutputBuffer, i,
+                                             &mRenderBuffer, &mHeatMapBuffer, &mWeightBuffer, &mRenderBufferOdd,
+                                             true, parallel);
+        if (downsampleBuffer(mContactSheetOutputBuffer, factor, &mContactSheetThumbnail, parallel)) {
+            addThumbnail(i, rod->getRenderOutput(i)->getName());
+        }
+    }
+
+    // QApplication::postEvent handles deleting the raw pointer later, no risk of memory leak
+    QApplication::postEvent(mMainWindow, new ContactSheetEvent(std::move(thumbnails), ++mDisplayUpdateCount));
+}
+
+std::vector<DisplayPane>
+RenderGui::getDisplayPanes(const scene_rdl2::fb_util::RenderBuffer &renderBuffer,
+                           scene_rdl2::fb_util::PixelBufferUtilOptions options,
+                           bool parallel)
+{
+    std::vector<DisplayPane> panes;
+
+    const RenderViewport *vp = mMainWindow->getRenderViewport();
+    const auto *rod = mRenderContext ? mRenderContext->getRenderOutputDriver() : nullptr;
+    if (!vp->getMultiPaneEnabled() || vp->getDebugMode() == NUM_SAMPLES || !rod) {
+        return panes;
+    }
+
+    const float exposure = vp->getExposure();
+    const float gamma = vp->getGamma();
+    const DebugMode mode = vp->getDebugMode();
+    const bool useOCIO = vp->getUseOCIO();
+
+    const size_t numPanes = std::min({mPaneOutputs.size(), mPaneOutputBuffers.size(), mPaneCaches.size()});
+    for (size_t i = 0; i < numPanes; ++i) {
+        const scene_rdl2::fb_util::VariablePixelBuffer &buffer = mPaneOutputBuffers[i];
+        PaneCache &cache = mPaneCaches[i];
+        if (buffer.getWidth() == 0 || cache.mRenderOutput != mPaneOutputs[i]) continue;
+
+        if (cache.mImage.isNull() || cache.mExposure != exposure || cache.mGamma != gamma ||
+            cache.mMode != mode || cache.mUseOCIO != useOCIO) {
+            mColorManager.applyCRT(mMainWindow, useOCIO, cache.mRenderOutput, renderBuffer, buffer,
+                                   &mPaneDisplayBuffer, options, parallel);
+
+            // The display buffer is reused for the next pane, so the flip
+            // into Qt's row order is also the copy kept for later frames.
+            const int width = int(mPaneDisplayBuffer.getWidth());
+            const int height = int(mPaneDisplayBuffer.getHeight());
+            QImage image(reinterpret_cast<const uchar*>(mPaneDisplayBuffer.getData()), width, height,
+                         width * 3, QImage::Format_RGB888);
+            cache.mImage = image.mirrored(false, true);
+            cache.mExposure = exposure;
+            cache.mGamma = gamma;
+            cache.mMode = mode;
+            cache.mUseOCIO = useOCIO;
+        }
+        panes.push_back({cache.mImage, QString::fromStdString(mRenderOutputNames[cache.mRenderOutput])});
+    }
+    return panes;
+}
+
 bool
 RenderGui::isFastProgressive() const
 {
@@ -3,19 +3,34 @@
 
 #pragma once
 
+#include "BufferPool.h"
 #include "ColorManager.h"
+#include "ConvergenceBenchmark.h"
+#include "DenoiserCache.h"
+#include "FrameRateGovernor.h"
+#include "FrameSnapshot.h"
+#include "FrameStream.h"
+#include "FrameUpdateEvent.h"
 #include "GuiTypes.h"
+#include "PickBuffer.h"
+#include "RenderOutputCache.h"
+#include "Reprojector.h"
+#include "SharedFrameWriter.h"
+#include "TileProgress.h"
 
-#include <mcrt_denoise/denoiser/Denoiser.h>
 #include <moonray/rendering/rndr/rndr.h>
 
 #include <tbb/atomic.h>
 
-#define NUM_TILE_FADE_STEPS  4
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace moonray_gui {
 
 class Handler;
+class OutputWriter;
 
 /**
  * The RenderGui class handles spinning off a thread for Qt, as well as booting
@@ -30,17 +45,63 @@ public:
 
     void setContext(moonray::rndr::RenderContext *ctx) { mRenderContext = ctx; }
 
-    /// Submits a new frame to the GUI for display.
+    /// In realtime mode, lower the render resolution as needed to keep frames
+    /// close to this many seconds. 0 renders at full resolution regardless.
+    void setTargetFrameTime(double seconds) { mFrameRateGovernor.setTargetFrameTime(seconds); }
+
+    /// Frees the buffers of a feature, such as denoising or the contact
+    /// sheet, once it hasn't been used for this many seconds. 0 keeps them.
+    void setBufferIdleTime(double seconds) { mBufferPool.setIdleTime(seconds); }
+
+    /// The writer whose outputs must be written before a new frame is
+    /// started, and whose pooled snapshots are counted with, and freed like,
+    /// the GUI's own buffers, or null. Only called from the render thread.
+    void setOutputWriter(OutputWriter *outputWriter) { mOutputWriter = outputWriter; }
+
+    /// Keeps settled pixels of the depth output, and of the named geometry
+    /// and material ID outputs if not empty, for focus and inspector picks
+    /// to look up instead of casting rays.
+    void enablePickBuffer(const std::string &geometryIdOutput, const std::string &materialIdOutput);
+
+    /// Records the camera and viewport settings to path as the user changes
+    /// them, or replays a recording in place of the user. Return false if
+    /// path can't be used.
+    bool recordSession(const std::string &path);
+    bool replaySession(const std::string &path);
+
+    /// Renders the scene once for each ConvergenceBenchmark configuration,
+    /// for at most runDuration seconds each, measuring the displayed frames
+    /// against reference. Writes the results to outputPrefix and closes the
+    /// window when done. Returns false if the reference can't be read.
+    bool runConvergenceBenchmark(const std::string &reference, const std::string &outputPrefix,
+                                 double runDuration);
+
+    /// Publishes every frame to shared memory for other programs to read,
+    /// the linear frame to /moonray_gui_<name>.linear and the frame as
+    /// displayed to /moonray_gui_<name>.display. Returns false if they can't
+    /// be created.
+    bool enableFrameServer(const std::string &name);
+
+    /// Submits a new frame to the GUI for display. If renderBuffer points
+    /// into snapshot, the snapshot is kept alive until it has been displayed.
     void updateFrame(const scene_rdl2::fb_util::RenderBuffer *renderBuffer,
                      const scene_rdl2::fb_util::VariablePixelBuffer *renderOutputBuffer,
                      bool showTileProgress,
-                     bool parallel);
+                     bool parallel,
+                     std::shared_ptr<const FrameSnapshot> snapshot = nullptr);
+
+    /// Displays a completed frame from a snapshot which is also being
+    /// written out, rather than snapshotting the render context again.
+    void displaySnapshot(const std::shared_ptr<const FrameSnapshot> &snapshot, bool parallel);
 
     /// Snapshots the current output buffers based on the
-    /// user's mRenderOutput selection.
+    /// user's mRenderOutput selection, along with the pane
+    /// outputs in multi-pane mode.
     /// heatMapBuffer is a scratch buffer. Final results
-    /// will be in either renderBuffer or renderOutputBuffer
-    void snapshotFrame(scene_rdl2::fb_util::RenderBuffer *renderBuffer,
+    /// will be in either renderBuffer or the returned buffer,
+    /// which is renderOutputBuffer or the render output's
+    /// entry in the render output cache.
+    const scene_rdl2::fb_util::VariablePixelBuffer *snapshotFrame(scene_rdl2::fb_util::RenderBuffer *renderBuffer,
                        scene_rdl2::fb_util::HeatMapBuffer *heatMapBuffer,
                        scene_rdl2::fb_util::FloatBuffer *weightBuffer,
                        scene_rdl2::fb_util::RenderBuffer *renderBufferOdd,
@@ -61,6 +122,14 @@ public:
     uint32_t updateInteractiveRendering();
     scene_rdl2::math::Mat4f endInteractiveRendering();
 
+    /// Displays frames streamed from a separate render process instead of
+    /// rendering them, sending the process the navigation camera and render
+    /// mode as they change. cameraXform is where to start navigating from,
+    /// which becomes the default transform if makeDefaultXform is set.
+    void beginStreamViewing(FrameStreamClient *client, const scene_rdl2::math::Mat4f& cameraXform,
+                            bool makeDefaultXform);
+    void updateStreamViewing();
+
     /// Once we are within a beginInteractiveRendering/endInteractiveRendering,
     /// This function may be called from anywhere or any thread to discard the
     /// current interactive frame being rendered and to kick off another one.
@@ -83,19 +152,70 @@ private:
     void computeCameraMotionXformOffset();
     void setCameraXform(const scene_rdl2::math::Mat4f& cameraXform);
 
-    scene_rdl2::math::Mat4f updateNavigationCam(double currentTime);
+    /// Renders at the scene's resolution divided by scale from the next frame.
+    void setResolutionScale(float scale);
 
-    enum DisplayBuffer {
-        DISPLAY_BUFFER_IS_DISPLAY_BUFFER = 0,
-        DISPLAY_BUFFER_IS_RENDER_BUFFER,
-        DISPLAY_BUFFER_IS_RENDER_OUTPUT_BUFFER
-    };
+    DenoiserConfig getDenoiserConfig(unsigned w, unsigned h) const;
+
+    /// Returns the factor to downsample a w x h buffer by before denoising
+    /// it while the camera is moving.
+    static unsigned getMotionDenoiseFactor(unsigned w, unsigned h);
+
+    /// Denoises the beauty buffer, restricted to the user-selected region if
+    /// there is one. Returns the buffer to display, which is renderBuffer
+    /// itself if denoising isn't possible.
+    const scene_rdl2::fb_util::RenderBuffer *denoiseFrame(const scene_rdl2::fb_util::RenderBuffer *renderBuffer,
+                                                          bool parallel);
 
-    void drawTileOutlines(DisplayBuffer buf, const std::vector<scene_rdl2::fb_util::Tile> &tiles,
-                          float tileColor, int fadeLevelIdx);
-    void showTileProgress(DisplayBuffer buf);
+    /// Returns the index of the first depth render output, or -1.
+    int getDepthRenderOutput() const;
+
+    /// While a frame is still gathering its first samples after a camera
+    /// move, warps the previous frame into the new view and blends the new
+    /// samples over it. Returns the buffer to display.
+    const scene_rdl2::fb_util::RenderBuffer *reprojectFrame(const scene_rdl2::fb_util::RenderBuffer *renderBuffer,
+                                                            bool parallel);
+
+    scene_rdl2::math::Mat4f updateNavigationCam(double currentTime);
+
+    /// Records which tiles have been rendered to since the last call and
+    /// returns the outlines to draw over a width by height frame, or null if
+    /// none should be drawn yet.
+    std::shared_ptr<const TileProgress> updateTileProgress(unsigned width, unsigned height);
     bool updateRenderOutput();
 
+    /// Posts the values of the snapshotted buffers under the hover probe if
+    /// it has moved or the buffers have changed, at most once per interval.
+    void updateProbe(double currentTime, double interval);
+
+    /// Moves the convergence benchmark on to its next run once the current
+    /// one is finished, and closes the window after the last.
+    void updateConvergenceBenchmark(double currentTime);
+
+    /// Writes the linear frame being displayed, the beauty or a float render
+    /// output, to the frame server.
+    void publishLinearFrame(const scene_rdl2::fb_util::RenderBuffer &renderBuffer,
+                            const scene_rdl2::fb_util::VariablePixelBuffer &renderOutputBuffer,
+                            bool parallel);
+
+    /// Frees the buffers of features which have gone unused, and posts the
+    /// memory statistics to the viewport while its overlay is on.
+    void updateBufferPool(double currentTime);
+
+    /// Snapshots the pick buffer outputs if samples have landed since it was
+    /// last updated, at most once per PICK_BUFFER_INTERVAL.
+    void updatePickBuffer(double currentTime);
+
+    /// Snapshots the beauty and every render output, shrinks them to
+    /// thumbnails and posts them to the viewport's contact sheet.
+    void updateContactSheet(bool parallel);
+
+    /// Converts the pane render outputs snapshotted alongside the frame for
+    /// display. Returns nothing outside multi-pane mode.
+    std::vector<DisplayPane> getDisplayPanes(const scene_rdl2::fb_util::RenderBuffer &renderBuffer,
+                                             scene_rdl2::fb_util::PixelBufferUtilOptions options,
+                                             bool parallel);
+
     CameraType mInitialCameraType;
 
     MainWindow* mMainWindow;
@@ -105,6 +225,17 @@ private:
     scene_rdl2::fb_util::RenderBuffer        mDenoisedRenderBuffer;
     scene_rdl2::fb_util::RenderBuffer        mAlbedoBuffer;
     scene_rdl2::fb_util::RenderBuffer        mNormalBuffer;
+    scene_rdl2::fb_util::RenderBuffer        mDenoiserOutputBuffer;
+    scene_rdl2::fb_util::RenderBuffer        mRegionBeautyBuffer;
+    scene_rdl2::fb_util::RenderBuffer        mRegionAlbedoBuffer;
+    scene_rdl2::fb_util::RenderBuffer        mRegionNormalBuffer;
+    scene_rdl2::fb_util::RenderBuffer        mLowResBeautyBuffer;
+    scene_rdl2::fb_util::RenderBuffer        mLowResAlbedoBuffer;
+    scene_rdl2::fb_util::RenderBuffer        mLowResNormalBuffer;
+    scene_rdl2::fb_util::RenderBuffer        mUpsampledBuffer;
+    scene_rdl2::fb_util::RenderBuffer        mReprojectedRenderBuffer;
+    scene_rdl2::fb_util::VariablePixelBuffer mDepthOutputBuffer;
+    scene_rdl2::fb_util::FloatBuffer         mReprojectionWeightBuffer;
     scene_rdl2::fb_util::HeatMapBuffer       mHeatMapBuffer;
     scene_rdl2::fb_util::FloatBuffer         mWeightBuffer;
     scene_rdl2::fb_util::RenderBuffer        mRenderBufferOdd;
@@ -136,10 +267,6 @@ private:
     /// checked. Only touched on the main thread.
     unsigned                mLastFilmActivity;
 
-    /// This variable contains the absolute time of the most recent call to
-    /// NavigationCam::update.
-    double                  mLastCameraUpdateTime;
-
     /// The most recent camera transform. Stored to avoid kicking off new frame
     /// if the camera hasn't moved.
     scene_rdl2::math::Mat4f      mLastCameraXform;
@@ -159,17 +286,121 @@ private:
     /// value stores a RenderOutput indx for the RenderOutputDriver
     int                     mRenderOutput;
     int                     mLastTotalRenderOutputs;
-    std::string             mLastRenderOutputName;
+
+    /// Names of the render outputs by index and the reverse, rebuilt when the
+    /// outputs change so indices can be carried over by name.
+    std::vector<std::string> mRenderOutputNames;
+    std::unordered_map<std::string, int> mRenderOutputIndices;
+
+    /// Last snapshot of recently viewed render outputs.
+    RenderOutputCache       mRenderOutputCache;
+
+    /// Render outputs shown next to the main one in multi-pane mode, and the
+    /// buffers they are snapshotted into in the same pass as it.
+    std::vector<int>        mPaneOutputs;
+    std::vector<scene_rdl2::fb_util::VariablePixelBuffer> mPaneOutputBuffers;
+    scene_rdl2::fb_util::Rgb888Buffer mPaneDisplayBuffer;
+
+    /// What each pane's buffer was snapshotted at and how it was last shown.
+    /// The snapshot is reused until its output is rendered to again, and the
+    /// image until then or until the display settings change.
+    struct PaneCache
+    {
+        int mRenderOutput = -1;
+        uint32_t mTimestamp = 0;
+        unsigned mFilmActivity = 0;
+        QImage mImage;
+        float mExposure = 0.f;
+        float mGamma = 0.f;
+        DebugMode mMode = RGB;
+        bool mUseOCIO = false;
+    };
+    std::vector<PaneCache>  mPaneCaches;
+    int                     mLastPaneToggleCount;
+
+    /// Contact sheet scratch buffers, and when it was last updated. It is
+    /// refreshed less often than the frame since it converts every output.
+    scene_rdl2::fb_util::VariablePixelBuffer mContactSheetOutputBuffer;
+    scene_rdl2::fb_util::VariablePixelBuffer mContactSheetThumbnail;
+    scene_rdl2::fb_util::RenderBuffer        mContactSheetBeauty;
+    scene_rdl2::fb_util::Rgb888Buffer        mContactSheetDisplayBuffer;
+    double                  mLastContactSheetTime;
+
+    /// Hover probe: where it last read values, and the number of frames
+    /// displayed so it can tell when the buffers under it have changed.
+    int                     mLastProbeX;
+    int                     mLastProbeY;
+    double                  mLastProbeTime;
+    unsigned                mDisplayUpdateCount;
+    unsigned                mLastProbeDisplayUpdate;
+
+    /// Pick buffer, the outputs it reads IDs from and its scratch buffers.
+    bool                    mPickBufferEnabled;
+    std::string             mPickGeometryIdOutput;
+    std::string             mPickMaterialIdOutput;
+    PickBuffer              mPickBuffer;
+    scene_rdl2::fb_util::VariablePixelBuffer mPickDepthBuffer;
+    scene_rdl2::fb_util::VariablePixelBuffer mPickGeometryIdBuffer;
+    scene_rdl2::fb_util::VariablePixelBuffer mPickMaterialIdBuffer;
+    scene_rdl2::fb_util::FloatBuffer         mPickWeightBuffer;
+    uint32_t                mPickBufferTimestamp;
+    unsigned                mPickBufferFilmActivity;
+    double                  mLastPickBufferTime;
+
+    std::unique_ptr<ConvergenceBenchmark> mConvergenceBenchmark;
+
+    SharedFrameWriter       mLinearFrameWriter;
+
+    /// Render process frames are streamed from, and the render mode last
+    /// sent to it.
+    FrameStreamClient      *mStreamClient;
+    bool                    mStreamFastProgressive;
+    moonray::rndr::FastRenderMode mStreamFastMode;
+
+    /// Every scratch buffer above by the feature it serves, along with the
+    /// render output cache, snapshot history and output writer pool.
+    BufferPool              mBufferPool;
+    OutputWriter           *mOutputWriter;
+    double                  mLastBufferPoolTime;
+    double                  mLastMemoryStatsTime;
+
+    /// Set between endInteractiveRendering and beginInteractiveRendering,
+    /// while picks are held back for the scene to change.
+    bool                    mPicksPaused;
 
     /// Small class for handling interactions between Qt Widgets and the Render GUI
     Handler*                mHandler;
 
     /// Tile progress:
     bool                    mOkToRenderTiles;
-    util::BitArray          mFadeLevels[NUM_TILE_FADE_STEPS];
-
-    /// Denoiser
-    std::unique_ptr<moonray::denoiser::Denoiser> mDenoiser;
+    util::BitArray          mTilesRenderedTo;
+    std::vector<float>      mTileTimes; // seconds since mTileEpoch each tile was last rendered to
+    double                  mTileEpoch;
+
+    /// Denoiser instances, created in the background
+    DenoiserCache           mDenoiserCache;
+
+    /// Frame size seen by the last updateFrame call, used to warm up the
+    /// denoiser when the resolution changes.
+    unsigned                mLastFrameWidth;
+    unsigned                mLastFrameHeight;
+
+    /// Absolute time the camera transform last changed. Denoising drops to a
+    /// reduced resolution until the camera has been still for a short while.
+    double                  mLastCameraMoveTime;
+
+    /// True if the frame on screen was denoised at reduced resolution.
+    bool                    mReducedResDenoiseShown;
+
+    /// Previous frame and depth, warped into the new view after camera moves
+    Reprojector             mReprojector;
+
+    /// Realtime resolution control. mBaseRes is the scene's own resolution
+    /// divisor, mDisplayScale the enlargement for frames being displayed.
+    FrameRateGovernor       mFrameRateGovernor;
+    float                   mBaseRes;
+    double                  mLastRealtimeFrameEnd;
+    float                   mDisplayScale;
 
     /// Color Manager
     ColorManager mColorManager;
@@ -0,0 +1,83 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+/// @file RenderOutputCache.cc
+
+#include "RenderOutputCache.h"
+#include "BufferPool.h"
+
+namespace moonray_gui {
+
+using scene_rdl2::fb_util::VariablePixelBuffer;
+
+RenderOutputCache::RenderOutputCache(size_t budgetBytes) :
+    mBudgetBytes(budgetBytes),
+    mUsedBytes(0),
+    mUseCount(0)
+{
+}
+
+VariablePixelBuffer *
+RenderOutputCache::acquire(int indx)
+{
+    std::unique_ptr<Entry> &entry = mEntries[indx];
+    if (!entry) {
+        entry.reset(new Entry);
+    }
+    // Its contents are about to change.
+    entry->mValid = false;
+    entry->mLastUsed = ++mUseCount;
+    return &entry->mBuffer;
+}
+
+void
+RenderOutputCache::tag(int indx, uint32_t frame, unsigned filmActivity)
+{
+    auto it = mEntries.find(indx);
+    if (it == mEntries.end()) return;
+
+    Entry &entry = *it->second;
+    mUsedBytes -= entry.mSize;
+    entry.mSize = getBufferSize(entry.mBuffer);
+    mUsedBytes += entry.mSize;
+    entry.mFrame = frame;
+    entry.mFilmActivity = filmActivity;
+    entry.mValid = true;
+
+    evict(indx);
+}
+
+const VariablePixelBuffer *
+RenderOutputCache::find(int indx, uint32_t frame, unsigned *filmActivity)
+{
+    auto it = mEntries.find(indx);
+    if (it == mEntries.end() || !it->second->mValid || it->second->mFrame != frame) {
+        return nullptr;
+    }
+    it->second->mLastUsed = ++mUseCount;
+    *filmActivity = it->second->mFilmActivity;
+    return &it->second->mBuffer;
+}
+
+void
+RenderOutputCache::evict(int keep)
+{
+    while (mUsedBytes > mBudgetBytes) {
+        auto oldest = mEntries.end();
+        for (auto it = mEntries.begin(); it != mEntries.end(); ++it) {
+            if (it->first != keep && (oldest == mEntries.end() ||
+                                      it->second->mLastUsed < oldest->second->mLastUsed)) {
+                oldest = it;
+            }
+        }
+        if (oldest == mEntries.end()) {
+            // The output being shown is over budget on its own.
+            return;
+        }
+        mUsedBytes -= oldest->second->mSize;
+        mEntries.erase(oldest);
+    }
+}
+
+} // namespace moonray_gui
+
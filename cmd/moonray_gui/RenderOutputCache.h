@@ -0,0 +1,76 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+/// @file RenderOutputCache.h
+
+#pragma once
+
+#include <scene_rdl2/common/fb_util/VariablePixelBuffer.h>
+
+#include <cstdint>
+#include <map>
+#include <memory>
+
+namespace moonray_gui {
+
+/**
+ * The last snapshot of each recently viewed render output, so that switching
+ * back to one can show it straight away instead of waiting on a fresh
+ * snapshot. Each is tagged with the frame and film activity it was taken at.
+ * The least recently used outputs are dropped whenever the total size goes
+ * over budget. Only used from the render thread.
+ */
+class RenderOutputCache
+{
+public:
+    explicit RenderOutputCache(size_t budgetBytes);
+
+    /// Returns the buffer to snapshot render output indx into. The buffer
+    /// stays valid until clear() is called or another output is tagged.
+    scene_rdl2::fb_util::VariablePixelBuffer *acquire(int indx);
+
+    /// Records that the buffer acquired for indx now holds the given frame
+    /// at the given film activity, and drops other outputs if over budget.
+    void tag(int indx, uint32_t frame, unsigned filmActivity);
+
+    /// Returns the snapshot of indx if there is one of the given frame, along
+    /// with the film activity it was taken at, otherwise null.
+    const scene_rdl2::fb_util::VariablePixelBuffer *find(int indx, uint32_t frame, unsigned *filmActivity);
+
+    /// Calls func(indx, buffer) for each output with a snapshot of the given frame.
+    template <typename Func> void
+    forEach(uint32_t frame, const Func &func) const
+    {
+        for (const auto &entry : mEntries) {
+            if (entry.second->mValid && entry.second->mFrame == frame) {
+                func(entry.first, entry.second->mBuffer);
+            }
+        }
+    }
+
+    /// Drops everything, for when render output indices change meaning.
+    void clear() { mEntries.clear(); mUsedBytes = 0; }
+
+    size_t getMemoryUsage() const { return mUsedBytes; }
+
+private:
+    struct Entry
+    {
+        scene_rdl2::fb_util::VariablePixelBuffer mBuffer;
+        size_t mSize = 0;
+        uint32_t mFrame = 0;
+        unsigned mFilmActivity = 0;
+        bool mValid = false;
+        uint64_t mLastUsed = 0;
+    };
+
+    void evict(int keep);
+
+    size_t mBudgetBytes;
+    size_t mUsedBytes;
+    uint64_t mUseCount;
+    std::map<int, std::unique_ptr<Entry>> mEntries;
+};
+
+} // namespace moonray_gui
+
@@ -8,9 +8,6 @@
 
 #include <scene_rdl2/common/platform/Platform.h>
 #include <scene_rdl2/render/logging/logging.h>
-#include <scene_rdl2/scene/rdl2/Geometry.h>
-#include <scene_rdl2/scene/rdl2/Light.h>
-#include <scene_rdl2/scene/rdl2/Material.h>
 
 #include <sys/param.h>
 #include <sys/stat.h>
@@ -19,9 +16,14 @@
 #include <QtGui>
 #include <QInputDialog>
 #include <QLabel>
+#include <QPainter>
+#include <QRubberBand>
+#include <QThread>
+#include <QTimer>
 #include <QVBoxLayout>
 
 #include <algorithm>
+#include <cmath>
 #include <ctime>
 #include <iomanip>
 #include <sstream>
@@ -29,6 +31,12 @@
 using namespace moonray;
 using namespace scene_rdl2::logging;
 
+// Memory the snapshot history may use before the oldest frames are dropped.
+#define SNAPSHOT_HISTORY_BUDGET_MB      1024
+
+// Milliseconds between navigation camera integration steps.
+#define CAMERA_INTEGRATION_INTERVAL_MS  8
+
 namespace moonray_gui {
 
 namespace {
@@ -45,6 +53,65 @@ prevFastMode(moonray::rndr::FastRenderMode const &mode) {
     return static_cast<moonray::rndr::FastRenderMode>((static_cast<int>(mode) + numModes - 1) % numModes);
 }
 
+// Adds tile progress outlines to an 8 bit display image. The image is flipped
+// relative to the render buffer the tiles refer to.
+void
+drawTileProgress(QImage *image, const TileProgress &progress)
+{
+    const int width = image->width();
+    const int height = image->height();
+
+    QPainter painter(image);
+    painter.setCompositionMode(QPainter::CompositionMode_Plus);
+    for (unsigned ty = 0; ty < progress.mTilesY; ++ty) {
+        for (unsigned tx = 0; tx < progress.mTilesX; ++tx) {
+            const float outline = progress.getOutline(tx, ty);
+            if (outline <= 0.f) continue;
+
+            const int level = int(std::min(outline, 1.f) * 255.f);
+            painter.setPen(QColor(level, level, level));
+
+            const int x0 = int(tx) * TILE_PROGRESS_TILE_SIZE;
+            const int y0 = int(ty) * TILE_PROGRESS_TILE_SIZE;
+            const int x1 = std::min(x0 + TILE_PROGRESS_TILE_SIZE, width) - 1;
+            const int y1 = std::min(y0 + TILE_PROGRESS_TILE_SIZE, height) - 1;
+            painter.drawRect(QRect(x0, height - 1 - y1, x1 - x0, y1 - y0));
+        }
+    }
+}
+
+// Arranges images in a grid of the given size, each scaled to fit its cell
+// and labelled with its name.
+QImage
+composeGrid(const std::vector<DisplayPane> &panes, const QSize &size)
+{
+    const int count = int(panes.size());
+    const int cols = int(std::ceil(std::sqrt(double(count))));
+    const int rows = (count + cols - 1) / cols;
+    const int cellWidth = size.width() / cols;
+    const int cellHeight = size.height() / rows;
+
+    QImage composite(size, QImage::Format_RGB32);
+    composite.fill(Qt::black);
+
+    QPainter painter(&composite);
+    painter.setRenderHint(QPainter::SmoothPixmapTransform);
+    for (int i = 0; i < count; ++i) {
+        const QRect cell((i % cols) * cellWidth, (i / cols) * cellHeight, cellWidth, cellHeight);
+
+        QSize imageSize = panes[i].mImage.size();
+        imageSize.scale(cell.size(), Qt::KeepAspectRatio);
+        const QRect target(cell.x() + (cell.width() - imageSize.width()) / 2,
+                           cell.y() + (cell.height() - imageSize.height()) / 2,
+                           imageSize.width(), imageSize.height());
+        painter.drawImage(target, panes[i].mImage);
+
+        painter.setPen(Qt::white);
+        painter.drawText(target.adjusted(4, 2, -4, -2), Qt::AlignLeft | Qt::AlignTop, panes[i].mLabel);
+    }
+    return composite;
+}
+
 }
 
 // Moonray GUI Controls:
@@ -60,9 +127,11 @@ E: speed up
 R: reset to original world-location
 U: upright camera
 T: print current camera matrix
-I: cycle through pixel inspector modes
+I: cycle through pixel inspector modes, then hover or click to inspect
+Shift + I: toggle showing the snapshotted buffer values under the cursor
 O: toggle between orbitcam and freecam
 P: toggle show tiled progress
+Shift + P: toggle showing the memory used by GUI buffers
 `: toggle RGB
 1: toggle red
 2: toggle green
@@ -72,8 +141,17 @@ P: toggle show tiled progress
 7: toggle normalized RGB mode
 ,: move to previous render output
 .: move to next render output
+V: toggle showing the selected render outputs next to the current one
+Shift + V: add the current render output to the panes, or remove it
+G: toggle a contact sheet of every render output
 K: Take snapshot
+Shift + K: Take snapshot along with a PNG of the display
+M: store the current frame in the snapshot history
+Shift + M: step back through the snapshot history
+Alt + M: compare with the history frame: off / toggle / wipe
+Shift + RMB drag: move the wipe
 L: Toogle fast progressive mode
+Shift + L: toggle displaying realtime frames while the next one renders
 Alt + Up/Down: Switch between fast render modes
 X hold + LMB drag: start exposure update
 Y hold + LMB drag: start gamma update
@@ -87,6 +165,9 @@ N: deNoising on/off
 Shift + N: deNoising mode: Optix / Open Image Denoise
 B: toggle Buffers to use for denoising
 Z: toggle OCIO support on/off
+Shift + LMB drag: restrict denoising to a region
+Shift + LMB tap: denoise the full frame again
+J: toggle reprojecting the previous frame after camera moves (needs a depth output)
 
 Free Cam:
 LMB drag: rotate around camera position
@@ -103,15 +184,29 @@ F: refocus on point under mouse cursor)";
 RenderViewport::RenderViewport(QWidget* parent, CameraType intialType, const char *crtOverride, const std::string& snapPath) :
     QWidget(parent),
     mImageLabel(nullptr),
+    mPickOverlay(nullptr),
+    mProbeOverlay(nullptr),
+    mMemoryStatsOverlay(nullptr),
     mGlslBuffer(nullptr),
     mWidth(-1),
     mHeight(-1),
     mActiveCameraType(intialType),
+    mCameraTimer(nullptr),
+    mLastCameraIntegrationTime(-1.0),
+    mLastIntegratedXform(scene_rdl2::math::one),
+    mCameraMovePending(false),
+    mSessionStartTime(-1.0),
+    mHasReplayXform(false),
+    mReplayFrames(0),
+    mDisplayFrameNumber(0),
     mShowTileProgress(true),
     mApplyColorRenderTransform(false),
     mDenoise(false),
     mDenoiserMode(moonray::denoiser::OPTIX),
     mDenoisingBufferMode(DN_BUFFERS_BEAUTY),
+    mSelectingDenoiseRegion(false),
+    mDenoiseRegionBand(nullptr),
+    mReproject(false),
     mDebugMode(RGB),
     mRenderOutputIndx(0),
     mNeedsRefresh(true),
@@ -124,9 +219,24 @@ RenderViewport::RenderViewport(QWidget* parent, CameraType intialType, const cha
     mMouseTime(0),
     mSnapIdx(1),
     mSnapshotPath(snapPath),
+    mSnapshotWriter(new SnapshotWriter(parent)),
+    mPickWorker(new PickWorker(parent)),
+    mMultiPane(false),
+    mPaneToggleCount(0),
+    mContactSheet(false),
+    mHistory(new SnapshotHistory(size_t(SNAPSHOT_HISTORY_BUDGET_MB) << 20)),
+    mHistoryIndex(0),
+    mCompareMode(COMPARE_OFF),
+    mWipePosition(0.5f),
+    mDraggingWipe(false),
     mInspectorMode(INSPECT_NONE),
+    mProbe(false),
+    mProbePosition(0),
+    mMemoryStats(false),
     mRenderContext(nullptr),
     mProgressiveFast(false),
+    mPipelinedRealtime(true),
+    mDisplayScale(1.f),
     mFastMode(moonray::rndr::FastRenderMode::NORMALS),
     mUseOCIO(true),
     mLutOverride(nullptr)
@@ -169,6 +279,13 @@ RenderViewport::RenderViewport(QWidget* parent, CameraType intialType, const cha
     setupUi();
     setFocusPolicy(Qt::StrongFocus);
 
+    // Camera motion runs at its own steady rate rather than whenever the
+    // render thread happens to poll, and stops while the camera is at rest.
+    mCameraTimer = new QTimer(this);
+    mCameraTimer->setTimerType(Qt::PreciseTimer);
+    connect(mCameraTimer, SIGNAL(timeout()), this, SLOT(integrateCamera()));
+    mCameraTimer->start(CAMERA_INTEGRATION_INTERVAL_MS);
+
     struct stat buffer;
     // check snapshot path validity
     if (stat(mSnapshotPath.c_str(), &buffer) != 0) {
@@ -213,6 +330,34 @@ RenderViewport::setupUi()
 
     setLayout(layout);
 
+    mDenoiseRegionBand = new QRubberBand(QRubberBand::Rectangle, this);
+    mDenoiseRegionBand->hide();
+
+    // Pixel inspector results, shown next to the cursor
+    mPickOverlay = new QLabel(this);
+    mPickOverlay->setStyleSheet(QString::fromStdString("QLabel { padding : 5; background-color : ") +
+                                QString::fromStdString("rgba(0.0, 0.0, 0.0, 0.5); color : ") +
+                                QString::fromStdString("rgba(255.0, 255.0, 255.0, 1.0); }"));
+    mPickOverlay->setAttribute(Qt::WA_TransparentForMouseEvents);
+    mPickOverlay->hide();
+
+    // Hover probe values, shown above the cursor
+    mProbeOverlay = new QLabel(this);
+    mProbeOverlay->setStyleSheet(QString::fromStdString("QLabel { padding : 5; font-family : monospace; ") +
+                                 QString::fromStdString("background-color : rgba(0.0, 0.0, 0.0, 0.5); ") +
+                                 QString::fromStdString("color : rgba(255.0, 255.0, 255.0, 1.0); }"));
+    mProbeOverlay->setAttribute(Qt::WA_TransparentForMouseEvents);
+    mProbeOverlay->hide();
+
+    // GUI memory statistics, shown in the top right corner
+    mMemoryStatsOverlay = new QLabel(this);
+    mMemoryStatsOverlay->setStyleSheet(QString::fromStdString("QLabel { margin : 10; padding : 5; ") +
+                                       QString::fromStdString("font-family : monospace; ") +
+                                       QString::fromStdString("background-color : rgba(0.0, 0.0, 0.0, 0.5); ") +
+                                       QString::fromStdString("color : rgba(255.0, 255.0, 255.0, 1.0); }"));
+    mMemoryStatsOverlay->setAttribute(Qt::WA_TransparentForMouseEvents);
+    mMemoryStatsOverlay->hide();
+
     mWidth = -1;
     mHeight = -1;
 }
@@ -225,13 +370,196 @@ RenderViewport::setCameraRenderContext(const moonray::rndr::RenderContext &conte
 
     // save it, we'll use it for picking
     mRenderContext = &context;
+    mPickWorker->setRenderContext(&context);
+}
+
+void
+RenderViewport::setPickBuffer(PickBuffer *pickBuffer)
+{
+    mOrbitCam.setPickBuffer(pickBuffer);
+    mFreeCam.setPickBuffer(pickBuffer);
+    mPickWorker->setPickBuffer(pickBuffer);
+}
+
+scene_rdl2::math::Mat4f
+RenderViewport::resetCameraTransform(const scene_rdl2::math::Mat4f &xform, bool makeDefault)
+{
+    // The Qt thread steps the cameras, so they are only reset there.
+    if (QThread::currentThread() != thread()) {
+        scene_rdl2::math::Mat4f result;
+        QMetaObject::invokeMethod(this, [&] { result = resetCameraTransform(xform, makeDefault); },
+                                  Qt::BlockingQueuedConnection);
+        return result;
+    }
+
+    if (makeDefault) {
+        mOrbitCam.resetTransform(xform, true);
+        mFreeCam.resetTransform(xform, true);
+    }
+    const scene_rdl2::math::Mat4f conditionedXform = getNavigationCam()->resetTransform(xform, false);
+    mCameraPublisher.reset(conditionedXform, util::getSeconds());
+    wakeCamera();
+    return conditionedXform;
+}
+
+void
+RenderViewport::integrateCamera()
+{
+    flushCameraMove();
+
+    const double time = util::getSeconds();
+    const double dt = mLastCameraIntegrationTime < 0.0 ? 0.0 : time - mLastCameraIntegrationTime;
+    mLastCameraIntegrationTime = time;
+
+    scene_rdl2::math::Mat4f xform = getNavigationCam()->update(float(dt));
+
+    // Sessions are timed from the first step after the renderer hands us its
+    // context, so recordings and replays line up with the start of rendering.
+    if ((mSessionRecorder || mSessionPlayer) && mRenderContext) {
+        if (mSessionStartTime < 0.0) {
+            mSessionStartTime = time;
+        }
+        if (mSessionPlayer) {
+            xform = advanceReplay(time - mSessionStartTime, xform);
+        } else {
+            mSessionRecorder->record(time - mSessionStartTime, xform, getSessionSettings());
+        }
+    }
+
+    mCameraPublisher.publish(xform, time);
+
+    // Only input moves the camera once it has settled, so stop stepping it
+    // until there is some. Sessions are stepped throughout.
+    if (dt > 0.0 && !mSessionRecorder && !mSessionPlayer &&
+        scene_rdl2::math::isEqual(xform, mLastIntegratedXform)) {
+        mCameraTimer->stop();
+        mLastCameraIntegrationTime = -1.0;
+    }
+    mLastIntegratedXform = xform;
+}
+
+void
+RenderViewport::wakeCamera()
+{
+    if (!mCameraTimer->isActive()) {
+        mCameraTimer->start(CAMERA_INTEGRATION_INTERVAL_MS);
+    }
+}
+
+bool
+RenderViewport::recordSession(const std::string &path)
+{
+    std::unique_ptr<SessionRecorder> recorder(new SessionRecorder);
+    if (!recorder->open(path)) return false;
+    mSessionRecorder = std::move(recorder);
+    wakeCamera();
+    return true;
+}
+
+bool
+RenderViewport::publishDisplayFrames(const std::string &shmName)
+{
+    return mDisplayFrameWriter.open(shmName);
+}
+
+bool
+RenderViewport::replaySession(const std::string &path)
+{
+    std::unique_ptr<SessionPlayer> player(new SessionPlayer);
+    if (!player->load(path)) return false;
+    mSessionPlayer = std::move(player);
+    wakeCamera();
+    return true;
+}
+
+scene_rdl2::math::Mat4f
+RenderViewport::advanceReplay(double time, const scene_rdl2::math::Mat4f &xform)
+{
+    bool xformChanged;
+    bool settingsChanged;
+    SessionSettings settings;
+    mSessionPlayer->update(time, &mReplayXform, &xformChanged, &settings, &settingsChanged);
+    mHasReplayXform |= xformChanged;
+    if (settingsChanged) {
+        applySessionSettings(settings);
+    }
+
+    if (mSessionPlayer->isFinished()) {
+        std::cout << "Session replay finished: " << mReplayFrames << " frames displayed in "
+                  << time << " seconds (" << (time > 0.0 ? mReplayFrames / time : 0.0) << " fps)" << std::endl;
+        mSessionPlayer.reset();
+        window()->close();
+    }
+
+    return mHasReplayXform ? mReplayXform : xform;
+}
+
+SessionSettings
+RenderViewport::getSessionSettings() const
+{
+    SessionSettings settings;
+    settings.mDebugMode = mDebugMode;
+    settings.mRenderOutputIndx = mRenderOutputIndx;
+    settings.mDenoise = mDenoise;
+    settings.mDenoiserMode = mDenoiserMode;
+    settings.mDenoisingBufferMode = mDenoisingBufferMode;
+    settings.mProgressiveFast = mProgressiveFast;
+    settings.mFastMode = mFastMode;
+    settings.mExposure = mExposure;
+    settings.mGamma = mGamma;
+    return settings;
+}
+
+void
+RenderViewport::applySessionSettings(const SessionSettings &settings)
+{
+    mDebugMode = settings.mDebugMode;
+    mRenderOutputIndx = settings.mRenderOutputIndx;
+    mDenoise = settings.mDenoise;
+    mDenoiserMode = settings.mDenoiserMode;
+    mDenoisingBufferMode = settings.mDenoisingBufferMode;
+    mProgressiveFast = settings.mProgressiveFast;
+    mFastMode = settings.mFastMode;
+    mExposure = settings.mExposure;
+    mGamma = settings.mGamma;
+    mNeedsRefresh = true;
 }
 
 void
-RenderViewport::setDefaultCameraTransform(const scene_rdl2::math::Mat4f &xform)
+RenderViewport::flushCameraMove()
 {
-    mOrbitCam.resetTransform(xform, true);
-    mFreeCam.resetTransform(xform, true);
+    if (!mCameraMovePending) return;
+    mCameraMovePending = false;
+
+    QMouseEvent event(QEvent::MouseMove, mCameraMovePos, Qt::NoButton, mCameraMoveButtons, mCameraMoveModifiers);
+    getNavigationCam()->processMouseMoveEvent(&event);
+}
+
+bool
+RenderViewport::getDenoiseRegion(unsigned width, unsigned height, scene_rdl2::math::HalfOpenViewport &region) const
+{
+    std::lock_guard<std::mutex> lock(mDenoiseRegionMutex);
+    if (mDenoiseRegion.isEmpty()) {
+        return false;
+    }
+
+    // Qt rows run top to bottom, render buffer rows run bottom to top.
+    region = scene_rdl2::math::HalfOpenViewport(int(std::floor(mDenoiseRegion.left() * width)),
+                                                int(std::floor((1.0 - mDenoiseRegion.bottom()) * height)),
+                                                int(std::ceil(mDenoiseRegion.right() * width)),
+                                                int(std::ceil((1.0 - mDenoiseRegion.top()) * height)));
+    return true;
+}
+
+void
+RenderViewport::clearDenoiseRegion()
+{
+    {
+        std::lock_guard<std::mutex> lock(mDenoiseRegionMutex);
+        mDenoiseRegion = QRectF();
+    }
+    mDenoiseRegionBand->hide();
+    std::cout << "Denoising full frame" << std::endl;
 }
 
 NavigationCam *
@@ -245,6 +573,10 @@ RenderViewport::getNavigationCam()
 void
 RenderViewport::updateFrame(FrameUpdateEvent* event)
 {
+    if (mSessionPlayer) {
+        ++mReplayFrames;
+    }
+
     int width;
     int height;
 
@@ -260,8 +592,8 @@ RenderViewport::updateFrame(FrameUpdateEvent* event)
             QImage::Format format = QImage::Format_RGB888;
             QImage image(reinterpret_cast<const uchar*>(frame.getData()), width,
                          height, width * 3, format);
-            QImage mirror = image.mirrored(false, true);
-            mImageLabel->setPixmap(QPixmap::fromImage(mirror));
+            mLiveImage = image.mirrored(false, true);
+            mTileProgress = event->getTileProgress();
         }
         break;
 
@@ -277,21 +609,38 @@ RenderViewport::updateFrame(FrameUpdateEvent* event)
             }
 
             // not sure why this isn't resizable
-            if (width != mWidth || height != mHeight) {
+            if (!mGlslBuffer || width != mGlslBuffer->getWidth() || height != mGlslBuffer->getHeight()) {
                 delete mGlslBuffer;
                 mGlslBuffer = new GlslBuffer(width, height, mLutOverride);
                 mGlslBuffer->makeCrtGammaProgram();
             }
             MNRY_VERIFY(mGlslBuffer)->render(event->getFrame(), event->getFrameType(), event->getDebugMode(),
-                                            event->getExposure(), event->getGamma());
+                                            event->getExposure(), event->getGamma(),
+                                            event->getTileProgress().get());
 
-            // Move the image over to Qt's format
-            QImage image = mGlslBuffer->asImage();
-            mImageLabel->setPixmap(QPixmap::fromImage(image));
+            // Move the image over to Qt's format. Tile progress has already
+            // been drawn by the shader.
+            mLiveImage = mGlslBuffer->asImage();
+            mTileProgress.reset();
         }
         break;
     }
 
+    // Frames rendered at reduced resolution are enlarged to the size they
+    // would have been.
+    mPanes = event->getPanes();
+    mFrameLabel = event->getFrameLabel();
+
+    mDisplayScale = event->getDisplayScale();
+    if (mDisplayScale != 1.f) {
+        width = int(std::lround(width * mDisplayScale));
+        height = int(std::lround(height * mDisplayScale));
+        mLiveImage = mLiveImage.scaled(width, height, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    }
+
+    mDisplayFrameNumber = event->getFrameNumber();
+    showLiveImage();
+
     // Resize the widget if the viewport changed.
     if (width != mWidth || height != mHeight) {
         mImageLabel->resize(width, height);
@@ -300,9 +649,186 @@ RenderViewport::updateFrame(FrameUpdateEvent* event)
     }
 }
 
+void
+RenderViewport::takeSnapshot(bool withDisplayImage)
+{
+    // Ensure the render context exists and can be displayed.
+    // Key bindings can call this function before everything is fully ready.
+    if (!mRenderContext || !mRenderContext->isFrameReadyForDisplay()) return;
+
+    std::stringstream ss;
+    ss << "snapshot." << std::setw(4) << std::setfill('0') << mSnapIdx << ".exr";
+
+    // Only the snapshot itself happens here, encoding and writing the image is
+    // left to the writer thread so the UI stays responsive.
+    SnapshotRequest request;
+    request.mBuffer = mSnapshotWriter->acquireBuffer();
+    request.mPath = mSnapshotPath + ss.str();
+    request.mIndex = mSnapIdx;
+    request.mMetadata = mRenderContext->getSceneContext().getSceneVariables().getExrHeaderAttributes();
+    request.mAperture = mRenderContext->getRezedApertureWindow();
+    request.mRegion = mRenderContext->getRezedRegionWindow();
+    if (mCompareMode == COMPARE_TOGGLE && !mHistoryImage.isNull()) {
+        // Save what is on screen, which is the history frame.
+        request.mBuffer->init(mHistoryLinear.getWidth(), mHistoryLinear.getHeight());
+        std::copy(mHistoryLinear.getData(), mHistoryLinear.getData() + mHistoryLinear.getArea(),
+                  request.mBuffer->getData());
+    } else {
+        mRenderContext->snapshotRenderBuffer(request.mBuffer.get(), true, true);
+    }
+    if (withDisplayImage && mImageLabel->pixmap()) {
+        request.mDisplayImage = mImageLabel->pixmap()->toImage();
+    }
+    mSnapshotWriter->submit(std::move(request));
+
+    // Claim the index now so queued snapshots don't collide.
+    mSnapIdx++;
+}
+
+void
+RenderViewport::snapshotWritten(SnapshotWrittenEvent* event)
+{
+    if (event->getSuccess()) return;
+
+    // Later snapshots may still be queued under the following numbers, so
+    // numbers are only given back from the end.
+    mFailedSnapIdx.insert(event->getIndex());
+    while (!mFailedSnapIdx.empty() && *mFailedSnapIdx.rbegin() == mSnapIdx - 1) {
+        mFailedSnapIdx.erase(--mSnapIdx);
+    }
+}
+
+void
+RenderViewport::storeHistoryFrame()
+{
+    if (!mRenderContext || !mRenderContext->isFrameReadyForDisplay() || mLiveImage.isNull()) return;
+
+    scene_rdl2::fb_util::RenderBuffer linear;
+    mRenderContext->snapshotRenderBuffer(&linear, true, true);
+    const QString label = QTime::currentTime().toString("hh:mm:ss");
+    mHistory->push(linear, mLiveImage, label);
+
+    std::cout << "Stored frame " << label.toStdString() << " in snapshot history ("
+              << mHistory->size() << " frames, " << (mHistory->getMemoryUsage() >> 20) << " MB)" << std::endl;
+
+    // Compare against the frame just stored.
+    selectHistoryFrame(0);
+}
+
+void
+RenderViewport::selectHistoryFrame(size_t index)
+{
+    QString label;
+    if (!mHistory->get(index, &mHistoryImage, &mHistoryLinear, &label)) {
+        return;
+    }
+    mHistoryIndex = index;
+    std::cout << "Comparing against history frame " << index + 1 << "/" << mHistory->size()
+              << " (" << label.toStdString() << ")" << std::endl;
+    showLiveImage();
+}
+
+void
+RenderViewport::updateContactSheet(ContactSheetEvent* event)
+{
+    mContactSheetThumbnails = event->getThumbnails();
+    mDisplayFrameNumber = event->getFrameNumber();
+    showLiveImage();
+}
+
+void
+RenderViewport::showLiveImage()
+{
+    const QImage image = composeLiveImage();
+    if (image.isNull()) return;
+    mImageLabel->setPixmap(QPixmap::fromImage(image));
+    publishDisplayFrame(image);
+}
+
+QImage
+RenderViewport::composeLiveImage() const
+{
+    // The contact sheet takes the place of the frame, at the frame's size.
+    if (mContactSheet && !mContactSheetThumbnails.empty()) {
+        QSize size = mLiveImage.size();
+        if (size.isEmpty()) {
+            const QImage &thumbnail = mContactSheetThumbnails.front().mImage;
+            const int cols = int(std::ceil(std::sqrt(double(mContactSheetThumbnails.size()))));
+            const int rows = (int(mContactSheetThumbnails.size()) + cols - 1) / cols;
+            size = QSize(thumbnail.width() * cols, thumbnail.height() * rows);
+        }
+        return composeGrid(mContactSheetThumbnails, size);
+    }
+
+    if (mLiveImage.isNull()) return QImage();
+
+    if (mCompareMode == COMPARE_OFF || mHistoryImage.isNull()) {
+        QImage image = mLiveImage;
+        if (mTileProgress) {
+            image = image.convertToFormat(QImage::Format_RGB32);
+            drawTileProgress(&image, *mTileProgress);
+        }
+        if (mMultiPane && !mPanes.empty()) {
+            std::vector<DisplayPane> panes{{image, mFrameLabel}};
+            panes.insert(panes.end(), mPanes.begin(), mPanes.end());
+            image = composeGrid(panes, image.size());
+        }
+        return image;
+    }
+
+    const QImage history = mHistoryImage.size() == mLiveImage.size() ?
+        mHistoryImage : mHistoryImage.scaled(mLiveImage.size());
+
+    if (mCompareMode == COMPARE_TOGGLE) {
+        return history;
+    }
+
+    QImage composite = mLiveImage.convertToFormat(QImage::Format_RGB32);
+    const int wipe = int(mWipePosition * composite.width());
+    QPainter painter(&composite);
+    painter.drawImage(QRect(0, 0, wipe, composite.height()), history, QRect(0, 0, wipe, composite.height()));
+    painter.setPen(Qt::white);
+    painter.drawLine(wipe, 0, wipe, composite.height() - 1);
+    painter.end();
+    return composite;
+}
+
+void
+RenderViewport::publishDisplayFrame(const QImage &image)
+{
+    if (!mDisplayFrameWriter.isOpen()) return;
+
+    const unsigned width = unsigned(image.width());
+    const unsigned height = unsigned(image.height());
+    if (image.format() == QImage::Format_RGB888) {
+        mDisplayFrameWriter.write(mDisplayFrameNumber, width, height, 3, SharedFrameHeader::UINT8, true,
+                                  [&image](unsigned y) { return image.constScanLine(int(y)); });
+        return;
+    }
+
+    // Everything else is converted straight into the segment, rather than
+    // through a converted copy of the whole image.
+    const QImage rgb32 = image.format() == QImage::Format_RGB32 ||
+                         image.format() == QImage::Format_ARGB32 ||
+                         image.format() == QImage::Format_ARGB32_Premultiplied ?
+                         image : image.convertToFormat(QImage::Format_RGB32);
+    mDisplayFrameWriter.writeRows(mDisplayFrameNumber, width, height, 3, SharedFrameHeader::UINT8, true,
+                                  [&rgb32, width](unsigned y, uint8_t *dst) {
+        const QRgb *src = reinterpret_cast<const QRgb *>(rgb32.constScanLine(int(y)));
+        for (unsigned x = 0; x < width; ++x) {
+            dst[x * 3 + 0] = uint8_t(qRed(src[x]));
+            dst[x * 3 + 1] = uint8_t(qGreen(src[x]));
+            dst[x * 3 + 2] = uint8_t(qBlue(src[x]));
+        }
+    });
+}
+
 void
 RenderViewport::keyPressEvent(QKeyEvent *event)
 {
+    // Keys like F act on where the camera last saw the mouse.
+    flushCameraMove();
+
     mKey = event->key();
     if (mKeyTime == 0) {
         mKeyTime = time(nullptr);
@@ -325,6 +851,7 @@ RenderViewport::keyPressEvent(QKeyEvent *event)
                 mActiveCameraType = ORBIT_CAM;
                 std::cout << "Using OrbitCam mode." << std::endl;
             }
+            wakeCamera();
 
             mNeedsRefresh = true;
             return;
@@ -363,6 +890,14 @@ RenderViewport::keyPressEvent(QKeyEvent *event)
             return;
         }
 
+        // toggle reprojection of the previous frame
+        if (event->key() == Qt::Key_J) {
+            mReproject = !mReproject;
+            std::cout << "Reprojection is " << (mReproject ? "on" : "off") << std::endl;
+            mNeedsRefresh = true;
+            return;
+        }
+
         // select which additional (B)uffers to use for optix denoising
         if (event->key() == Qt::Key_B) {
 
@@ -371,9 +906,11 @@ RenderViewport::keyPressEvent(QKeyEvent *event)
                 mValidDenoisingBufferModes.push_back(DN_BUFFERS_BEAUTY);
                 mDenoisingBufferMode = DN_BUFFERS_BEAUTY;
 
-                const rndr::RenderOutputDriver *rod = mRenderContext->getRenderOutputDriver();
-                const bool albedoValid = rod->getDenoiserAlbedoInput() >= 0;
-                const bool normalsValid = rod->getDenoiserNormalInput() >= 0;
+                // Streamed frames come without the albedo and normals.
+                const rndr::RenderOutputDriver *rod = mRenderContext ? mRenderContext->getRenderOutputDriver() :
+                                                                       nullptr;
+                const bool albedoValid = rod && rod->getDenoiserAlbedoInput() >= 0;
+                const bool normalsValid = rod && rod->getDenoiserNormalInput() >= 0;
 
                 if (albedoValid) {
                     mValidDenoisingBufferModes.push_back(DN_BUFFERS_BEAUTY_ALBEDO);
@@ -432,6 +969,12 @@ RenderViewport::keyPressEvent(QKeyEvent *event)
                 std::cout << "Unknown pixel inspector mode" << std::endl;
             }
 
+            // Picks follow the mouse while a mode is on.
+            setMouseTracking(mInspectorMode != INSPECT_NONE || mProbe);
+            if (mInspectorMode == INSPECT_NONE) {
+                mPickOverlay->hide();
+            }
+
             mNeedsRefresh = true;
             return;
         }
@@ -450,6 +993,26 @@ RenderViewport::keyPressEvent(QKeyEvent *event)
             return;
         }
 
+        // toggle multi-pane mode
+        else if (event->key() == Qt::Key_V) {
+            mMultiPane = !mMultiPane;
+            std::cout << "Multi-pane mode is " << (mMultiPane ? "on" : "off") << std::endl;
+            mNeedsRefresh = true;
+            return;
+        }
+
+        // toggle the contact sheet
+        else if (event->key() == Qt::Key_G) {
+            mContactSheet = !mContactSheet;
+            std::cout << "Contact sheet is " << (mContactSheet ? "on" : "off") << std::endl;
+            if (!mContactSheet) {
+                mContactSheetThumbnails.clear();
+                showLiveImage();
+            }
+            mNeedsRefresh = true;
+            return;
+        }
+
         // toggle fast progressive mode
         else if (event->key() == Qt::Key_L) {
             mProgressiveFast = !mProgressiveFast;
@@ -463,26 +1026,13 @@ RenderViewport::keyPressEvent(QKeyEvent *event)
 
         // take a snapshot
         else if (event->key() == Qt::Key_K) {
-            // Ensure the render context exists and can be displayed.
-            // Key bindings can call this function before everything is fully ready.
-            if (!mRenderContext || !mRenderContext->isFrameReadyForDisplay()) return;
-            
-            std::stringstream ss;
-            ss << "snapshot." << std::setw(4) << std::setfill('0') << mSnapIdx << ".exr";
-            const std::string outputFilename = ss.str();
-            // Write the image
-            fb_util::RenderBuffer outputBuffer;
-            const rdl2::SceneObject *metadata = mRenderContext->getSceneContext().getSceneVariables().getExrHeaderAttributes();
-            const math::HalfOpenViewport aperture = mRenderContext->getRezedApertureWindow();
-            const math::HalfOpenViewport region = mRenderContext->getRezedRegionWindow();
-            mRenderContext->snapshotRenderBuffer(&outputBuffer, true, true);
-            try {
-                moonray::rndr::writePixelBuffer(outputBuffer, mSnapshotPath + outputFilename, metadata, aperture, region);
-                std::cout << "Snapshot " << outputFilename << " taken and saved to " << mSnapshotPath << std::endl;
-                mSnapIdx++;
-            } catch (...) {
-                Logger::error("Failed to write out");
-            }
+            takeSnapshot(false);
+            return;
+        }
+
+        // store the current frame in the snapshot history
+        else if (event->key() == Qt::Key_M) {
+            storeHistoryFrame();
             return;
         }
 
@@ -547,8 +1097,58 @@ RenderViewport::keyPressEvent(QKeyEvent *event)
         }
     } else if (event->modifiers() == Qt::ShiftModifier) {
 
+        // take a snapshot along with a PNG of the display
+        if (event->key() == Qt::Key_K) {
+            takeSnapshot(true);
+            return;
+        }
+
+        // toggle pipelined realtime rendering
+        else if (event->key() == Qt::Key_L) {
+            mPipelinedRealtime = !mPipelinedRealtime;
+            std::cout << "Pipelined realtime rendering is " << (mPipelinedRealtime ? "on" : "off") << std::endl;
+            return;
+        }
+
+        // toggle the hover probe
+        else if (event->key() == Qt::Key_I) {
+            mProbe = !mProbe;
+            std::cout << "Hover probe is " << (mProbe ? "on" : "off") << std::endl;
+            setMouseTracking(mInspectorMode != INSPECT_NONE || mProbe);
+            if (!mProbe) {
+                mProbeOverlay->hide();
+            }
+            return;
+        }
+
+        // toggle the GUI memory overlay
+        else if (event->key() == Qt::Key_P) {
+            mMemoryStats = !mMemoryStats;
+            std::cout << "GUI memory overlay is " << (mMemoryStats ? "on" : "off") << std::endl;
+            if (!mMemoryStats) {
+                mMemoryStatsOverlay->hide();
+            }
+            return;
+        }
+
+        // add or remove the current render output from the panes
+        else if (event->key() == Qt::Key_V) {
+            ++mPaneToggleCount;
+            mNeedsRefresh = true;
+            return;
+        }
+
+        // step back through the snapshot history
+        else if (event->key() == Qt::Key_M) {
+            const size_t count = mHistory->size();
+            if (count > 0) {
+                selectHistoryFrame((mHistoryIndex + 1) % count);
+            }
+            return;
+        }
+
         // reset exposure
-        if (event->key() == Qt::Key_X) {
+        else if (event->key() == Qt::Key_X) {
             mExposure = 0.f;
             std::cout << "Exposure is reset." << std::endl;
             mNeedsRefresh = true;
@@ -596,7 +1196,29 @@ RenderViewport::keyPressEvent(QKeyEvent *event)
         }
 
     } else if (event->modifiers() == Qt::AltModifier) {
-        if (event->key() == Qt::Key_Up) {
+        // cycle how the history frame is compared with the live render
+        if (event->key() == Qt::Key_M) {
+            mCompareMode = (CompareMode)((int)(mCompareMode + 1) % NUM_COMPARE_MODES);
+            switch (mCompareMode) {
+            case COMPARE_OFF:
+                std::cout << "Compare: off" << std::endl;
+                break;
+            case COMPARE_TOGGLE:
+                std::cout << "Compare: showing history frame" << std::endl;
+                break;
+            case COMPARE_WIPE:
+                std::cout << "Compare: wipe" << std::endl;
+                break;
+            default:
+                MNRY_ASSERT(0);
+            }
+            if (mCompareMode != COMPARE_OFF && mHistoryImage.isNull()) {
+                std::cout << "Snapshot history is empty, press M to store a frame" << std::endl;
+            }
+            showLiveImage();
+            return;
+        }
+        else if (event->key() == Qt::Key_Up) {
             if (isFastProgressive()) {
                 mFastMode = nextFastMode(mFastMode);
                 mNeedsRefresh = true;
@@ -618,6 +1240,7 @@ RenderViewport::keyPressEvent(QKeyEvent *event)
         return;
     }
 
+    wakeCamera();
     if (!getNavigationCam()->processKeyboardEvent(event, true)) {
         QWidget::keyPressEvent(event);
     }
@@ -665,72 +1288,116 @@ RenderViewport::keyReleaseEvent(QKeyEvent *event)
         mKeyTime = 0;
         mKey = -1;
     }
+    wakeCamera();
     if (!getNavigationCam()->processKeyboardEvent(event, false)) {
         QWidget::keyReleaseEvent(event);
     }
 }
 
+void
+RenderViewport::submitPick(const QPoint &pos, bool hover)
+{
+    if (!mRenderContext || !mRenderContext->isFrameReadyForDisplay()) return;
+
+    // Pick in render buffer pixels.
+    PickRequest request;
+    request.mMode = InspectorMode(mInspectorMode);
+    request.mX = int(pos.x() / mDisplayScale);
+    request.mY = int((mHeight - 1 - pos.y()) / mDisplayScale);
+    request.mWidgetPos = pos;
+    request.mHover = hover;
+    mPickWorker->submit(request);
+}
+
+void
+RenderViewport::showPickResult(PickResultEvent* event)
+{
+    // The mode may have been turned off while the pick was running.
+    if (mInspectorMode == INSPECT_NONE) return;
+
+    mPickOverlay->setText(event->getText());
+    mPickOverlay->adjustSize();
+
+    // Next to the cursor, kept inside the viewport.
+    constexpr int cursorOffset = 16;
+    QPoint pos = event->getWidgetPos() + QPoint(cursorOffset, cursorOffset);
+    pos.setX(std::max(0, std::min(pos.x(), width() - mPickOverlay->width())));
+    pos.setY(std::max(0, std::min(pos.y(), height() - mPickOverlay->height())));
+    mPickOverlay->move(pos);
+    mPickOverlay->show();
+}
+
+bool
+RenderViewport::getProbePosition(int *x, int *y) const
+{
+    if (!mProbe) return false;
+    // Both halves come from the same cursor position.
+    const uint64_t position = mProbePosition;
+    *x = int(int32_t(uint32_t(position >> 32)));
+    *y = int(int32_t(uint32_t(position)));
+    return true;
+}
+
+void
+RenderViewport::showProbe(ProbeEvent* event)
+{
+    if (!mProbe) return;
+
+    mProbeOverlay->setText(event->getText());
+    mProbeOverlay->adjustSize();
+
+    constexpr int cursorOffset = 16;
+    QPoint pos = mProbeWidgetPos + QPoint(cursorOffset, -cursorOffset - mProbeOverlay->height());
+    pos.setX(std::max(0, std::min(pos.x(), width() - mProbeOverlay->width())));
+    pos.setY(std::max(0, std::min(pos.y(), height() - mProbeOverlay->height())));
+    mProbeOverlay->move(pos);
+    mProbeOverlay->show();
+}
+
+void
+RenderViewport::showMemoryStats(MemoryStatsEvent* event)
+{
+    if (!mMemoryStats) return;
+
+    mMemoryStatsOverlay->setText(event->getText());
+    mMemoryStatsOverlay->adjustSize();
+    mMemoryStatsOverlay->move(std::max(0, width() - mMemoryStatsOverlay->width()), 0);
+    mMemoryStatsOverlay->show();
+}
+
 void
 RenderViewport::mousePressEvent(QMouseEvent *event)
 {
+    flushCameraMove();
+
     // get mouse position
     mMousePos = event->pos().x();
     if (mMouseTime == 0) {
         mMouseTime = time(nullptr);
     }
+
+    // Start moving the wipe
+    if (event->button() == Qt::RightButton && event->modifiers() == Qt::ShiftModifier &&
+        mCompareMode == COMPARE_WIPE) {
+        mDraggingWipe = true;
+        mouseMoveEvent(event);
+        return;
+    }
+
+    // Start dragging out a denoise region
+    if (event->button() == Qt::LeftButton && event->modifiers() == Qt::ShiftModifier) {
+        mSelectingDenoiseRegion = true;
+        mDenoiseRegionOrigin = event->pos();
+        mDenoiseRegionBand->setGeometry(QRect(mDenoiseRegionOrigin, QSize()));
+        mDenoiseRegionBand->show();
+        return;
+    }
+
+    wakeCamera();
     if (!getNavigationCam()->processMousePressEvent(event, mKey)) {
-        const int x = event->x();
-        const int y = mHeight - event->y();
-
-        switch (mInspectorMode) {
-        case INSPECT_LIGHT_CONTRIBUTIONS:
-            {
-                moonray::shading::LightContribArray rdlLights;
-                mRenderContext->handlePickLightContributions(x, y, rdlLights);
-                std::sort(rdlLights.begin(), rdlLights.end(),
-                          [&](const moonray::shading::LightContrib &l0, const moonray::shading::LightContrib &l1) {
-                              return l0.second < l1.second;
-                          });
-                std::cout << "Light Pick Results: (" << x << ", " << y << ")" << std::endl;
-                for (unsigned int i = 0; i < rdlLights.size(); ++i) {
-                    std::cout << "\t"
-                              << rdlLights[i].first->getName() << ": "
-                              << rdlLights[i].second << std::endl;
-                }
-            }
-            break;
-        case INSPECT_GEOMETRY:
-            {
-                const rdl2::Geometry *geometry = mRenderContext->handlePickGeometry(x, y);
-                std::cout << "Geometry Pick Result: (" << x << ", " << y << ")" << std::endl;
-                if (geometry) {
-                    std::cout << "\t" << geometry->getName() << std::endl;
-                }
-                
-            }
-            break;
-        case INSPECT_GEOMETRY_PART:
-            {
-                std::string parts;
-                const rdl2::Geometry* geometry = mRenderContext->handlePickGeometryPart(x, y, parts);
-                std::cout << "Geometry Part Pick Result: (" << x << ", " << y << ")" << std::endl;
-
-                if (geometry) {
-                    std::cout << "\t" << geometry->getName() << ", " << parts << std::endl;
-                }
-            }
-            break;
-        case INSPECT_MATERIAL:
-            {
-                const rdl2::Material *material = mRenderContext->handlePickMaterial(x, y);
-                std::cout << "Material Pick Result: (" << x << ", " << y << ")" << std::endl;
-                if (material) {
-                    std::cout << "\t" << material->getName() << std::endl;
-                }
-            }
-            break;
-        case INSPECT_NONE:
-        default:
+        if (mInspectorMode != INSPECT_NONE) {
+            submitPick(event->pos(), false);
+        } else {
             QWidget::mousePressEvent(event);
         }
     }
@@ -739,6 +1406,38 @@ RenderViewport::mousePressEvent(QMouseEvent *event)
 void
 RenderViewport::mouseReleaseEvent(QMouseEvent *event)
 {
+    flushCameraMove();
+
+    if (mDraggingWipe && event->button() == Qt::RightButton) {
+        mDraggingWipe = false;
+        mMouseTime = 0;
+        return;
+    }
+
+    if (mSelectingDenoiseRegion && event->button() == Qt::LeftButton) {
+        mSelectingDenoiseRegion = false;
+        mMouseTime = 0;
+
+        // A tap rather than a drag goes back to denoising the full frame.
+        const QRect region = QRect(mDenoiseRegionOrigin, event->pos()).normalized() &
+                             QRect(0, 0, mWidth, mHeight);
+        constexpr int minRegionSize = 4;
+        if (region.width() < minRegionSize || region.height() < minRegionSize) {
+            clearDenoiseRegion();
+        } else {
+            // Kept as a fraction of the frame, which holds whatever
+            // resolution the frame is rendered at for display.
+            std::lock_guard<std::mutex> lock(mDenoiseRegionMutex);
+            mDenoiseRegion = QRectF(double(region.left()) / mWidth, double(region.top()) / mHeight,
+                                    double(region.width()) / mWidth, double(region.height()) / mHeight);
+            mDenoiseRegionBand->setGeometry(region);
+            std::cout << "Denoising region: (" << region.left() << ", " << region.top() << ") "
+                      << region.width() << "x" << region.height() << std::endl;
+        }
+        mNeedsRefresh = true;
+        return;
+    }
+
     mMouseTime = time(nullptr) - mMouseTime;
     // mouse click release
     if (mMouseTime < 1) {
@@ -767,6 +1466,7 @@ RenderViewport::mouseReleaseEvent(QMouseEvent *event)
         }
     }
     mMouseTime = 0;
+    wakeCamera();
     if (!getNavigationCam()->processMouseReleaseEvent(event)) {
         QWidget::mouseReleaseEvent(event);
     }
@@ -775,6 +1475,34 @@ RenderViewport::mouseReleaseEvent(QMouseEvent *event)
 void
 RenderViewport::mouseMoveEvent(QMouseEvent *event)
 {
+    if (mDraggingWipe) {
+        // A fraction of the image on screen, enlarged or not.
+        if (!mLiveImage.isNull()) {
+            mWipePosition = std::max(0.f, std::min(1.f, float(event->pos().x()) / float(mLiveImage.width())));
+            showLiveImage();
+        }
+        return;
+    }
+
+    if (mSelectingDenoiseRegion) {
+        mDenoiseRegionBand->setGeometry(QRect(mDenoiseRegionOrigin, event->pos()).normalized());
+        return;
+    }
+
+    // Inspect whatever is under the cursor while hovering.
+    if (mInspectorMode != INSPECT_NONE && event->buttons() == Qt::NoButton) {
+        submitPick(event->pos(), true);
+    }
+
+    // The render thread picks up the new position the next time it updates
+    // the probe.
+    if (mProbe) {
+        mProbeWidgetPos = event->pos();
+        const int x = int(event->x() / mDisplayScale);
+        const int y = int((mHeight - 1 - event->y()) / mDisplayScale);
+        mProbePosition = (uint64_t(uint32_t(x)) << 32) | uint32_t(y);
+    }
+
     // Handle exposure/gamma adjustment by mouse drag
     if (QGuiApplication::mouseButtons() == Qt::LeftButton) {
         if (mUpdateExposure) {
@@ -793,6 +1521,18 @@ RenderViewport::mouseMoveEvent(QMouseEvent *event)
         }
         mNeedsRefresh = true;
     }
+
+    // Drags move the camera, and several can arrive between camera steps.
+    // Only the latest position matters, since the camera works from the
+    // distance moved since the last one it saw.
+    if (event->buttons() != Qt::NoButton) {
+        mCameraMovePending = true;
+        mCameraMovePos = event->pos();
+        mCameraMoveButtons = event->buttons();
+        mCameraMoveModifiers = event->modifiers();
+        wakeCamera();
+        return;
+    }
     if (!getNavigationCam()->processMouseMoveEvent(event)) {
         QWidget::mouseMoveEvent(event);
     }
@@ -5,18 +5,37 @@
 
 #ifndef Q_MOC_RUN
 #include "QtQuirks.h"
+#include "CameraPublisher.h"
+#include "ContactSheetEvent.h"
 #include "FrameUpdateEvent.h"
 #include "FreeCam.h"
 #include "GlslBuffer.h"
 #include "GuiTypes.h"
+#include "MemoryStatsEvent.h"
 #include "OrbitCam.h"
+#include "PickWorker.h"
+#include "ProbeEvent.h"
+#include "SessionRecording.h"
+#include "SharedFrameWriter.h"
+#include "SnapshotHistory.h"
+#include "SnapshotWriter.h"
 
 #include <mcrt_denoise/denoiser/Denoiser.h>
+#include <scene_rdl2/common/math/Viewport.h>
 #endif
 
+#include <QImage>
+#include <QRect>
 #include <QWidget>
 
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <set>
+
 class QLabel;
+class QTimer;
+class QRubberBand;
 
 namespace moonray_gui {
 
@@ -33,25 +52,75 @@ public:
 
     /// Navigation camera access.
     void setCameraRenderContext(const moonray::rndr::RenderContext &context);
-    void setDefaultCameraTransform(const scene_rdl2::math::Mat4f &xform);
+    void setPickBuffer(PickBuffer *pickBuffer);
     NavigationCam *getNavigationCam();
 
+    /// The navigation camera is integrated on the Qt thread at a fixed rate.
+    /// Returns its transform extrapolated to time, for the render thread.
+    scene_rdl2::math::Mat4f getCameraTransform(double time) const { return mCameraPublisher.get(time); }
+
+    /// Resets the navigation camera to xform, also making it the default if
+    /// makeDefault is set, and publishes the transform the camera conditions
+    /// it to without waiting for the next integration step. Returns that
+    /// transform. The cameras belong to the Qt thread, so calls from other
+    /// threads block until it has run there.
+    scene_rdl2::math::Mat4f resetCameraTransform(const scene_rdl2::math::Mat4f &xform, bool makeDefault);
+
+    /// Session recording: writes the camera transform and settings to path
+    /// as they change, or drives them from a recording made that way and
+    /// closes the window at the end. Both start once the renderer is ready.
+    /// Return false if path can't be used.
+    bool recordSession(const std::string &path);
+    bool replaySession(const std::string &path);
+
+    /// Publishes each frame as displayed to the named shared memory segment.
+    /// Returns false if it can't be created.
+    bool publishDisplayFrames(const std::string &shmName);
+
     void setShowTileProgress(bool tileProgress) { mShowTileProgress = tileProgress; }
     bool getShowTileProgress() const    { return mShowTileProgress; }
     void setApplyColorRenderTransform(bool applyCrt) { mApplyColorRenderTransform = applyCrt; }
     bool getApplyColorRenderTransform() const { return mApplyColorRenderTransform; }
     bool getDenoisingEnabled() const { return mDenoise; }
+    void setDenoisingEnabled(bool denoise) { mDenoise = denoise; }
     moonray::denoiser::DenoiserMode getDenoiserMode() const { return mDenoiserMode; }
     DenoisingBufferMode getDenoisingBufferMode() const { return mDenoisingBufferMode; }
+    bool getReprojectionEnabled() const { return mReproject; }
+
+    /// Returns true if denoising is restricted to a user-selected region, in
+    /// which case region is set in the coordinates of a width x height render
+    /// buffer. Called from the render thread.
+    bool getDenoiseRegion(unsigned width, unsigned height, scene_rdl2::math::HalfOpenViewport &region) const;
     DebugMode getDebugMode() const      { return mDebugMode; }
     int getRenderOutputIndx() const { return mRenderOutputIndx; }
 
+    /// Multi-pane mode shows the selected render outputs next to the frame.
+    /// The toggle count goes up each time the user asks for the output being
+    /// viewed to be added to or removed from the panes.
+    bool getMultiPaneEnabled() const { return mMultiPane; }
+    int getPaneToggleCount() const { return mPaneToggleCount; }
+
+    bool getContactSheetEnabled() const { return mContactSheet; }
+
+    /// Returns true if the hover probe is on, in which case x and y are set
+    /// to the render buffer pixel under the cursor. Safe to call from any
+    /// thread.
+    bool getProbePosition(int *x, int *y) const;
+
+    /// True while the GUI memory overlay is on. Safe to call from any thread.
+    bool getMemoryStatsEnabled() const { return mMemoryStats; }
+
+    /// Bytes held by the snapshot history. Safe to call from any thread.
+    size_t getSnapshotHistoryMemoryUsage() const { return mHistory->getMemoryUsage(); }
+
     bool getUpdateExposure() const { return mUpdateExposure; }
     bool getUpdateGamma() const { return mUpdateGamma; }
     float getExposure() const { return mExposure; }
     float getGamma() const { return mGamma; }
 
     bool isFastProgressive() const { return mProgressiveFast; }
+    void setFastProgressive(bool fast) { mProgressiveFast = fast; }
+    bool getPipelinedRealtime() const { return mPipelinedRealtime; }
 
     moonray::rndr::FastRenderMode getFastMode() const { return mFastMode; }
     void setFastMode(moonray::rndr::FastRenderMode mode) { mFastMode = mode; }
@@ -64,9 +133,33 @@ public:
 
     bool getUseOCIO() const { return mUseOCIO; }
 
+    /// Blocks until queued snapshots are on disk.
+    void waitForSnapshots() { mSnapshotWriter->waitForIdle(); }
+
+    /// Waits for the pixel inspector pick in progress and holds back others
+    /// until resumed, while the scene or camera changes.
+    void pausePicks() { mPickWorker->pause(); }
+    void resumePicks() { mPickWorker->resume(); }
+
+    /// Called by the main application with the result of a pixel inspector pick.
+    void showPickResult(PickResultEvent* event);
+
+    /// Called by the main application with the values under the hover probe.
+    void showProbe(ProbeEvent* event);
+
+    /// Called by the main application with the GUI memory statistics.
+    void showMemoryStats(MemoryStatsEvent* event);
+
+    /// Called by the main application as each snapshot is written, so the
+    /// number of one which failed can be used again.
+    void snapshotWritten(SnapshotWrittenEvent* event);
+
     /// Called by the main application to update the frame which is displayed.
     void updateFrame(FrameUpdateEvent* event);
 
+    /// Called by the main application with new contact sheet thumbnails.
+    void updateContactSheet(ContactSheetEvent* event);
+
     // Get status string
     QString getSettings() const { return "Exposure: " + QString::number(mExposure) + 
                                          "\nGamma: " + QString::number(mGamma); }
@@ -80,10 +173,48 @@ protected:
     void mouseReleaseEvent(QMouseEvent *event) override;
     void mouseMoveEvent(QMouseEvent *event) override;
 
+private slots:
+    /// Steps the navigation camera and publishes its transform.
+    void integrateCamera();
+
 private:
     void setupUi();
 
+    /// Passes the latest compressed mouse drag to the navigation camera.
+    void flushCameraMove();
+
+    /// Restarts camera integration after input, if it stopped with the
+    /// camera at rest.
+    void wakeCamera();
+
+    SessionSettings getSessionSettings() const;
+    void applySessionSettings(const SessionSettings &settings);
+
+    /// Moves session replay on to time, returning the transform to use.
+    scene_rdl2::math::Mat4f advanceReplay(double time, const scene_rdl2::math::Mat4f &xform);
+    void clearDenoiseRegion();
+
+    /// Queues the current render buffer to be written to the snapshot path,
+    /// optionally along with a PNG of what is on screen.
+    void takeSnapshot(bool withDisplayImage);
+
+    /// Queues a pixel inspector pick at widget position pos.
+    void submitPick(const QPoint &pos, bool hover);
+
+    /// Snapshot history: storing the current frame, selecting which stored
+    /// frame to compare against and showing the live frame composited with it.
+    void storeHistoryFrame();
+    void selectHistoryFrame(size_t index);
+    void showLiveImage();
+    QImage composeLiveImage() const;
+
+    /// Publishes image, as shown, to the display frame segment if it is open.
+    void publishDisplayFrame(const QImage &image);
+
     QLabel* mImageLabel;
+    QLabel* mPickOverlay;
+    QLabel* mProbeOverlay;
+    QLabel* mMemoryStatsOverlay;
 
     // OpenGL CRT
     GlslBuffer *mGlslBuffer;
@@ -94,6 +225,26 @@ private:
     CameraType mActiveCameraType;
     OrbitCam mOrbitCam;
     FreeCam mFreeCam;
+    QTimer *mCameraTimer;
+    double mLastCameraIntegrationTime; // negative while integration is stopped
+    scene_rdl2::math::Mat4f mLastIntegratedXform;
+    CameraPublisher mCameraPublisher;
+
+    // Mouse drags are compressed to the latest position between camera steps.
+    bool mCameraMovePending;
+    QPoint mCameraMovePos;
+    Qt::MouseButtons mCameraMoveButtons;
+    Qt::KeyboardModifiers mCameraMoveModifiers;
+
+    std::unique_ptr<SessionRecorder> mSessionRecorder;
+    std::unique_ptr<SessionPlayer> mSessionPlayer;
+    double mSessionStartTime; // negative until the renderer is ready
+    scene_rdl2::math::Mat4f mReplayXform;
+    bool mHasReplayXform;
+    unsigned mReplayFrames; // frames displayed during replay
+
+    SharedFrameWriter mDisplayFrameWriter;
+    uint64_t mDisplayFrameNumber;
 
     bool mShowTileProgress;
     bool mApplyColorRenderTransform;
@@ -101,6 +252,12 @@ private:
     moonray::denoiser::DenoiserMode mDenoiserMode;
     DenoisingBufferMode mDenoisingBufferMode;
     std::vector<DenoisingBufferMode> mValidDenoisingBufferModes;
+    bool mSelectingDenoiseRegion; // is a denoise region being dragged out?
+    QPoint mDenoiseRegionOrigin;
+    QRectF mDenoiseRegion; // fraction of the frame, empty if denoising the full frame
+    mutable std::mutex mDenoiseRegionMutex;
+    QRubberBand *mDenoiseRegionBand;
+    bool mReproject; // show the previous frame warped into the new view after camera moves
     DebugMode mDebugMode;
     int mRenderOutputIndx;
     bool mNeedsRefresh;
@@ -113,10 +270,34 @@ private:
     int mKeyTime; // elapsed time between key press and release
     int mMouseTime; // elapsed time between mouse button press and release
     int mSnapIdx;
+    std::set<int> mFailedSnapIdx; // failed snapshots not yet given back
     std::string mSnapshotPath;
+    std::unique_ptr<SnapshotWriter> mSnapshotWriter;
+    std::unique_ptr<PickWorker> mPickWorker;
+    QImage mLiveImage; // last frame received, before any comparison is drawn over it
+    std::shared_ptr<const TileProgress> mTileProgress; // outlines still to draw over mLiveImage
+    bool mMultiPane;
+    int mPaneToggleCount;
+    std::vector<DisplayPane> mPanes; // shown next to mLiveImage in multi-pane mode
+    QString mFrameLabel;
+    bool mContactSheet;
+    std::vector<DisplayPane> mContactSheetThumbnails;
+    std::unique_ptr<SnapshotHistory> mHistory;
+    size_t mHistoryIndex;
+    QImage mHistoryImage; // decompressed display image of the selected history frame
+    scene_rdl2::fb_util::RenderBuffer mHistoryLinear;
+    CompareMode mCompareMode;
+    float mWipePosition; // fraction of the width
+    bool mDraggingWipe;
     int mInspectorMode;
+    std::atomic<bool> mProbe; // show buffer values under the cursor
+    std::atomic<uint64_t> mProbePosition; // render buffer pixel under the cursor, x in the high half
+    QPoint mProbeWidgetPos;
+    std::atomic<bool> mMemoryStats; // show GUI memory use
     const moonray::rndr::RenderContext *mRenderContext;
     bool mProgressiveFast;
+    bool mPipelinedRealtime; // display realtime frames while the next one renders
+    float mDisplayScale; // enlargement applied to the last frame for display
     moonray::rndr::FastRenderMode mFastMode;
     bool mUseOCIO; // toggles on/off OCIO support
 
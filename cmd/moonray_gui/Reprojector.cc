@@ -0,0 +1,303 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+/// @file Reprojector.cc
+
+#include "Reprojector.h"
+#include "BufferPool.h"
+
+#include <scene_rdl2/common/platform/Platform.h>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <limits>
+
+namespace moonray_gui {
+
+using scene_rdl2::fb_util::FloatBuffer;
+using scene_rdl2::fb_util::RenderBuffer;
+using scene_rdl2::fb_util::RenderColor;
+using scene_rdl2::math::Mat4f;
+using scene_rdl2::math::Vec3f;
+
+namespace {
+
+// How many samples worth of confidence the reprojected frame gets when new
+// samples are blended over it.
+constexpr float HISTORY_WEIGHT = 4.f;
+
+constexpr uint64_t EMPTY_KEY = std::numeric_limits<uint64_t>::max();
+
+template <typename Func> void
+forEachRow(unsigned h, bool parallel, const Func &func)
+{
+    if (parallel) {
+        tbb::parallel_for(tbb::blocked_range<unsigned>(0, h), [&](const tbb::blocked_range<unsigned> &range) {
+            for (unsigned y = range.begin(); y != range.end(); ++y) {
+                func(y);
+            }
+        });
+    } else {
+        for (unsigned y = 0; y < h; ++y) {
+            func(y);
+        }
+    }
+}
+
+inline bool
+isValidDepth(float depth)
+{
+    return depth > 0.f && depth < 1e20f && std::isfinite(depth);
+}
+
+// Positive floats sort the same way as their bit patterns.
+inline uint64_t
+makeKey(float depth, uint32_t index)
+{
+    uint32_t depthBits;
+    std::memcpy(&depthBits, &depth, sizeof(depthBits));
+    return (uint64_t(depthBits) << 32) | index;
+}
+
+inline float
+keyDepth(uint64_t key)
+{
+    const uint32_t depthBits = uint32_t(key >> 32);
+    float depth;
+    std::memcpy(&depth, &depthBits, sizeof(depth));
+    return depth;
+}
+
+inline void
+atomicMin(std::atomic<uint64_t> &target, uint64_t value)
+{
+    uint64_t current = target.load(std::memory_order_relaxed);
+    while (value < current &&
+           !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+} // anonymous namespace
+
+bool
+CameraProjection::fromCamera(const scene_rdl2::rdl2::Camera *camera, CameraProjection *projection)
+{
+    if (!camera || camera->getSceneClass().getName() != "PerspectiveCamera") {
+        return false;
+    }
+
+    try {
+        projection->mFocal = camera->get<scene_rdl2::rdl2::Float>("focal");
+        projection->mFilmWidth = camera->get<scene_rdl2::rdl2::Float>("film_width_aperture");
+        projection->mOffsetX = camera->get<scene_rdl2::rdl2::Float>("horizontal_film_offset");
+        projection->mOffsetY = camera->get<scene_rdl2::rdl2::Float>("vertical_film_offset");
+    } catch (const std::exception &e) {
+        std::cerr << "Cannot reproject with camera " << camera->getName() << ": " << e.what() << std::endl;
+        return false;
+    }
+    return projection->mFocal > 0.f && projection->mFilmWidth > 0.f;
+}
+
+Vec3f
+CameraProjection::pixelDirection(unsigned w, unsigned h, float x, float y) const
+{
+    const float filmHeight = mFilmWidth * float(h) / float(w);
+    const float fx = ((x + 0.5f) / float(w) - 0.5f) * mFilmWidth + mOffsetX;
+    const float fy = ((y + 0.5f) / float(h) - 0.5f) * filmHeight + mOffsetY;
+    return Vec3f(fx / mFocal, fy / mFocal, -1.f);
+}
+
+Reprojector::Reprojector() :
+    mHasHistory(false),
+    mHistoryC2w(scene_rdl2::math::one),
+    mHistoryProjection(),
+    mSplatKeyCount(0),
+    mHasSplat(false),
+    mSplatC2w(scene_rdl2::math::one),
+    mHasBlended(false),
+    mBlendedC2w(scene_rdl2::math::one),
+    mBlendedProjection()
+{
+}
+
+void
+Reprojector::clearHistory()
+{
+    mHasHistory = false;
+    mHasSplat = false;
+    mHasBlended = false;
+}
+
+void
+Reprojector::setHistory(const RenderBuffer &beauty, const FloatBuffer &depth,
+                        const Mat4f &c2w, const CameraProjection &projection)
+{
+    clearHistory();
+    if (beauty.getWidth() != depth.getWidth() || beauty.getHeight() != depth.getHeight()) {
+        return;
+    }
+
+    if (mHistoryBeauty.getWidth() != beauty.getWidth() || mHistoryBeauty.getHeight() != beauty.getHeight()) {
+        mHistoryBeauty.init(beauty.getWidth(), beauty.getHeight());
+        mHistoryDepth.init(depth.getWidth(), depth.getHeight());
+    }
+    std::copy(beauty.getData(), beauty.getData() + beauty.getArea(), mHistoryBeauty.getData());
+    std::copy(depth.getData(), depth.getData() + depth.getArea(), mHistoryDepth.getData());
+    mHistoryC2w = c2w;
+    mHistoryProjection = projection;
+    mHasHistory = true;
+}
+
+size_t
+Reprojector::getMemoryUsage() const
+{
+    return getBufferSize(mHistoryBeauty) + getBufferSize(mHistoryDepth) + getBufferSize(mBlendedDepth) +
+           mSplatKeyCount * sizeof(std::atomic<uint64_t>);
+}
+
+void
+Reprojector::release()
+{
+    clearHistory();
+    mHistoryBeauty = RenderBuffer();
+    mHistoryDepth = FloatBuffer();
+    mBlendedDepth = FloatBuffer();
+    mSplatKeys.reset();
+    mSplatKeyCount = 0;
+}
+
+void
+Reprojector::splat(const Mat4f &c2w, const CameraProjection &projection, bool parallel)
+{
+    const unsigned w = mHistoryBeauty.getWidth();
+    const unsigned h = mHistoryBeauty.getHeight();
+
+    if (mSplatKeyCount != size_t(w) * size_t(h)) {
+        mSplatKeyCount = size_t(w) * size_t(h);
+        mSplatKeys.reset(new std::atomic<uint64_t>[mSplatKeyCount]);
+    }
+    for (size_t i = 0; i < mSplatKeyCount; ++i) {
+        mSplatKeys[i].store(EMPTY_KEY, std::memory_order_relaxed);
+    }
+
+    // History camera space -> new camera space.
+    const Mat4f oldToNew = mHistoryC2w * c2w.inverse();
+
+    const float filmHeight = projection.mFilmWidth * float(h) / float(w);
+
+    forEachRow(h, parallel, [&](unsigned y) {
+        const float *depthRow = mHistoryDepth.getRow(y);
+        for (unsigned x = 0; x < w; ++x) {
+            const float depth = depthRow[x];
+            const Vec3f dir = mHistoryProjection.pixelDirection(w, h, float(x), float(y));
+
+            // Pixels without a valid depth (typically the background) are
+            // treated as infinitely far away, so only rotation affects them.
+            Vec3f p;
+            float newDepth;
+            if (isValidDepth(depth)) {
+                p = transformPoint(oldToNew, dir * depth);
+                newDepth = -p.z;
+            } else {
+                p = transformVector(oldToNew, dir);
+                newDepth = std::numeric_limits<float>::infinity();
+            }
+            if (p.z >= 0.f) {
+                continue;
+            }
+
+            const float fx = -p.x / p.z * projection.mFocal;
+            const float fy = -p.y / p.z * projection.mFocal;
+            const float sx = ((fx - projection.mOffsetX) / projection.mFilmWidth + 0.5f) * float(w);
+            const float sy = ((fy - projection.mOffsetY) / filmHeight + 0.5f) * float(h);
+            if (!(sx >= 0.f && sx < float(w) && sy >= 0.f && sy < float(h))) {
+                continue;
+            }
+
+            const size_t dstIndex = size_t(sy) * w + size_t(sx);
+            atomicMin(mSplatKeys[dstIndex], makeKey(newDepth, uint32_t(y * w + x)));
+        }
+    });
+}
+
+bool
+Reprojector::reproject(const RenderBuffer &beauty, const FloatBuffer &depth, const FloatBuffer &weights,
+                       const Mat4f &c2w, const CameraProjection &projection,
+                       RenderBuffer *dst, bool parallel)
+{
+    const unsigned w = beauty.getWidth();
+    const unsigned h = beauty.getHeight();
+    if (!mHasHistory || mHistoryBeauty.getWidth() != w || mHistoryBeauty.getHeight() != h ||
+        depth.getWidth() != w || depth.getHeight() != h ||
+        weights.getWidth() != w || weights.getHeight() != h) {
+        return false;
+    }
+
+    // The restarted frame we were blending into has been abandoned for a new
+    // view. What was last shown is a better start than the older history.
+    if (mHasBlended && !scene_rdl2::math::isEqual(mBlendedC2w, c2w) &&
+        dst->getWidth() == w && dst->getHeight() == h) {
+        setHistory(*dst, mBlendedDepth, mBlendedC2w, mBlendedProjection);
+    }
+
+    if (!mHasSplat || !scene_rdl2::math::isEqual(mSplatC2w, c2w)) {
+        splat(c2w, projection, parallel);
+        mSplatC2w = c2w;
+        mHasSplat = true;
+    }
+
+    if (dst->getWidth() != w || dst->getHeight() != h) {
+        dst->init(w, h);
+    }
+    if (mBlendedDepth.getWidth() != w || mBlendedDepth.getHeight() != h) {
+        mBlendedDepth.init(w, h);
+    }
+
+    const RenderColor *historyPixels = mHistoryBeauty.getData();
+    forEachRow(h, parallel, [&](unsigned y) {
+        const RenderColor *beautyRow = beauty.getRow(y);
+        const float *depthRow = depth.getRow(y);
+        const float *weightRow = weights.getRow(y);
+        RenderColor *dstRow = dst->getRow(y);
+        float *blendedDepthRow = mBlendedDepth.getRow(y);
+
+        for (unsigned x = 0; x < w; ++x) {
+            // The forward splat leaves pinholes where the view is magnified,
+            // so fall back to the closest of the neighbouring splats.
+            uint64_t key = mSplatKeys[size_t(y) * w + x].load(std::memory_order_relaxed);
+            if (key == EMPTY_KEY) {
+                for (unsigned ny = (y > 0 ? y - 1 : 0); ny <= std::min(y + 1, h - 1); ++ny) {
+                    for (unsigned nx = (x > 0 ? x - 1 : 0); nx <= std::min(x + 1, w - 1); ++nx) {
+                        key = std::min(key, mSplatKeys[size_t(ny) * w + nx].load(std::memory_order_relaxed));
+                    }
+                }
+            }
+
+            const float weight = weightRow[x];
+            if (key == EMPTY_KEY) {
+                dstRow[x] = beautyRow[x];
+                blendedDepthRow[x] = depthRow[x];
+                continue;
+            }
+
+            const RenderColor &warped = historyPixels[uint32_t(key)];
+            const float t = weight / (weight + HISTORY_WEIGHT);
+            dstRow[x] = warped + (beautyRow[x] - warped) * t;
+            blendedDepthRow[x] = weight > 0.f ? depthRow[x] : keyDepth(key);
+        }
+    });
+
+    mBlendedC2w = c2w;
+    mBlendedProjection = projection;
+    mHasBlended = true;
+    return true;
+}
+
+} // namespace moonray_gui
+
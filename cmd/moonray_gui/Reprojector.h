@@ -0,0 +1,114 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+/// @file Reprojector.h
+
+#pragma once
+
+#include <scene_rdl2/common/fb_util/FbTypes.h>
+#include <scene_rdl2/common/math/Mat4.h>
+#include <scene_rdl2/common/math/Vec3.h>
+#include <scene_rdl2/scene/rdl2/Camera.h>
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+namespace moonray_gui {
+
+/// Intrinsics of a perspective camera, in the same units as its film aperture.
+struct CameraProjection
+{
+    float mFocal;
+    float mFilmWidth;
+    float mOffsetX;
+    float mOffsetY;
+
+    /// Reads the projection of camera, returning false if it isn't a
+    /// perspective camera.
+    static bool fromCamera(const scene_rdl2::rdl2::Camera *camera, CameraProjection *projection);
+
+    /// Camera space direction through the center of pixel (x, y) of a w x h
+    /// frame, with a z component of -1. Rows run bottom to top, matching the
+    /// camera's +y.
+    scene_rdl2::math::Vec3f pixelDirection(unsigned w, unsigned h, float x, float y) const;
+};
+
+/**
+ * Keeps a frame along with its depth and camera, and warps it into new views
+ * so that there is something sensible to show while the renderer is still
+ * filling in the first samples after a camera move.
+ */
+class Reprojector
+{
+public:
+    Reprojector();
+
+    /// Stores beauty and depth as seen from c2w as the frame to reproject.
+    void setHistory(const scene_rdl2::fb_util::RenderBuffer &beauty,
+                    const scene_rdl2::fb_util::FloatBuffer &depth,
+                    const scene_rdl2::math::Mat4f &c2w,
+                    const CameraProjection &projection);
+
+    void clearHistory();
+    bool hasHistory() const { return mHasHistory; }
+
+    /// True if the stored frame was seen from c2w, in which case there is
+    /// nothing to reproject. The stored frame is only replaced by setHistory(),
+    /// so a restarted frame keeps being reprojected until it completes.
+    bool hasHistoryFrom(const scene_rdl2::math::Mat4f &c2w) const
+    {
+        return mHasHistory && scene_rdl2::math::isEqual(mHistoryC2w, c2w);
+    }
+
+    /// Bytes held by the stored frame and scratch buffers.
+    size_t getMemoryUsage() const;
+
+    /// Clears the history and frees the buffers, which are allocated again
+    /// by the next frame set or reprojected.
+    void release();
+
+    /// Warps the stored frame into the view c2w and blends beauty over it,
+    /// favouring beauty as weights (its per pixel sample counts) grow. Call it
+    /// on every update of a restarted frame so new samples keep replacing the
+    /// warped ones. If the camera has moved on since the previous call, that
+    /// call's result (still held in dst) becomes the stored frame first, so
+    /// continuous navigation keeps building on what was last shown.
+    /// Returns false, leaving dst untouched, if there is nothing to reproject.
+    bool reproject(const scene_rdl2::fb_util::RenderBuffer &beauty,
+                   const scene_rdl2::fb_util::FloatBuffer &depth,
+                   const scene_rdl2::fb_util::FloatBuffer &weights,
+                   const scene_rdl2::math::Mat4f &c2w,
+                   const CameraProjection &projection,
+                   scene_rdl2::fb_util::RenderBuffer *dst,
+                   bool parallel);
+
+private:
+    void splat(const scene_rdl2::math::Mat4f &c2w, const CameraProjection &projection, bool parallel);
+
+    bool mHasHistory;
+    scene_rdl2::fb_util::RenderBuffer mHistoryBeauty;
+    scene_rdl2::fb_util::FloatBuffer  mHistoryDepth;
+    scene_rdl2::math::Mat4f           mHistoryC2w;
+    CameraProjection                  mHistoryProjection;
+
+    /// Per pixel depth test for the forward splat: the new view depth in the
+    /// high 32 bits and the source pixel index in the low 32 bits, so an
+    /// atomic min keeps the closest source pixel.
+    std::unique_ptr<std::atomic<uint64_t>[]> mSplatKeys;
+    size_t mSplatKeyCount;
+
+    /// The splat only depends on the stored frame and the new view, so it is
+    /// reused across the updates of a restarted frame.
+    bool                    mHasSplat;
+    scene_rdl2::math::Mat4f mSplatC2w;
+
+    /// Depth and view of the last result written to dst.
+    bool                             mHasBlended;
+    scene_rdl2::fb_util::FloatBuffer mBlendedDepth;
+    scene_rdl2::math::Mat4f          mBlendedC2w;
+    CameraProjection                 mBlendedProjection;
+};
+
+} // namespace moonray_gui
+
@@ -0,0 +1,176 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+/// @file SessionRecording.cc
+
+#include "SessionRecording.h"
+
+#include <scene_rdl2/common/math/MathUtil.h>
+#include <scene_rdl2/render/logging/logging.h>
+
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+
+namespace moonray_gui {
+
+using scene_rdl2::math::Mat4f;
+
+namespace {
+
+const char *sHeader = "moonray_gui session 1";
+
+void
+writeMatrix(std::ostream &os, const Mat4f &m)
+{
+    const float *values = &m.vx.x;
+    for (int i = 0; i < 16; ++i) {
+        os << ' ' << values[i];
+    }
+}
+
+bool
+readMatrix(std::istream &is, Mat4f *m)
+{
+    float *values = &m->vx.x;
+    for (int i = 0; i < 16; ++i) {
+        if (!(is >> values[i])) return false;
+    }
+    return true;
+}
+
+}
+
+bool
+SessionSettings::operator==(const SessionSettings &other) const
+{
+    return mDebugMode == other.mDebugMode &&
+           mRenderOutputIndx == other.mRenderOutputIndx &&
+           mDenoise == other.mDenoise &&
+           mDenoiserMode == other.mDenoiserMode &&
+           mDenoisingBufferMode == other.mDenoisingBufferMode &&
+           mProgressiveFast == other.mProgressiveFast &&
+           mFastMode == other.mFastMode &&
+           mExposure == other.mExposure &&
+           mGamma == other.mGamma;
+}
+
+bool
+SessionRecorder::open(const std::string &path)
+{
+    mFile.open(path);
+    if (!mFile) {
+        scene_rdl2::logging::Logger::error("Unable to write session recording ", path);
+        return false;
+    }
+
+    // Enough digits for every float to read back as the same value.
+    mFile << std::setprecision(std::numeric_limits<float>::max_digits10);
+    mFile << sHeader << '\n';
+    mHasLast = false;
+    std::cout << "Recording session to " << path << std::endl;
+    return true;
+}
+
+void
+SessionRecorder::record(double time, const Mat4f &xform, const SessionSettings &settings)
+{
+    if (!mFile.is_open()) return;
+
+    if (!mHasLast || !scene_rdl2::math::isEqual(xform, mLastXform)) {
+        mFile << time << " camera";
+        writeMatrix(mFile, xform);
+        mFile << '\n';
+    }
+    if (!mHasLast || settings != mLastSettings) {
+        mFile << time << " settings "
+              << int(settings.mDebugMode) << ' '
+              << settings.mRenderOutputIndx << ' '
+              << int(settings.mDenoise) << ' '
+              << int(settings.mDenoiserMode) << ' '
+              << int(settings.mDenoisingBufferMode) << ' '
+              << int(settings.mProgressiveFast) << ' '
+              << int(settings.mFastMode) << ' '
+              << settings.mExposure << ' '
+              << settings.mGamma << '\n';
+    }
+
+    mHasLast = true;
+    mLastXform = xform;
+    mLastSettings = settings;
+}
+
+bool
+SessionPlayer::load(const std::string &path)
+{
+    std::ifstream file(path);
+    std::string line;
+    if (!file || !std::getline(file, line) || line != sHeader) {
+        scene_rdl2::logging::Logger::error("Unable to read session recording ", path);
+        return false;
+    }
+
+    mEvents.clear();
+    mNext = 0;
+    int lineNumber = 1;
+    while (std::getline(file, line)) {
+        ++lineNumber;
+        if (line.empty()) continue;
+
+        std::istringstream is(line);
+        Event event;
+        std::string kind;
+        bool ok = bool(is >> event.mTime >> kind);
+        if (ok && kind == "camera") {
+            event.mIsCamera = true;
+            ok = readMatrix(is, &event.mXform);
+        } else if (ok && kind == "settings") {
+            event.mIsCamera = false;
+            int debugMode, denoise, denoiserMode, bufferMode, progressiveFast, fastMode;
+            SessionSettings &s = event.mSettings;
+            ok = bool(is >> debugMode >> s.mRenderOutputIndx >> denoise >> denoiserMode >> bufferMode
+                         >> progressiveFast >> fastMode >> s.mExposure >> s.mGamma);
+            s.mDebugMode = DebugMode(debugMode);
+            s.mDenoise = denoise != 0;
+            s.mDenoiserMode = moonray::denoiser::DenoiserMode(denoiserMode);
+            s.mDenoisingBufferMode = DenoisingBufferMode(bufferMode);
+            s.mProgressiveFast = progressiveFast != 0;
+            s.mFastMode = moonray::rndr::FastRenderMode(fastMode);
+        } else {
+            ok = false;
+        }
+
+        if (!ok) {
+            scene_rdl2::logging::Logger::error("Malformed line ", lineNumber, " in session recording ", path);
+            mEvents.clear();
+            return false;
+        }
+        mEvents.push_back(event);
+    }
+
+    std::cout << "Replaying " << mEvents.size() << " changes over " << getDuration()
+              << " seconds from " << path << std::endl;
+    return true;
+}
+
+void
+SessionPlayer::update(double time, Mat4f *xform, bool *xformChanged,
+                      SessionSettings *settings, bool *settingsChanged)
+{
+    *xformChanged = false;
+    *settingsChanged = false;
+    for (; mNext < mEvents.size() && mEvents[mNext].mTime <= time; ++mNext) {
+        const Event &event = mEvents[mNext];
+        if (event.mIsCamera) {
+            *xform = event.mXform;
+            *xformChanged = true;
+        } else {
+            *settings = event.mSettings;
+            *settingsChanged = true;
+        }
+    }
+}
+
+} // namespace moonray_gui
+
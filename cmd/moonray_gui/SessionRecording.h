@@ -0,0 +1,95 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+/// @file SessionRecording.h
+
+#pragma once
+
+#include "GuiTypes.h"
+
+#include <mcrt_denoise/denoiser/Denoiser.h>
+#include <moonray/rendering/rndr/rndr.h>
+#include <scene_rdl2/common/math/Mat4.h>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace moonray_gui {
+
+/// The viewport settings which change what is rendered or displayed.
+struct SessionSettings
+{
+    DebugMode mDebugMode = RGB;
+    int mRenderOutputIndx = 0;
+    bool mDenoise = false;
+    moonray::denoiser::DenoiserMode mDenoiserMode = moonray::denoiser::OPTIX;
+    DenoisingBufferMode mDenoisingBufferMode = DN_BUFFERS_BEAUTY;
+    bool mProgressiveFast = false;
+    moonray::rndr::FastRenderMode mFastMode = moonray::rndr::FastRenderMode::NORMALS;
+    float mExposure = 0.f;
+    float mGamma = 1.f;
+
+    bool operator==(const SessionSettings &other) const;
+    bool operator!=(const SessionSettings &other) const { return !(*this == other); }
+};
+
+/**
+ * Writes the navigation camera transform and viewport settings to a text
+ * file as they change, each with the time in seconds since recording
+ * started, for SessionPlayer to drive the GUI with later.
+ */
+class SessionRecorder
+{
+public:
+    /// Returns false if path can't be written to.
+    bool open(const std::string &path);
+    bool isOpen() const { return mFile.is_open(); }
+
+    /// Records whichever of xform and settings differ from the last call.
+    void record(double time, const scene_rdl2::math::Mat4f &xform, const SessionSettings &settings);
+
+private:
+    std::ofstream mFile;
+    bool mHasLast = false;
+    scene_rdl2::math::Mat4f mLastXform;
+    SessionSettings mLastSettings;
+};
+
+/**
+ * Replays a file written by SessionRecorder, handing back the camera
+ * transform and settings in effect at each point of the recording. The
+ * transforms are written with enough precision to come back exactly, so
+ * replays of the same file render the same camera path.
+ */
+class SessionPlayer
+{
+public:
+    /// Returns false if path can't be read or isn't a session recording.
+    bool load(const std::string &path);
+
+    /// Moves on to time, setting xform and settings to any which changed
+    /// since the last call and flagging which did.
+    void update(double time, scene_rdl2::math::Mat4f *xform, bool *xformChanged,
+                SessionSettings *settings, bool *settingsChanged);
+
+    /// True once time has passed the last recorded change.
+    bool isFinished() const { return mNext >= mEvents.size(); }
+
+    double getDuration() const { return mEvents.empty() ? 0.0 : mEvents.back().mTime; }
+
+private:
+    struct Event
+    {
+        double mTime;
+        bool mIsCamera;
+        scene_rdl2::math::Mat4f mXform;
+        SessionSettings mSettings;
+    };
+
+    std::vector<Event> mEvents;
+    size_t mNext = 0;
+};
+
+} // namespace moonray_gui
+
@@ -0,0 +1,132 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+/// @file SharedFrameWriter.cc
+
+#include "SharedFrameWriter.h"
+
+#include <scene_rdl2/render/logging/logging.h>
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <new>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// Extra room given to a segment when it grows, so a frame which changes
+// size slightly doesn't move the segment every time.
+#define SHARED_FRAME_GROWTH     1.25
+
+namespace moonray_gui {
+
+SharedFrameWriter::SharedFrameWriter() :
+    mHeader(nullptr),
+    mMappedSize(0)
+{
+}
+
+SharedFrameWriter::~SharedFrameWriter()
+{
+    close();
+}
+
+bool
+SharedFrameWriter::open(const std::string &name)
+{
+    close();
+    mName = name;
+    if (!create(0)) {
+        return false;
+    }
+    std::cout << "Publishing frames to shared memory " << mName << std::endl;
+    return true;
+}
+
+void
+SharedFrameWriter::close()
+{
+    if (mHeader) {
+        mHeader->mRetired.store(1, std::memory_order_release);
+        unmap();
+        shm_unlink(mName.c_str());
+    }
+}
+
+bool
+SharedFrameWriter::create(size_t capacity)
+{
+    // Anything still here was left by an earlier run which didn't exit
+    // cleanly. Readers still mapping it keep it alive until they reopen.
+    shm_unlink(mName.c_str());
+    const int fd = shm_open(mName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0) {
+        scene_rdl2::logging::Logger::error("Unable to create shared memory ", mName, ": ", std::strerror(errno));
+        return false;
+    }
+    const size_t size = sizeof(SharedFrameHeader) + capacity;
+    void *data = MAP_FAILED;
+    if (ftruncate(fd, off_t(size)) == 0) {
+        data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        scene_rdl2::logging::Logger::error("Unable to map shared memory ", mName, ": ", std::strerror(errno));
+        shm_unlink(mName.c_str());
+        return false;
+    }
+
+    // The segment comes zero filled, so there is no frame until the first
+    // write.
+    mHeader = new (data) SharedFrameHeader;
+    mHeader->mMagic = SHARED_FRAME_MAGIC;
+    mHeader->mVersion = SHARED_FRAME_VERSION;
+    mHeader->mHeaderSize = sizeof(SharedFrameHeader);
+    mHeader->mCapacity = capacity;
+    mMappedSize = size;
+    return true;
+}
+
+void
+SharedFrameWriter::unmap()
+{
+    munmap(mHeader, mMappedSize);
+    mHeader = nullptr;
+    mMappedSize = 0;
+}
+
+uint8_t *
+SharedFrameWriter::beginWrite(size_t size)
+{
+    if (!mHeader) return nullptr;
+
+    if (size > mHeader->mCapacity) {
+        // Readers notice the old segment is retired and open the new one.
+        mHeader->mRetired.store(1, std::memory_order_release);
+        unmap();
+        if (!create(size_t(size * SHARED_FRAME_GROWTH))) {
+            return nullptr;
+        }
+    }
+
+    const uint64_t sequence = mHeader->mSequence.load(std::memory_order_relaxed);
+    mHeader->mSequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    return reinterpret_cast<uint8_t *>(mHeader) + sizeof(SharedFrameHeader);
+}
+
+void
+SharedFrameWriter::endWrite(uint64_t frameNumber, unsigned width, unsigned height, unsigned channels,
+                            SharedFrameHeader::Format format)
+{
+    mHeader->mFrameNumber = frameNumber;
+    mHeader->mWidth = width;
+    mHeader->mHeight = height;
+    mHeader->mChannels = channels;
+    mHeader->mFormat = format;
+    mHeader->mSequence.store(mHeader->mSequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+} // namespace moonray_gui
@@ -0,0 +1,140 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+/// @file SharedFrameWriter.h
+
+#pragma once
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace moonray_gui {
+
+/**
+ * Layout of the start of a shared frame segment, which other programs map
+ * read only to look at the frame in place. The pixels follow the header,
+ * rows from the top, channels interleaved, with no padding between rows.
+ *
+ * mSequence is a seqlock: it is odd while the frame is being written. To
+ * read a frame, load mSequence, wait for it to be even, read what is needed,
+ * then load it again; if it changed the frame was overwritten while being
+ * read and should be read again.
+ *
+ * A frame larger than the segment moves to a new segment under the same
+ * name. The old one is marked retired first, after which readers should
+ * unmap it and open the name again.
+ */
+struct alignas(64) SharedFrameHeader
+{
+    enum Format : uint32_t
+    {
+        FLOAT32,
+        UINT8,
+    };
+
+    uint32_t mMagic;                    // SHARED_FRAME_MAGIC
+    uint32_t mVersion;                  // SHARED_FRAME_VERSION
+    std::atomic<uint32_t> mRetired;
+    uint32_t mHeaderSize;               // offset of the pixels
+    uint64_t mCapacity;                 // bytes available for the pixels
+    std::atomic<uint64_t> mSequence;
+
+    // Valid while mSequence is even and unchanged.
+    uint64_t mFrameNumber;              // same for the linear and display frame of a frame
+    uint32_t mWidth;
+    uint32_t mHeight;
+    uint32_t mChannels;
+    Format mFormat;
+};
+
+#define SHARED_FRAME_MAGIC      0x4d475348 // "MGSH"
+#define SHARED_FRAME_VERSION    1
+
+/**
+ * Publishes frames into a named POSIX shared memory segment for other
+ * programs on the machine to read without copying, or writing to disk.
+ * Only one thread may write to a segment.
+ */
+class SharedFrameWriter
+{
+public:
+    SharedFrameWriter();
+    ~SharedFrameWriter();
+
+    /// Creates the segment, replacing any left behind by an earlier run.
+    /// name is used as the shared memory name, which starts with a '/'.
+    /// Returns false on failure.
+    bool open(const std::string &name);
+    void close();
+
+    bool isOpen() const { return mHeader != nullptr; }
+
+    /// Writes a width x height frame of channels per pixel. getRow(y) returns
+    /// row y, counted from the top, which is copied as is. Rows are copied in
+    /// parallel if parallel is set.
+    template <typename GetRow>
+    void write(uint64_t frameNumber, unsigned width, unsigned height, unsigned channels,
+               SharedFrameHeader::Format format, bool parallel, const GetRow &getRow);
+
+    /// Like write, but fillRow(y, dst) writes row y to dst itself, for frames
+    /// which are converted on the way in.
+    template <typename FillRow>
+    void writeRows(uint64_t frameNumber, unsigned width, unsigned height, unsigned channels,
+                   SharedFrameHeader::Format format, bool parallel, const FillRow &fillRow);
+
+private:
+    /// Makes room for size bytes of pixels, moving to a new segment if
+    /// needed, and starts a write. Returns the pixels, or null on failure.
+    uint8_t *beginWrite(size_t size);
+    void endWrite(uint64_t frameNumber, unsigned width, unsigned height, unsigned channels,
+                  SharedFrameHeader::Format format);
+
+    bool create(size_t capacity);
+    void unmap();
+
+    std::string mName;
+    SharedFrameHeader *mHeader;
+    size_t mMappedSize;
+};
+
+template <typename GetRow>
+void
+SharedFrameWriter::write(uint64_t frameNumber, unsigned width, unsigned height, unsigned channels,
+                         SharedFrameHeader::Format format, bool parallel, const GetRow &getRow)
+{
+    const size_t rowSize = size_t(width) * channels * (format == SharedFrameHeader::FLOAT32 ? 4 : 1);
+    writeRows(frameNumber, width, height, channels, format, parallel, [&](unsigned y, uint8_t *dst) {
+        std::copy_n(reinterpret_cast<const uint8_t *>(getRow(y)), rowSize, dst);
+    });
+}
+
+template <typename FillRow>
+void
+SharedFrameWriter::writeRows(uint64_t frameNumber, unsigned width, unsigned height, unsigned channels,
+                             SharedFrameHeader::Format format, bool parallel, const FillRow &fillRow)
+{
+    const size_t rowSize = size_t(width) * channels * (format == SharedFrameHeader::FLOAT32 ? 4 : 1);
+    uint8_t *pixels = beginWrite(rowSize * height);
+    if (!pixels) return;
+    if (parallel) {
+        tbb::parallel_for(tbb::blocked_range<unsigned>(0, height), [&](const tbb::blocked_range<unsigned> &range) {
+            for (unsigned y = range.begin(); y != range.end(); ++y) {
+                fillRow(y, pixels + rowSize * y);
+            }
+        });
+    } else {
+        for (unsigned y = 0; y < height; ++y) {
+            fillRow(y, pixels + rowSize * y);
+        }
+    }
+    endWrite(frameNumber, width, height, channels, format);
+}
+
+} // namespace moonray_gui
+
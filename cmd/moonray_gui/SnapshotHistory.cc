@@ -0,0 +1,146 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+/// @file SnapshotHistory.cc
+
+#include "SnapshotHistory.h"
+
+#include <algorithm>
+
+namespace moonray_gui {
+
+// zlib level used for history frames. The lowest level is several times
+// faster than the default for a modest loss of ratio, which matters more here
+// since frames are often pushed in quick succession.
+#define SNAPSHOT_HISTORY_COMPRESSION_LEVEL  1
+
+SnapshotHistory::SnapshotHistory(size_t budgetBytes) :
+    mBudgetBytes(budgetBytes),
+    mUsedBytes(0),
+    mStop(false)
+{
+    mWorker = std::thread(&SnapshotHistory::workerLoop, this);
+}
+
+SnapshotHistory::~SnapshotHistory()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStop = true;
+    }
+    mCondition.notify_one();
+    mWorker.join();
+}
+
+void
+SnapshotHistory::push(const scene_rdl2::fb_util::RenderBuffer &linear, const QImage &display, const QString &label)
+{
+    auto entry = std::make_shared<Entry>();
+    entry->mLabel = label;
+    entry->mWidth = linear.getWidth();
+    entry->mHeight = linear.getHeight();
+    entry->mLinear = QByteArray(reinterpret_cast<const char *>(linear.getData()),
+                                int(linear.getArea() * sizeof(scene_rdl2::fb_util::RenderColor)));
+    entry->mDisplayFormat = display.format();
+    entry->mDisplayWidth = display.width();
+    entry->mDisplayHeight = display.height();
+    entry->mDisplayBytesPerLine = display.bytesPerLine();
+    entry->mDisplay = QByteArray(reinterpret_cast<const char *>(display.constBits()),
+                                 display.bytesPerLine() * display.height());
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mEntries.push_front(entry);
+        mPending.push_back(entry);
+        mUsedBytes += entry->getSize();
+        evict();
+    }
+    mCondition.notify_one();
+}
+
+size_t
+SnapshotHistory::size() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mEntries.size();
+}
+
+size_t
+SnapshotHistory::getMemoryUsage() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mUsedBytes;
+}
+
+bool
+SnapshotHistory::get(size_t index, QImage *display, scene_rdl2::fb_util::RenderBuffer *linear,
+                     QString *label) const
+{
+    std::shared_ptr<const Entry> entry;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (index >= mEntries.size()) {
+            return false;
+        }
+        entry = mEntries[index];
+    }
+
+    const QByteArray displayBytes = entry->mCompressed ? qUncompress(entry->mDisplay) : entry->mDisplay;
+    *display = QImage(reinterpret_cast<const uchar *>(displayBytes.constData()),
+                      entry->mDisplayWidth, entry->mDisplayHeight, entry->mDisplayBytesPerLine,
+                      entry->mDisplayFormat).copy();
+
+    if (linear) {
+        const QByteArray linearBytes = entry->mCompressed ? qUncompress(entry->mLinear) : entry->mLinear;
+        linear->init(entry->mWidth, entry->mHeight);
+        const auto *pixels = reinterpret_cast<const scene_rdl2::fb_util::RenderColor *>(linearBytes.constData());
+        std::copy(pixels, pixels + linear->getArea(), linear->getData());
+    }
+
+    if (label) {
+        *label = entry->mLabel;
+    }
+    return true;
+}
+
+void
+SnapshotHistory::evict()
+{
+    // Always keep the newest frame, even if it alone is over budget.
+    while (mUsedBytes > mBudgetBytes && mEntries.size() > 1) {
+        mUsedBytes -= mEntries.back()->getSize();
+        mEntries.pop_back();
+    }
+}
+
+void
+SnapshotHistory::workerLoop()
+{
+    while (true) {
+        std::shared_ptr<const Entry> entry;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCondition.wait(lock, [this] { return mStop || !mPending.empty(); });
+            if (mStop) {
+                return;
+            }
+            entry = std::move(mPending.front());
+            mPending.pop_front();
+        }
+
+        auto compressed = std::make_shared<Entry>(*entry);
+        compressed->mLinear = qCompress(entry->mLinear, SNAPSHOT_HISTORY_COMPRESSION_LEVEL);
+        compressed->mDisplay = qCompress(entry->mDisplay, SNAPSHOT_HISTORY_COMPRESSION_LEVEL);
+        compressed->mCompressed = true;
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto it = std::find(mEntries.begin(), mEntries.end(), entry);
+        if (it != mEntries.end()) {
+            mUsedBytes = mUsedBytes - entry->getSize() + compressed->getSize();
+            *it = std::move(compressed);
+        }
+    }
+}
+
+} // namespace moonray_gui
+
@@ -0,0 +1,82 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+/// @file SnapshotHistory.h
+
+#pragma once
+
+#include <scene_rdl2/common/fb_util/FbTypes.h>
+
+#include <QByteArray>
+#include <QImage>
+#include <QString>
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace moonray_gui {
+
+/**
+ * A memory budgeted ring of recent frames kept for comparing against the live
+ * render. Each frame is stored both linear and as displayed, and compressed
+ * on a background thread once pushed. The oldest frames are dropped whenever
+ * the total size goes over budget.
+ */
+class SnapshotHistory
+{
+public:
+    explicit SnapshotHistory(size_t budgetBytes);
+    ~SnapshotHistory();
+
+    /// Adds a frame as the newest entry.
+    void push(const scene_rdl2::fb_util::RenderBuffer &linear, const QImage &display, const QString &label);
+
+    /// Number of frames held. Index 0 is the newest.
+    size_t size() const;
+
+    /// Decompresses frame index into display and, if not null, linear.
+    /// Returns false if there is no such frame.
+    bool get(size_t index, QImage *display, scene_rdl2::fb_util::RenderBuffer *linear,
+             QString *label) const;
+
+    /// Combined size of all the frames held, compressed or not.
+    size_t getMemoryUsage() const;
+
+private:
+    /// Entries are never modified once shared, compression swaps in a new
+    /// one, so readers can use them without holding the lock.
+    struct Entry
+    {
+        QString mLabel;
+        unsigned mWidth = 0;
+        unsigned mHeight = 0;
+        QByteArray mLinear;
+        QImage::Format mDisplayFormat = QImage::Format_Invalid;
+        int mDisplayWidth = 0;
+        int mDisplayHeight = 0;
+        int mDisplayBytesPerLine = 0;
+        QByteArray mDisplay;
+        bool mCompressed = false;
+
+        size_t getSize() const { return size_t(mLinear.size()) + size_t(mDisplay.size()); }
+    };
+
+    void evict();
+    void workerLoop();
+
+    size_t mBudgetBytes;
+    size_t mUsedBytes;
+    std::deque<std::shared_ptr<const Entry>> mEntries;
+    std::deque<std::shared_ptr<const Entry>> mPending;
+
+    mutable std::mutex mMutex;
+    std::condition_variable mCondition;
+    bool mStop;
+    std::thread mWorker;
+};
+
+} // namespace moonray_gui
+
@@ -0,0 +1,145 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+/// @file SnapshotWriter.cc
+
+#include "SnapshotWriter.h"
+#include "ExrWriteScope.h"
+
+#include <moonray/rendering/rndr/rndr.h>
+#include <scene_rdl2/render/logging/logging.h>
+
+#include <QCoreApplication>
+#include <QObject>
+
+#include <exception>
+#include <iostream>
+
+namespace moonray_gui {
+
+// Finished buffers kept around for reuse.
+#define SNAPSHOT_BUFFER_POOL_SIZE   2
+
+QEvent::Type SnapshotWrittenEvent::sEventType =
+        static_cast<QEvent::Type>(QEvent::registerEventType());
+
+SnapshotWriter::SnapshotWriter(QObject *receiver) :
+    mReceiver(receiver),
+    mBusy(false),
+    mStop(false)
+{
+    mWorker = std::thread(&SnapshotWriter::workerLoop, this);
+}
+
+SnapshotWriter::~SnapshotWriter()
+{
+    // Don't drop snapshots the user asked for.
+    waitForIdle();
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStop = true;
+    }
+    mCondition.notify_one();
+    mWorker.join();
+}
+
+std::unique_ptr<scene_rdl2::fb_util::RenderBuffer>
+SnapshotWriter::acquireBuffer()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mFreeBuffers.empty()) {
+        return std::make_unique<scene_rdl2::fb_util::RenderBuffer>();
+    }
+    std::unique_ptr<scene_rdl2::fb_util::RenderBuffer> buffer = std::move(mFreeBuffers.back());
+    mFreeBuffers.pop_back();
+    return buffer;
+}
+
+void
+SnapshotWriter::submit(SnapshotRequest &&request)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mQueue.push_back(std::move(request));
+    }
+    mCondition.notify_one();
+}
+
+void
+SnapshotWriter::waitForIdle()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    mIdleCondition.wait(lock, [this] { return mQueue.empty() && !mBusy; });
+}
+
+bool
+SnapshotWriter::write(const SnapshotRequest &request, QString *message)
+{
+    try {
+        ExrWriteScope exr;
+        moonray::rndr::writePixelBuffer(*request.mBuffer, request.mPath, request.mMetadata,
+                                        request.mAperture, request.mRegion);
+    } catch (const std::exception &e) {
+        scene_rdl2::logging::Logger::error("Failed to write out ", request.mPath, ": ", e.what());
+        *message = QString("Failed to write ") + QString::fromStdString(request.mPath);
+        return false;
+    } catch (...) {
+        scene_rdl2::logging::Logger::error("Failed to write out ", request.mPath);
+        *message = QString("Failed to write ") + QString::fromStdString(request.mPath);
+        return false;
+    }
+    *message = QString("Saved ") + QString::fromStdString(request.mPath);
+
+    if (!request.mDisplayImage.isNull()) {
+        std::string pngPath = request.mPath;
+        const size_t dot = pngPath.rfind('.');
+        pngPath = (dot == std::string::npos ? pngPath : pngPath.substr(0, dot)) + ".png";
+        if (request.mDisplayImage.save(QString::fromStdString(pngPath), "PNG")) {
+            *message += QString("\nSaved ") + QString::fromStdString(pngPath);
+        } else {
+            scene_rdl2::logging::Logger::error("Failed to write out ", pngPath);
+            *message += QString("\nFailed to write ") + QString::fromStdString(pngPath);
+            return false;
+        }
+    }
+    return true;
+}
+
+void
+SnapshotWriter::workerLoop()
+{
+    while (true) {
+        SnapshotRequest request;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCondition.wait(lock, [this] { return mStop || !mQueue.empty(); });
+            if (mStop) {
+                return;
+            }
+            request = std::move(mQueue.front());
+            mQueue.pop_front();
+            mBusy = true;
+        }
+
+        QString message;
+        const bool success = write(request, &message);
+        std::cout << message.toStdString() << std::endl;
+
+        // QCoreApplication::postEvent() is thread-safe and takes ownership.
+        if (mReceiver) {
+            QCoreApplication::postEvent(mReceiver, new SnapshotWrittenEvent(message, request.mIndex, success));
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (mFreeBuffers.size() < SNAPSHOT_BUFFER_POOL_SIZE) {
+                mFreeBuffers.push_back(std::move(request.mBuffer));
+            }
+            mBusy = false;
+        }
+        mIdleCondition.notify_all();
+    }
+}
+
+} // namespace moonray_gui
+
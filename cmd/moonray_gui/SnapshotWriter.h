@@ -0,0 +1,105 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+/// @file SnapshotWriter.h
+
+#pragma once
+
+#include <scene_rdl2/common/fb_util/FbTypes.h>
+#include <scene_rdl2/common/math/Viewport.h>
+#include <scene_rdl2/scene/rdl2/SceneObject.h>
+
+#include <QEvent>
+#include <QImage>
+#include <QString>
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class QObject;
+
+namespace moonray_gui {
+
+/// Posted to the receiver of a SnapshotWriter whenever a snapshot is written.
+class SnapshotWrittenEvent : public QEvent
+{
+public:
+    SnapshotWrittenEvent(const QString &message, int index, bool success) :
+        QEvent(SnapshotWrittenEvent::type()),
+        mMessage(message),
+        mIndex(index),
+        mSuccess(success)
+    {
+    }
+
+    const QString &getMessage() const { return mMessage; }
+    int getIndex() const { return mIndex; }
+    bool getSuccess() const { return mSuccess; }
+    static QEvent::Type type() { return sEventType; }
+
+private:
+    QString mMessage;
+    int mIndex;
+    bool mSuccess;
+    static QEvent::Type sEventType;
+};
+
+struct SnapshotRequest
+{
+    std::unique_ptr<scene_rdl2::fb_util::RenderBuffer> mBuffer;
+    std::string mPath;
+    int mIndex = 0; // passed back in the SnapshotWrittenEvent
+    const scene_rdl2::rdl2::SceneObject *mMetadata = nullptr;
+    scene_rdl2::math::HalfOpenViewport mAperture;
+    scene_rdl2::math::HalfOpenViewport mRegion;
+
+    /// If not null, also written as an 8-bit PNG next to the EXR.
+    QImage mDisplayImage;
+};
+
+/**
+ * Writes snapshots on a background thread so that encoding and writing large
+ * EXRs doesn't freeze the UI. Buffers are recycled between snapshots.
+ */
+class SnapshotWriter
+{
+public:
+    /// receiver is sent a SnapshotWrittenEvent as each snapshot completes.
+    explicit SnapshotWriter(QObject *receiver);
+    ~SnapshotWriter();
+
+    /// Returns a buffer to snapshot into, reusing one from a finished write
+    /// if possible.
+    std::unique_ptr<scene_rdl2::fb_util::RenderBuffer> acquireBuffer();
+
+    void submit(SnapshotRequest &&request);
+
+    /// Blocks until all submitted snapshots have been written. The metadata
+    /// of a request points into the scene, so this must be called before the
+    /// scene is modified or destroyed.
+    void waitForIdle();
+
+private:
+    void workerLoop();
+    bool write(const SnapshotRequest &request, QString *message);
+
+    QObject *mReceiver;
+
+    std::deque<SnapshotRequest> mQueue;
+    std::vector<std::unique_ptr<scene_rdl2::fb_util::RenderBuffer>> mFreeBuffers;
+    bool mBusy;
+
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    std::condition_variable mIdleCondition;
+    bool mStop;
+    std::thread mWorker;
+};
+
+} // namespace moonray_gui
+
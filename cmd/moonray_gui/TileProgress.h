@@ -0,0 +1,46 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+/// @file TileProgress.h
+
+#pragma once
+
+#include <vector>
+
+namespace moonray_gui {
+
+// Moonray renders in 8x8 pixel tiles aligned to the buffer origin.
+#define TILE_PROGRESS_TILE_SIZE     8
+
+/**
+ * When each tile was last rendered to, for drawing tile outlines over the
+ * displayed frame. Outlines start at mIntensity and fade out over mFadeTime
+ * seconds, and are drawn at display time so the frame itself is untouched.
+ */
+struct TileProgress
+{
+    unsigned mTilesX = 0;
+    unsigned mTilesY = 0;
+
+    /// Time each tile was last rendered to, row by row from the bottom, or a
+    /// large negative number if it hasn't been.
+    std::vector<float> mTileTimes;
+
+    /// Current time on the same clock as mTileTimes.
+    float mTime = 0.f;
+    float mFadeTime = 0.f;
+    float mIntensity = 0.f;
+
+    /// Amount to add to the outline of tile (tx, ty), 0 if none.
+    float getOutline(unsigned tx, unsigned ty) const
+    {
+        const float age = mTime - mTileTimes[ty * mTilesX + tx];
+        if (age <= 0.f) return mIntensity;
+        if (age >= mFadeTime) return 0.f;
+        // Tiles no longer being rendered drop to a dimmer outline first.
+        return mIntensity * 0.6f * (1.f - age / mFadeTime);
+    }
+};
+
+} // namespace moonray_gui
+
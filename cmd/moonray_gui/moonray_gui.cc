@@ -1,6 +1,9 @@
 // Copyright 2023-2024 DreamWorks Animation LLC
 // SPDX-License-Identifier: Apache-2.0
 
+#include "CheckpointWriter.h"
+#include "FrameStream.h"
+#include "OutputWriter.h"
 #include "RenderGui.h"
 
 #include <moonray/application/ChangeWatcher.h>
@@ -10,19 +13,57 @@
 #include <scene_rdl2/render/util/Strings.h>
 #include <scene_rdl2/scene/rdl2/Camera.h>
 
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <csignal>
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <fstream>
 #include <memory>
 #include <set>
+#include <stdexcept>
 #include <map>
 
 #include <boost/regex.hpp>
 #include <QtGui>
 #include <QApplication>
 
+// Seconds between frames published by a render server, and between attempts
+// by a viewer to attach to one which isn't running.
+#define STREAM_PUBLISH_INTERVAL         0.05
+#define STREAM_ATTACH_RETRY_INTERVAL    1.0
+
 namespace moonray_gui {
 
+namespace {
+
+// Set by SIGINT and SIGTERM to shut a render server down cleanly, which
+// removes its shared memory and socket.
+volatile std::sig_atomic_t sStreamServerStop = 0;
+
+void
+stopStreamServer(int)
+{
+    sStreamServerStop = 1;
+}
+
+// Reads the non-negative number given to flag, or throws a usage error.
+double
+parseNonNegative(const char *flag, const std::string &value)
+{
+    char *end = nullptr;
+    errno = 0;
+    const double result = std::strtod(value.c_str(), &end);
+    if (value.empty() || *end != '\0' || errno == ERANGE || !std::isfinite(result) || result < 0.0) {
+        throw std::runtime_error(std::string(flag) + " expects a non-negative number, got \"" + value + "\"");
+    }
+    return result;
+}
+
+}
+
 class RaasGuiApplication : public moonray::RaasApplication
 {
 public:
@@ -36,6 +77,13 @@ protected:
 private:
     
     static void* startRenderThread(void* me);
+
+    /// Displays frames from a render server instead of rendering them.
+    static void* startStreamViewerThread(void* me);
+
+    /// Renders without a window, publishing frames for viewers to attach to.
+    void runStreamServer();
+
     // Parses an rdla file and adds references to other
     // rdla files (via the lua language) to the
     // referencedRdlaFiles set.  Recursive.
@@ -50,6 +98,20 @@ private:
     );
 
     CameraType mInitialCamType;
+    double mCheckpointInterval; // seconds, 0 to disable
+    double mTargetFrameTime; // seconds, 0 to disable
+    double mBufferIdleTime; // seconds, 0 to disable
+    bool mPickBuffer;
+    std::string mPickGeometryIdOutput;
+    std::string mPickMaterialIdOutput;
+    std::string mRecordSession;
+    std::string mReplaySession;
+    std::string mConvergenceReference;
+    std::string mConvergenceOutput;
+    double mConvergenceDuration; // seconds per run
+    std::string mStreamServer;
+    std::string mStreamAttach;
+    std::string mFrameServer;
     pthread_t mRenderThread;
     RenderGui* mRenderGui;
     std::exception_ptr mException;
@@ -58,6 +120,12 @@ private:
 RaasGuiApplication::RaasGuiApplication()
     : RaasApplication()
     , mInitialCamType(ORBIT_CAM)
+    , mCheckpointInterval(0.0)
+    , mTargetFrameTime(0.0)
+    , mBufferIdleTime(30.0)
+    , mPickBuffer(false)
+    , mConvergenceOutput("convergence")
+    , mConvergenceDuration(60.0)
     , mRenderThread(0)
     , mRenderGui(nullptr)
     , mException(nullptr)
@@ -69,6 +137,21 @@ RaasGuiApplication::~RaasGuiApplication()
 {
 }
 
+// Removes flag and the numValues arguments following it so that the base
+// application doesn't see them.
+static void
+removeFlag(int &argc, char **argv, const char *flag, int numValues)
+{
+    for (int i = 0; i < argc; ++i) {
+        if (strcmp(argv[i], flag) == 0) {
+            const int count = std::min(numValues + 1, argc - i);
+            std::copy(argv + i + count, argv + argc, argv + i);
+            argc -= count;
+            return;
+        }
+    }
+}
+
 void
 RaasGuiApplication::parseOptions()
 {
@@ -82,6 +165,71 @@ RaasGuiApplication::parseOptions()
         });
         mArgc = static_cast<int>(newLast - mArgv);
     }
+    if (args.getFlagValues("-checkpoint_interval", 1, values) >= 0) {
+        // In minutes, like the checkpoint_interval scene variable.
+        mCheckpointInterval = parseNonNegative("-checkpoint_interval", values[0]) * 60.0;
+        removeFlag(mArgc, mArgv, "-checkpoint_interval", 1);
+    }
+    if (args.getFlagValues("-target_frame_time", 1, values) >= 0) {
+        // In milliseconds.
+        mTargetFrameTime = parseNonNegative("-target_frame_time", values[0]) * 0.001;
+        removeFlag(mArgc, mArgv, "-target_frame_time", 1);
+    }
+    // Seconds a GUI feature may go unused before its buffers are freed.
+    if (args.getFlagValues("-buffer_idle_time", 1, values) >= 0) {
+        mBufferIdleTime = parseNonNegative("-buffer_idle_time", values[0]);
+        removeFlag(mArgc, mArgv, "-buffer_idle_time", 1);
+    }
+    if (args.getFlagValues("-pick_buffer", 0, values) >= 0) {
+        mPickBuffer = true;
+        removeFlag(mArgc, mArgv, "-pick_buffer", 0);
+    }
+    // Render outputs holding geometry and material IDs, which imply -pick_buffer.
+    if (args.getFlagValues("-pick_geometry_id", 1, values) >= 0) {
+        mPickBuffer = true;
+        mPickGeometryIdOutput = values[0];
+        removeFlag(mArgc, mArgv, "-pick_geometry_id", 1);
+    }
+    if (args.getFlagValues("-pick_material_id", 1, values) >= 0) {
+        mPickBuffer = true;
+        mPickMaterialIdOutput = values[0];
+        removeFlag(mArgc, mArgv, "-pick_material_id", 1);
+    }
+    if (args.getFlagValues("-record_session", 1, values) >= 0) {
+        mRecordSession = values[0];
+        removeFlag(mArgc, mArgv, "-record_session", 1);
+    }
+    if (args.getFlagValues("-replay_session", 1, values) >= 0) {
+        mReplaySession = values[0];
+        removeFlag(mArgc, mArgv, "-replay_session", 1);
+    }
+    if (args.getFlagValues("-convergence_reference", 1, values) >= 0) {
+        mConvergenceReference = values[0];
+        removeFlag(mArgc, mArgv, "-convergence_reference", 1);
+    }
+    if (args.getFlagValues("-convergence_output", 1, values) >= 0) {
+        mConvergenceOutput = values[0];
+        removeFlag(mArgc, mArgv, "-convergence_output", 1);
+    }
+    if (args.getFlagValues("-convergence_duration", 1, values) >= 0) {
+        mConvergenceDuration = parseNonNegative("-convergence_duration", values[0]);
+        removeFlag(mArgc, mArgv, "-convergence_duration", 1);
+    }
+    // Split the renderer and the GUI into separate processes, which find each
+    // other by name.
+    if (args.getFlagValues("-stream_server", 1, values) >= 0) {
+        mStreamServer = values[0];
+        removeFlag(mArgc, mArgv, "-stream_server", 1);
+    }
+    if (args.getFlagValues("-stream_attach", 1, values) >= 0) {
+        mStreamAttach = values[0];
+        removeFlag(mArgc, mArgv, "-stream_attach", 1);
+    }
+    // Publish displayed frames to shared memory for other programs to read.
+    if (args.getFlagValues("-frame_server", 1, values) >= 0) {
+        mFrameServer = values[0];
+        removeFlag(mArgc, mArgv, "-frame_server", 1);
+    }
 
     RaasApplication::parseOptions(true);
 }
@@ -181,11 +329,13 @@ RaasGuiApplication::startRenderThread(void* me)
 
     self->logInitMessages();
 
-    scene_rdl2::fb_util::RenderBuffer        outputBuffer;
-    scene_rdl2::fb_util::HeatMapBuffer       heatMapBuffer;
-    scene_rdl2::fb_util::FloatBuffer         weightBuffer;
-    scene_rdl2::fb_util::RenderBuffer        renderBufferOdd;
-    scene_rdl2::fb_util::VariablePixelBuffer renderOutputBuffer;
+    // Writes frame outputs in the background so camera input and file
+    // change handling aren't held up by disk I/O.
+    OutputWriter outputWriter;
+    self->mRenderGui->setOutputWriter(&outputWriter);
+
+    // Writes the frame in progress every mCheckpointInterval seconds.
+    CheckpointWriter checkpointWriter;
 
     try {
         // Create the change watchers if applicable
@@ -298,6 +448,7 @@ RaasGuiApplication::startRenderThread(void* me)
 
             uint32_t prevFrameTimestamp = 0;
             uint32_t frameSavedTimestamp = 0;
+            double nextCheckpointTime = 0.0;
 
             std::set<std::string> changedDeltaFiles;
 
@@ -309,6 +460,10 @@ RaasGuiApplication::startRenderThread(void* me)
                 if (deltasWatcher.hasChanged(&changedDeltaFiles)) {
                     currCameraXform = self->mRenderGui->endInteractiveRendering();
 
+                    // Outputs still being written refer to the scene.
+                    outputWriter.waitForIdle();
+                    checkpointWriter.waitForIdle();
+
                     // Apply the deltas to the scene objects
                     for (const std::string & filename : changedDeltaFiles) {
                         renderContext->updateScene(filename);
@@ -342,12 +497,35 @@ RaasGuiApplication::startRenderThread(void* me)
                 } else {
 
                     bool frameComplete = false;
+                    std::shared_ptr<FrameSnapshot> snapshot;
 
                     if (currFrameTimestamp > prevFrameTimestamp) {
 
                         // We've hit a brand new frame, do any new frame logic here...
                         self->mNextLogProgressTime = 0.0;
                         self->mNextLogProgressPercentage = 0.0;
+                        nextCheckpointTime = util::getSeconds() + self->mCheckpointInterval;
+
+                    } else if (self->mCheckpointInterval > 0.0 &&
+                            frameSavedTimestamp != currFrameTimestamp &&
+                            renderContext->isFrameRendering() &&
+                            !renderContext->isFrameComplete() &&
+                            util::getSeconds() >= nextCheckpointTime) {
+
+                        // Checkpoint the frame in progress. The snapshot runs
+                        // serially on this thread so the render threads carry on
+                        // undisturbed, and the write happens at batch priority.
+                        // If the last checkpoint is still being written, skip
+                        // this one rather than wait.
+                        if (scene_rdl2::fb_util::RenderBuffer *buffer = checkpointWriter.acquire()) {
+                            renderContext->snapshotRenderBuffer(buffer, /*untile*/ true, /*parallel*/ false);
+                            const rdl2::SceneVariables &vars = renderContext->getSceneContext().getSceneVariables();
+                            checkpointWriter.submit(vars.get(rdl2::SceneVariables::sOutputFile),
+                                                    vars.getExrHeaderAttributes(),
+                                                    renderContext->getRezedApertureWindow(),
+                                                    renderContext->getRezedRegionWindow());
+                        }
+                        nextCheckpointTime = util::getSeconds() + self->mCheckpointInterval;
 
                     } else if (currFrameTimestamp == prevFrameTimestamp &&
                             frameSavedTimestamp != currFrameTimestamp &&
@@ -360,14 +538,12 @@ RaasGuiApplication::startRenderThread(void* me)
                         self->printStatusLine(*renderContext, renderContext->getLastFrameMcrtStartTime(), frameComplete);
                         renderContext->stopFrame();
 
-                        // If we're in realtime mode then all rendering should have stopped by this
-                        // point, so use all threads for the snapshot.
-                        bool parallel = renderContext->getRenderMode() == moonray::rndr::RenderMode::REALTIME;
-                        self->mRenderGui->snapshotFrame(&outputBuffer, &heatMapBuffer, &weightBuffer, &renderBufferOdd,
-                                                        &renderOutputBuffer,
-                                                        true, parallel);
-                        self->mRenderGui->updateFrame(&outputBuffer, &renderOutputBuffer,
-                                                      false, parallel);
+                        // Snapshot everything once; the display and the output
+                        // writer share it. Rendering has stopped by this point,
+                        // so use all threads.
+                        snapshot = outputWriter.acquire();
+                        snapshot->capture(*renderContext, /*parallel*/ true);
+                        self->mRenderGui->displaySnapshot(snapshot, /*parallel*/ true);
                     }
 
                     // This effectively caps the max framerate to 200fps.
@@ -380,33 +556,8 @@ RaasGuiApplication::startRenderThread(void* me)
 
                     // Save out file to disk (if not in real-time mode).
                     if (frameComplete) {
-                        // need to snapshot all the required buffers, the
-                        // render buffer might not have been snapshot at all if
-                        // displaying alternate render outputs
-                        renderContext->snapshotRenderBuffer(&outputBuffer, true, true);
-
-                        const std::string outputFilename = renderContext->getSceneContext().getSceneVariables().get(rdl2::SceneVariables::sOutputFile);
-                        const rdl2::SceneObject *metadata = renderContext->getSceneContext().getSceneVariables().getExrHeaderAttributes();
-                        const scene_rdl2::math::HalfOpenViewport aperture = renderContext->getRezedApertureWindow();
-                        const scene_rdl2::math::HalfOpenViewport region = renderContext->getRezedRegionWindow();
-
-                        moonray::writeImageWithMessage(&outputBuffer, outputFilename, metadata, aperture, region);
-
                         // write any arbitrary RenderOutput objects
-                        const moonray::pbr::DeepBuffer *deepBuffer = renderContext->getDeepBuffer();
-                        moonray::pbr::CryptomatteBuffer *cryptomatteBuffer = renderContext->getCryptomatteBuffer();
-                        renderContext->snapshotHeatMapBuffer(&heatMapBuffer, /*untile*/ true, /*parallel*/ true);
-                        renderContext->snapshotWeightBuffer(&weightBuffer, /*untile*/ true, /*parallel*/ true);
-                        std::vector<scene_rdl2::fb_util::VariablePixelBuffer> aovBuffers;
-                        renderContext->snapshotAovBuffers(aovBuffers, /*untile*/ true, /*parallel*/ true);
-                        renderContext->snapshotRenderBufferOdd(&renderBufferOdd, /*untile*/ true, /*parallel*/ true);
-                        std::vector<scene_rdl2::fb_util::VariablePixelBuffer> displayFilterBuffers;
-                        renderContext->snapshotDisplayFilterBuffers(displayFilterBuffers,
-                            /*untile*/ true, /*parallel*/ true);
-                        moonray::writeRenderOutputsWithMessages(renderContext->getRenderOutputDriver(),
-                                                       deepBuffer, cryptomatteBuffer, &heatMapBuffer,
-                                                       &weightBuffer, &renderBufferOdd, aovBuffers,
-                                                       displayFilterBuffers);
+                        outputWriter.submit(std::move(snapshot), *renderContext);
                         frameSavedTimestamp = currFrameTimestamp;
                     }
                 }
@@ -425,6 +576,10 @@ RaasGuiApplication::startRenderThread(void* me)
                 prevFrameTimestamp = currFrameTimestamp;
             }
 
+            // Pending outputs refer to the render context we're about to destroy.
+            outputWriter.waitForIdle();
+            checkpointWriter.waitForIdle();
+
             // not strictly necessary, but just to be thorough:
             self->mRenderGui->setContext(nullptr);
 
@@ -436,14 +591,184 @@ RaasGuiApplication::startRenderThread(void* me)
         }
     }
 
+    self->mRenderGui->setOutputWriter(nullptr);
+
     moonray::rndr::cleanUpGlobalDriver();
 
     return nullptr;
 }
 
+// static method for a thread starting point //
+void*
+RaasGuiApplication::startStreamViewerThread(void* me)
+{
+    RaasGuiApplication* self = static_cast<RaasGuiApplication*>(me);
+
+    try {
+        FrameStreamClient client;
+        bool attachedBefore = false;
+        bool waiting = false;
+        double nextAttachTime = 0.0;
+
+        // The window outlives the render server, keeping the last frame on
+        // screen until a server is attached again.
+        while (self->mRenderGui->isActive()) {
+            if (client.isAttached()) {
+                self->mRenderGui->updateStreamViewing();
+            } else if (util::getSeconds() >= nextAttachTime) {
+                if (client.attach(self->mStreamAttach)) {
+                    self->mRenderGui->beginStreamViewing(&client, client.getCameraXform(), !attachedBefore);
+                    attachedBefore = true;
+                    waiting = false;
+                } else {
+                    if (!waiting) {
+                        std::cout << "Waiting for render server " << self->mStreamAttach << std::endl;
+                        waiting = true;
+                    }
+                    nextAttachTime = util::getSeconds() + STREAM_ATTACH_RETRY_INTERVAL;
+                }
+            }
+            usleep(5000);
+        }
+    } catch (...) {
+        self->mException = std::current_exception();
+        if (self->mRenderGui) {
+            self->mRenderGui->close();
+        }
+    }
+
+    return nullptr;
+}
+
+void
+RaasGuiApplication::runStreamServer()
+{
+    moonray::rndr::initGlobalDriver(mOptions);
+    logInitMessages();
+
+    try {
+        std::unique_ptr<moonray::rndr::RenderContext> renderContext(
+            new moonray::rndr::RenderContext(mOptions, &mInitMessages));
+        constexpr auto loggingConfig = moonray::rndr::RenderContext::LoggingConfiguration::ATHENA_DISABLED;
+        renderContext->initialize(mInitMessages, loggingConfig);
+
+        // Viewers move the camera, keeping any motion blur the scene gives it
+        // by applying the same offset to the end of the shutter interval.
+        rdl2::Camera *camera = const_cast<rdl2::Camera *>(renderContext->getCamera());
+        MNRY_ASSERT(camera);
+        scene_rdl2::math::Mat4f cameraXform = toFloat(camera->get(rdl2::Node::sNodeXformKey, rdl2::TIMESTEP_BEGIN));
+        const scene_rdl2::math::Mat4f c12w = toFloat(camera->get(rdl2::Node::sNodeXformKey, rdl2::TIMESTEP_END));
+        const scene_rdl2::math::Mat4f c12c0 = c12w * cameraXform.inverse();
+
+        const scene_rdl2::math::HalfOpenViewport region = renderContext->getRezedRegionWindow();
+        FrameStreamServer server;
+        if (!server.open(mStreamServer, unsigned(region.width()), unsigned(region.height()), cameraXform)) {
+            throw std::runtime_error("Unable to start render server " + mStreamServer);
+        }
+
+        sStreamServerStop = 0;
+        std::signal(SIGINT, stopStreamServer);
+        std::signal(SIGTERM, stopStreamServer);
+
+        moonray::rndr::RenderMode renderMode = moonray::rndr::RenderMode::PROGRESSIVE;
+        moonray::rndr::FastRenderMode fastMode = moonray::rndr::FastRenderMode::NORMALS;
+        scene_rdl2::fb_util::RenderBuffer frame;
+        std::vector<FrameStreamCommand> commands;
+        bool restart = true;
+        bool resend = false;
+        double nextPublishTime = 0.0;
+
+        while (!sStreamServerStop) {
+            commands.clear();
+            server.receiveCommands(&commands);
+            for (const FrameStreamCommand &command : commands) {
+                switch (command.mType) {
+                case FrameStreamCommand::CAMERA: {
+                    scene_rdl2::math::Mat4f xform;
+                    std::memcpy(&xform.vx.x, command.mXform, sizeof(command.mXform));
+                    if (!scene_rdl2::math::isEqual(xform, cameraXform)) {
+                        cameraXform = xform;
+                        restart = true;
+                    }
+                    break;
+                }
+                case FrameStreamCommand::RENDER_MODE: {
+                    const moonray::rndr::RenderMode mode = command.mFastProgressive ?
+                        moonray::rndr::RenderMode::PROGRESSIVE_FAST : moonray::rndr::RenderMode::PROGRESSIVE;
+                    const auto fast = moonray::rndr::FastRenderMode(command.mFastMode);
+                    if (mode != renderMode || fast != fastMode) {
+                        renderMode = mode;
+                        fastMode = fast;
+                        restart = true;
+                    }
+                    break;
+                }
+                case FrameStreamCommand::RESEND:
+                    resend = true;
+                    break;
+                }
+            }
+
+            if (restart) {
+                if (renderContext->isFrameRendering()) {
+                    renderContext->stopFrame();
+                }
+                camera->beginUpdate();
+                camera->set(rdl2::Node::sNodeXformKey, toDouble(cameraXform), rdl2::TIMESTEP_BEGIN);
+                camera->set(rdl2::Node::sNodeXformKey, toDouble(c12c0 * cameraXform), rdl2::TIMESTEP_END);
+                camera->endUpdate();
+                renderContext->setSceneUpdated();
+                renderContext->setRenderMode(renderMode);
+                renderContext->setFastRenderMode(fastMode);
+                renderContext->startFrame();
+                mNextLogProgressTime = 0.0;
+                mNextLogProgressPercentage = 0.0;
+                restart = false;
+            }
+
+            const double currentTime = util::getSeconds();
+            if (renderContext->isFrameRendering() && renderContext->isFrameReadyForDisplay()) {
+                const bool frameComplete = renderContext->isFrameComplete();
+                if (frameComplete || resend || currentTime >= nextPublishTime) {
+                    // Snapshot serially while the render threads are busy.
+                    printStatusLine(*renderContext, renderContext->getLastFrameMcrtStartTime(), frameComplete);
+                    if (frameComplete) {
+                        renderContext->stopFrame();
+                    }
+                    renderContext->snapshotRenderBuffer(&frame, /*untile*/ true, /*parallel*/ frameComplete);
+                    server.publish(frame);
+                    resend = false;
+                    nextPublishTime = currentTime + STREAM_PUBLISH_INTERVAL;
+                }
+            } else if (resend && frame.getWidth() > 0) {
+                // A viewer attached after the frame completed.
+                server.publish(frame);
+                resend = false;
+            }
+
+            usleep(5000);
+        }
+
+        std::cout << "Stopping render server " << mStreamServer << std::endl;
+        if (renderContext->isFrameRendering()) {
+            renderContext->stopFrame();
+        }
+    } catch (...) {
+        moonray::rndr::cleanUpGlobalDriver();
+        throw;
+    }
+
+    moonray::rndr::cleanUpGlobalDriver();
+}
+
 void
 RaasGuiApplication::run()
 {
+    if (!mStreamServer.empty()) {
+        runStreamServer();
+        return;
+    }
+
     // Fire up the Qt app and display the main window.
     QApplication app(mArgc, mArgv);
 
@@ -452,10 +777,33 @@ RaasGuiApplication::run()
     RenderGui renderGui(mInitialCamType, mOptions.getTileProgress(),
                         mOptions.getApplyColorRenderTransform(),
                         lut.empty() ? nullptr : lut.c_str(), snapPath);
+    renderGui.setTargetFrameTime(mTargetFrameTime);
+    renderGui.setBufferIdleTime(mBufferIdleTime);
+    if (mPickBuffer) {
+        renderGui.enablePickBuffer(mPickGeometryIdOutput, mPickMaterialIdOutput);
+    }
+    if (!mReplaySession.empty()) {
+        if (!renderGui.replaySession(mReplaySession)) {
+            throw std::runtime_error("Unable to replay session " + mReplaySession);
+        }
+    } else if (!mRecordSession.empty() && !renderGui.recordSession(mRecordSession)) {
+        throw std::runtime_error("Unable to record session " + mRecordSession);
+    }
+    if (!mConvergenceReference.empty() &&
+        !renderGui.runConvergenceBenchmark(mConvergenceReference, mConvergenceOutput, mConvergenceDuration)) {
+        throw std::runtime_error("Unable to read convergence reference " + mConvergenceReference);
+    }
+    if (!mFrameServer.empty() && !renderGui.enableFrameServer(mFrameServer)) {
+        throw std::runtime_error("Unable to start frame server " + mFrameServer);
+    }
     mRenderGui = &renderGui;
 
-    // Spin off a thread for rendering.
-    int retVal = pthread_create(&mRenderThread, nullptr, RaasGuiApplication::startRenderThread, this);
+    // Spin off a thread for rendering, or for displaying what a render
+    // server renders.
+    int retVal = pthread_create(&mRenderThread, nullptr,
+                                mStreamAttach.empty() ? RaasGuiApplication::startRenderThread :
+                                                        RaasGuiApplication::startStreamViewerThread,
+                                this);
     MNRY_ASSERT_REQUIRE(retVal == 0, "Failed to create render thread.");
 
     app.exec();